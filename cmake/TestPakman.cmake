@@ -19,6 +19,8 @@ function (get_base_command _command
     # Append command based on master type
     if (master MATCHES "Serial")
         string (APPEND command "${executable} serial ")
+    elseif (master MATCHES "Local")
+        string (APPEND command "${executable} local ")
     elseif (master MATCHES "MPI")
         string (APPEND command "${MPIEXEC_EXECUTABLE} \
         ${MPIEXEC_NUMPROC_FLAG} \
@@ -36,9 +38,76 @@ function (get_base_command _command
         string (APPEND command "smc ")
     endif ()
 
+    # Append number of jobs if master is local
+    if (master MATCHES "Local")
+        string (APPEND command "--jobs=4 ")
+    endif ()
+
+    # Append blocking wait flag if master is blocking
+    if (master MATCHES "Blocking")
+        string (APPEND command "--blocking-wait ")
+    endif ()
+
+    # Append maximum batch size if master is batching
+    if (master MATCHES "Batch")
+        string (APPEND command "--max-batch-size=4 ")
+    endif ()
+
+    # Append prefetch depth if master is prefetching
+    if (master MATCHES "Prefetch")
+        string (APPEND command "--prefetch-depth=2 ")
+    endif ()
+
+    # Append unordered flag if master is unordered
+    if (master MATCHES "Unordered")
+        string (APPEND command "--unordered ")
+    endif ()
+
+    # Append distributed proposals flag if master distributes proposals
+    if (master MATCHES "Distributed")
+        string (APPEND command "--distribute-proposals ")
+    endif ()
+
+    # Append fork server flag if master uses a fork server
+    if (master MATCHES "ForkServer")
+        string (APPEND command "--fork-server ")
+    endif ()
+
+    # Append number of Worker processes if master spawns Worker groups
+    if (master MATCHES "Group")
+        string (APPEND command "--worker-procs=2 ")
+    endif ()
+
+    # Append spawn at startup flag if master spawns Workers at startup
+    if (master MATCHES "Startup")
+        string (APPEND command "--spawn-at-startup ")
+    endif ()
+
+    # Append number of Workers per Manager if master has Worker slots
+    if (master MATCHES "Slots")
+        string (APPEND command "--workers-per-manager=3 ")
+    endif ()
+
+    # Append sub-masters flag if master is hierarchical
+    if (master MATCHES "Hierarchical")
+        string (APPEND command "--sub-masters ")
+    endif ()
+
+    # Append work stealing flag if master uses work stealing
+    if (master MATCHES "Stealing")
+        string (APPEND command "--work-stealing ")
+    endif ()
+
+    # Append Worker prefetch window if master pipelines MPI Workers
+    if (master MATCHES "Pipeline")
+        string (APPEND command "--worker-prefetch=2 ")
+    endif ()
+
     # Append command based on simulator type
     if (simulator MATCHES "MPI")
         string (APPEND command "--mpi-simulator ")
+    elseif (simulator MATCHES "Persistent")
+        string (APPEND command "--persistent-simulator ")
     endif ()
 
     # Append command based on force_host_spawn
@@ -109,10 +178,27 @@ function (get_sweep_options _options
     string (APPEND options "--simulator=\"")
 
     if (simulator MATCHES "Standard")
+        if (postfix MATCHES "LargeOutput")
+            string (APPEND options
+                "${PROJECT_BINARY_DIR}/tests/standard-simulator/large-output-simulator ")
+        else ()
+            string (APPEND options
+                "${PROJECT_BINARY_DIR}/tests/standard-simulator/standard-simulator ")
+        endif ()
+    elseif (simulator MATCHES "Persistent")
         string (APPEND options
-            "${PROJECT_BINARY_DIR}/tests/standard-simulator/standard-simulator ")
+            "${PROJECT_BINARY_DIR}/tests/persistent-simulator/persistent-simulator ")
+    elseif (simulator MATCHES "Plugin")
+        string (APPEND options
+            "${PROJECT_BINARY_DIR}/tests/plugin-simulator/plugin-simulator.so ")
     elseif (simulator MATCHES "MPI")
-        if (postfix MATCHES "Cpp")
+        if (postfix MATCHES "DoubleCpp")
+            string (APPEND options
+                "${PROJECT_BINARY_DIR}/tests/mpi-simulator/mpi-simulator-double-cpp ")
+        elseif (postfix MATCHES "Double")
+            string (APPEND options
+                "${PROJECT_BINARY_DIR}/tests/mpi-simulator/mpi-simulator-double ")
+        elseif (postfix MATCHES "Cpp")
             string (APPEND options
                 "${PROJECT_BINARY_DIR}/tests/mpi-simulator/mpi-simulator-cpp ")
         else ()
@@ -211,8 +297,13 @@ function (get_rejection_options _options
     # Append options with parameter_names
     string (APPEND options "--parameter-names=\"${parameter_names}\" ")
 
-    # Append options with prior sampler
-    string (APPEND options "--prior-sampler=\"echo ${sampled_parameter}\" ")
+    # Append options with prior sampler, which is a plugin too if the
+    # simulator is a plugin
+    if (simulator MATCHES "Plugin")
+        string (APPEND options "--prior-sampler=\"${PROJECT_BINARY_DIR}/tests/plugin-simulator/plugin-simulator.so ${sampled_parameter}\" ")
+    else ()
+        string (APPEND options "--prior-sampler=\"echo ${sampled_parameter}\" ")
+    endif ()
 
     # Append options with number of parameters
     string (APPEND options "--number-accept=${number_of_parameters} ")
@@ -226,6 +317,12 @@ function (get_rejection_options _options
     if (simulator MATCHES "Standard")
         string (APPEND options
             "${PROJECT_BINARY_DIR}/tests/standard-simulator/standard-simulator ")
+    elseif (simulator MATCHES "Persistent")
+        string (APPEND options
+            "${PROJECT_BINARY_DIR}/tests/persistent-simulator/persistent-simulator ")
+    elseif (simulator MATCHES "Plugin")
+        string (APPEND options
+            "${PROJECT_BINARY_DIR}/tests/plugin-simulator/plugin-simulator.so ")
     elseif (simulator MATCHES "MPI")
         if (postfix MATCHES "Cpp")
             string (APPEND options
@@ -339,14 +436,23 @@ function (get_smc_options _options
     # Append options with parameter_names
     string (APPEND options "--parameter-names=\"${parameter_names}\" ")
 
-    # Append options with prior sampler
-    string (APPEND options "--prior-sampler=\"echo ${sampled_parameter}\" ")
-
-    # Append options with perturber
-    string (APPEND options "--perturber=\"bash -c 'cat > /dev/null && echo 1'\" ")
+    # Append options with prior sampler, which is a plugin too if the
+    # simulator is a plugin
+    if (simulator MATCHES "Plugin")
+        string (APPEND options "--prior-sampler=\"${PROJECT_BINARY_DIR}/tests/plugin-simulator/plugin-simulator.so ${sampled_parameter}\" ")
+    else ()
+        string (APPEND options "--prior-sampler=\"echo ${sampled_parameter}\" ")
+    endif ()
 
-    # Append options with prior pdf
-    string (APPEND options "--prior-pdf=\"bash -c 'cat > /dev/null && echo 1'\" ")
+    # Append options with perturber and prior pdf, which are plugins too if
+    # the simulator is a plugin
+    if (simulator MATCHES "Plugin")
+        string (APPEND options "--perturber=\"${PROJECT_BINARY_DIR}/tests/plugin-simulator/plugin-simulator.so 1\" ")
+        string (APPEND options "--prior-pdf=\"${PROJECT_BINARY_DIR}/tests/plugin-simulator/plugin-simulator.so 1\" ")
+    else ()
+        string (APPEND options "--perturber=\"bash -c 'cat > /dev/null && echo 1'\" ")
+        string (APPEND options "--prior-pdf=\"bash -c 'cat > /dev/null && echo 1'\" ")
+    endif ()
 
     # Append options with perturbation pdf
     string (APPEND options "--perturbation-pdf=\"bash -c 'read t && read new_p && cat'\" ")
@@ -363,6 +469,12 @@ function (get_smc_options _options
     if (simulator MATCHES "Standard")
         string (APPEND options
             "${PROJECT_BINARY_DIR}/tests/standard-simulator/standard-simulator ")
+    elseif (simulator MATCHES "Persistent")
+        string (APPEND options
+            "${PROJECT_BINARY_DIR}/tests/persistent-simulator/persistent-simulator ")
+    elseif (simulator MATCHES "Plugin")
+        string (APPEND options
+            "${PROJECT_BINARY_DIR}/tests/plugin-simulator/plugin-simulator.so ")
     elseif (simulator MATCHES "MPI")
         if (postfix MATCHES "Cpp")
             string (APPEND options
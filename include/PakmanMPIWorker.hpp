@@ -3,6 +3,8 @@
 
 #include <iostream>
 #include <string>
+#include <deque>
+#include <vector>
 #include <functional>
 #include <mpi.h>
 
@@ -24,6 +26,36 @@
  * Note that `MPI_Init()` should be called before calling run().  Also, after
  * run() returns, `MPI_Finalize()` should be called.
  *
+ * If Pakman spawns every MPI Worker as a group of several processes (see the
+ * option `--worker-procs`), run() must be called on every process of the
+ * group.  The leader of the group receives every simulation task from Pakman
+ * and broadcasts it to the rest of the group, so that the simulator function
+ * is called collectively on all processes of the group.  The output string
+ * and error code of the leader are sent back to Pakman.  Within the simulator
+ * function, the processes of the group can communicate through the
+ * communicator returned by getWorkerComm().
+ *
+ * When Pakman no longer needs the result of a simulation, for example at the
+ * end of a generation of the ABC-SMC algorithm, it asks the MPI Worker to
+ * cancel the simulation.  Long-running simulator functions should call
+ * shouldCancel() regularly and return early when it returns true.  The output
+ * string and error code of a cancelled simulation are discarded.
+ *
+ * Pakman may send the input of the next simulations while the current
+ * simulation is still running (see the option `--worker-prefetch`).  These
+ * inputs are queued by the MPI Worker and simulated one after the other.  The
+ * output string and error code of every simulation are sent back to Pakman in
+ * a single message.
+ *
+ * Simulators whose output is an array of numbers, such as summary statistics
+ * or a time series, can instead output a `std::vector<double>`.  The output
+ * array is then sent to Pakman as binary `MPI_DOUBLE` data with an explicit
+ * length, which avoids formatting and parsing decimal text.  Pakman receives
+ * the output as the raw bytes of the array of doubles in the native
+ * representation of the Pakman process.  Binary outputs are only supported
+ * by the sweep controller, which can write them to a file with
+ * `--simulator-outputs`.
+ *
  * For more information, see
  * @ref mpi-simulator "Implementing an MPI simulator".
  */
@@ -48,6 +80,23 @@ class PakmanMPIWorker
                     std::string& input_string, std::string& output_string)>
                 simulator);
 
+        /** Constructor from simulator function that outputs an array of
+         * doubles.
+         *
+         * The simulator function must accept four arguments;
+         * - **argc**  number of command-line arguments.
+         * - **argv**  array of command-line arguments.
+         * - **input_string**  input to simulator.
+         * - **output**  output array from simulator.
+         *
+         * In addition, the simulator function must return an error code.
+         *
+         * @param simulator  simulator function
+         */
+        PakmanMPIWorker(std::function<int(int argc, char** argv, const
+                    std::string& input_string, std::vector<double>& output)>
+                simulator);
+
         /** Default destructor does nothing. */
         ~PakmanMPIWorker() = default;
 
@@ -66,38 +115,122 @@ class PakmanMPIWorker
         /** Exit code indicating Worker encountered an error. */
         static constexpr int PAKMAN_EXIT_FAILURE = 1;
 
+        /** @return communicator of the processes of this MPI Worker.
+         *
+         * This communicator is only valid while run() is running, and
+         * should be used instead of `MPI_COMM_WORLD`, since MPI Workers
+         * that are spawned together may share `MPI_COMM_WORLD`.
+         */
+        static MPI_Comm getWorkerComm();
+
+        /** @return whether Pakman has cancelled the current simulation.
+         *
+         * This function does not block.  In MPI Workers consisting of
+         * several processes, it is collective over getWorkerComm() and must
+         * be called by all processes of the group.
+         */
+        static bool shouldCancel();
+
     private:
 
+        // Reference to pointer to running MPI Worker
+        static PakmanMPIWorker*& currentWorker();
+
+        // Check for cancel signal from Pakman Manager
+        bool pollCancel();
+
+        // Handle message from Pakman Manager with given tag
+        void handleMessage(int tag);
+
+        // Handle all messages from Pakman Manager that have arrived
+        void pollMessages();
+
+        // Reply to queued input strings with empty results and discard them
+        void dropInputs();
+
         // Get parent communicator
         static MPI_Comm getParentComm();
 
+        // Get application number of MPI process, which is the rank of the
+        // Pakman Manager that this MPI Worker belongs to
+        static int getAppNum();
+
+        // Reference to communicator of MPI Worker group
+        static MPI_Comm& workerComm();
+
+        // Receive next task from Pakman Manager
+        int receiveTask(std::string& input_string);
+
+        // Broadcast task from leader to rest of MPI Worker group
+        static void broadcastTask(int& task, std::string& input_string);
+
         // Receive message from Pakman Manager
         std::string receiveMessage();
 
         // Receive signal from Pakman Manager
         int receiveSignal();
 
-        // Send message to Pakman Manager
-        void sendMessage(const std::string& message_string);
+        // Send payload of given type and error code to Pakman Manager
+        void sendPayload(int error_code, int payload_type,
+                const void *payload, int length);
+
+        // Send output string and error code to Pakman Manager
+        void sendResult(const std::string& output_string, int error_code);
 
-        // Send error code to Pakman Manager
-        void sendErrorCode(int error_code);
+        // Send output array and error code to Pakman Manager
+        void sendResult(const std::vector<double>& output, int error_code);
 
         // Parent communicator
         MPI_Comm m_parent_comm = MPI_COMM_NULL;
 
+        // Rank of Pakman Manager in parent communicator
+        int m_manager_rank = PAKMAN_ROOT;
+
+        // Whether this process is the leader of the MPI Worker group
+        bool m_is_leader = true;
+
+        // Flag for cancellation of current simulation
+        bool m_cancelled = false;
+
+        // Input strings received from Pakman Manager but not yet simulated
+        std::deque<std::string> m_input_queue;
+
+        // Task to perform when the input queue is empty
+        int m_pending_task = PAKMAN_SIMULATE_TASK;
+
+        // Buffer for packed results, which is reused across results
+        std::string m_send_buffer;
+
         // Simulator function
         std::function<int(int argc, char** argv, const std::string&
                 input_string, std::string& output_string)> m_simulator;
 
+        // Simulator function with array output (empty if m_simulator is set)
+        std::function<int(int argc, char** argv, const std::string&
+                input_string, std::vector<double>& output)>
+            m_double_simulator;
+
         // Parent communication constants
         static constexpr int PAKMAN_ROOT                    = 0;
         static constexpr int PAKMAN_MANAGER_MSG_TAG         = 2;
         static constexpr int PAKMAN_MANAGER_SIGNAL_TAG      = 3;
-        static constexpr int PAKMAN_WORKER_MSG_TAG          = 5;
-        static constexpr int PAKMAN_WORKER_ERROR_CODE_TAG   = 6;
+        static constexpr int PAKMAN_WORKER_RESULT_TAG       = 7;
 
         static constexpr int PAKMAN_TERMINATE_WORKER_SIGNAL = 0;
+        static constexpr int PAKMAN_CANCEL_WORKER_SIGNAL    = 1;
+
+        // Tasks broadcast within MPI Worker group
+        static constexpr int PAKMAN_LEADER                  = 0;
+        static constexpr int PAKMAN_TERMINATE_TASK          = 0;
+        static constexpr int PAKMAN_SIMULATE_TASK           = 1;
+        static constexpr int PAKMAN_FAILURE_TASK            = 2;
+
+        // Error code of input strings dropped after a cancel signal
+        static constexpr int PAKMAN_DROPPED_ERROR_CODE      = 1;
+
+        // Types of result payloads
+        static constexpr int PAKMAN_TEXT_PAYLOAD            = 0;
+        static constexpr int PAKMAN_DOUBLE_PAYLOAD          = 1;
 };
 
 // Constructor
@@ -108,6 +241,14 @@ PakmanMPIWorker::PakmanMPIWorker(
 {
 }
 
+// Constructor from simulator with array output
+PakmanMPIWorker::PakmanMPIWorker(
+    std::function<int(int argc, char** argv, const std::string& input_string,
+        std::vector<double>& output)> simulator)
+: m_double_simulator(simulator)
+{
+}
+
 int PakmanMPIWorker::run(int argc, char*argv[])
 {
     // Get parent communicator
@@ -121,67 +262,62 @@ int PakmanMPIWorker::run(int argc, char*argv[])
         return PAKMAN_EXIT_FAILURE;
     }
 
+    // MPI Workers that are spawned together share MPI_COMM_WORLD, so split
+    // it by application number into one communicator per MPI Worker
+    m_manager_rank = getAppNum();
+    MPI_Comm_split(MPI_COMM_WORLD, m_manager_rank, 0, &workerComm());
+
+    int worker_rank = 0;
+    MPI_Comm_rank(workerComm(), &worker_rank);
+    m_is_leader = (worker_rank == PAKMAN_LEADER);
+
+    // Make this MPI Worker available to shouldCancel()
+    currentWorker() = this;
+
     // Start loop
-    bool continue_loop = true;
-    while (continue_loop)
+    while (true)
     {
-        // Probe for message
-        MPI_Status status;
-        MPI_Probe(PAKMAN_ROOT, MPI_ANY_TAG, m_parent_comm, &status);
+        // Leader receives task from Pakman Manager and broadcasts it to the
+        // rest of the MPI Worker group
+        int task = PAKMAN_TERMINATE_TASK;
+        std::string input_string;
+        if (m_is_leader)
+            task = receiveTask(input_string);
 
-        // Check tag
-        switch (status.MPI_TAG)
-        {
-            case PAKMAN_MANAGER_MSG_TAG:
-                {
-                // Receive message
-                std::string input_string = receiveMessage();
+        broadcastTask(task, input_string);
 
-                // Run simulation
-                std::string output_string;
-                int error_code = m_simulator(argc, argv, input_string,
-                        output_string);
+        if (task == PAKMAN_TERMINATE_TASK)
+            break;
 
-                // Send output
-                sendMessage(output_string);
+        if (task == PAKMAN_FAILURE_TASK)
+            return PAKMAN_EXIT_FAILURE;
 
-                // Send error code
-                sendErrorCode(error_code);
+        // Run simulation and let leader send output and error code
+        m_cancelled = false;
+        if (m_simulator)
+        {
+            std::string output_string;
+            int error_code = m_simulator(argc, argv, input_string,
+                    output_string);
 
-                break;
-                }
-            case PAKMAN_MANAGER_SIGNAL_TAG:
-                {
-                // Receive signal
-                int signal = receiveSignal();
-
-                // Check signal
-                switch (signal)
-                {
-                    case PAKMAN_TERMINATE_WORKER_SIGNAL:
-                        {
-                        // Set loop condition to false
-                        continue_loop = false;
-                        break;
-                        }
-                    default:
-                        {
-                        std::cerr << "Pakman Worker error: signal not recognised, "
-                                "exiting...\n";
-                        return PAKMAN_EXIT_FAILURE;
-                        }
-                }
-                break;
-                }
-            default:
-                {
-                    std::cerr << "Pakman Worker error: "
-                        "tag not recognised, exiting...\n";
-                return PAKMAN_EXIT_FAILURE;
-                }
+            if (m_is_leader)
+                sendResult(output_string, error_code);
+        }
+        else
+        {
+            std::vector<double> output;
+            int error_code = m_double_simulator(argc, argv, input_string,
+                    output);
+
+            if (m_is_leader)
+                sendResult(output, error_code);
         }
     }
 
+    // Free communicator of MPI Worker group
+    MPI_Comm_free(&workerComm());
+    currentWorker() = nullptr;
+
     // Disconnect parent communicator
     MPI_Comm_disconnect(&m_parent_comm);
 
@@ -189,6 +325,43 @@ int PakmanMPIWorker::run(int argc, char*argv[])
     return PAKMAN_EXIT_SUCCESS;
 }
 
+// Get communicator of MPI Worker group
+MPI_Comm PakmanMPIWorker::getWorkerComm()
+{
+    return workerComm();
+}
+
+// Check whether current simulation has been cancelled
+bool PakmanMPIWorker::shouldCancel()
+{
+    PakmanMPIWorker *p_worker = currentWorker();
+    return p_worker ? p_worker->pollCancel() : false;
+}
+
+// Reference to pointer to running MPI Worker
+PakmanMPIWorker*& PakmanMPIWorker::currentWorker()
+{
+    static PakmanMPIWorker *p_worker = nullptr;
+    return p_worker;
+}
+
+// Check for cancel signal from Pakman Manager
+bool PakmanMPIWorker::pollCancel()
+{
+    // Leader handles messages that have arrived.  Input strings are queued,
+    // and a cancel signal sets m_cancelled
+    if (!m_cancelled && m_is_leader)
+        pollMessages();
+
+    int cancelled = m_cancelled;
+
+    // Share result with rest of MPI Worker group
+    MPI_Bcast(&cancelled, 1, MPI_INT, PAKMAN_LEADER, workerComm());
+
+    m_cancelled = cancelled;
+    return m_cancelled;
+}
+
 // Get parent communicator
 MPI_Comm PakmanMPIWorker::getParentComm()
 {
@@ -198,23 +371,161 @@ MPI_Comm PakmanMPIWorker::getParentComm()
     return parent_comm;
 }
 
+// Get application number
+int PakmanMPIWorker::getAppNum()
+{
+    int *p_appnum = nullptr;
+    int flag = 0;
+    MPI_Comm_get_attr(MPI_COMM_WORLD, MPI_APPNUM, &p_appnum, &flag);
+
+    return flag ? *p_appnum : 0;
+}
+
+// Reference to communicator of MPI Worker group
+MPI_Comm& PakmanMPIWorker::workerComm()
+{
+    static MPI_Comm worker_comm = MPI_COMM_NULL;
+    return worker_comm;
+}
+
+// Handle message from Pakman Manager with given tag
+void PakmanMPIWorker::handleMessage(int tag)
+{
+    // Check tag
+    switch (tag)
+    {
+        case PAKMAN_MANAGER_MSG_TAG:
+            {
+            // Queue input string
+            m_input_queue.push_back(receiveMessage());
+            break;
+            }
+        case PAKMAN_MANAGER_SIGNAL_TAG:
+            {
+            // Receive signal
+            int signal = receiveSignal();
+
+            // Check signal
+            if (signal == PAKMAN_TERMINATE_WORKER_SIGNAL)
+            {
+                m_pending_task = PAKMAN_TERMINATE_TASK;
+                break;
+            }
+
+            // A cancel signal applies to the running simulation, if any, and
+            // to all input strings received before it
+            if (signal == PAKMAN_CANCEL_WORKER_SIGNAL)
+            {
+                m_cancelled = true;
+                dropInputs();
+                break;
+            }
+
+            std::cerr << "Pakman Worker error: signal not recognised, "
+                    "exiting...\n";
+            m_pending_task = PAKMAN_FAILURE_TASK;
+            break;
+            }
+        default:
+            {
+            std::cerr << "Pakman Worker error: "
+                "tag not recognised, exiting...\n";
+            m_pending_task = PAKMAN_FAILURE_TASK;
+            break;
+            }
+    }
+}
+
+// Handle all messages from Pakman Manager that have arrived, in the order in
+// which they were sent
+void PakmanMPIWorker::pollMessages()
+{
+    while (m_pending_task != PAKMAN_FAILURE_TASK)
+    {
+        int flag = 0;
+        MPI_Status status;
+        MPI_Iprobe(m_manager_rank, MPI_ANY_TAG, m_parent_comm, &flag,
+                &status);
+
+        if (!flag)
+            break;
+
+        handleMessage(status.MPI_TAG);
+    }
+}
+
+// Reply to queued input strings with empty results and discard them, since
+// Pakman expects exactly one result for every input string
+void PakmanMPIWorker::dropInputs()
+{
+    for (size_t i = 0; i < m_input_queue.size(); i++)
+        sendResult(std::string(), PAKMAN_DROPPED_ERROR_CODE);
+
+    m_input_queue.clear();
+}
+
+// Receive next task from Pakman Manager
+int PakmanMPIWorker::receiveTask(std::string& input_string)
+{
+    while (true)
+    {
+        // Handle messages that have arrived
+        pollMessages();
+
+        if (m_pending_task == PAKMAN_FAILURE_TASK)
+            return PAKMAN_FAILURE_TASK;
+
+        // Simulate queued input strings first
+        if (!m_input_queue.empty())
+        {
+            input_string = m_input_queue.front();
+            m_input_queue.pop_front();
+            return PAKMAN_SIMULATE_TASK;
+        }
+
+        if (m_pending_task == PAKMAN_TERMINATE_TASK)
+            return PAKMAN_TERMINATE_TASK;
+
+        // Wait for next message
+        MPI_Probe(m_manager_rank, MPI_ANY_TAG, m_parent_comm,
+                MPI_STATUS_IGNORE);
+    }
+}
+
+// Broadcast task from leader to rest of MPI Worker group
+void PakmanMPIWorker::broadcastTask(int& task, std::string& input_string)
+{
+    MPI_Bcast(&task, 1, MPI_INT, PAKMAN_LEADER, workerComm());
+
+    if (task != PAKMAN_SIMULATE_TASK)
+        return;
+
+    int count = input_string.size();
+    MPI_Bcast(&count, 1, MPI_INT, PAKMAN_LEADER, workerComm());
+
+    input_string.resize(count);
+    if (count > 0)
+        MPI_Bcast(&input_string[0], count, MPI_CHAR, PAKMAN_LEADER,
+                workerComm());
+}
+
 // Receive message from Pakman Manager
 std::string PakmanMPIWorker::receiveMessage()
 {
     // Probe to get status
     MPI_Status status;
-    MPI_Probe(PAKMAN_ROOT, PAKMAN_MANAGER_MSG_TAG, m_parent_comm, &status);
+    MPI_Probe(m_manager_rank, PAKMAN_MANAGER_MSG_TAG, m_parent_comm, &status);
 
-    // Receive string
+    // Receive string directly into message
     int count = 0;
     MPI_Get_count(&status, MPI_CHAR, &count);
-    char *buffer = new char[count];
-    MPI_Recv(buffer, count, MPI_CHAR, PAKMAN_ROOT, PAKMAN_MANAGER_MSG_TAG,
-            m_parent_comm, MPI_STATUS_IGNORE);
+    std::string message(count, '\0');
+    MPI_Recv(&message[0], count, MPI_CHAR, m_manager_rank,
+            PAKMAN_MANAGER_MSG_TAG, m_parent_comm, MPI_STATUS_IGNORE);
 
-    // Return string
-    std::string message(buffer);
-    delete[] buffer;
+    // Strip null-terminating character and return string
+    if (count > 0)
+        message.resize(count - 1);
     return message;
 }
 
@@ -223,27 +534,61 @@ int PakmanMPIWorker::receiveSignal()
 {
     // Receive signal
     int signal;
-    MPI_Recv(&signal, 1, MPI_INT, PAKMAN_ROOT, PAKMAN_MANAGER_SIGNAL_TAG,
+    MPI_Recv(&signal, 1, MPI_INT, m_manager_rank, PAKMAN_MANAGER_SIGNAL_TAG,
             m_parent_comm, MPI_STATUS_IGNORE);
 
     // Return signal
     return signal;
 }
 
-// Send message to Pakman Manager
-void PakmanMPIWorker::sendMessage(const std::string& message_string)
+// Send payload of given type and error code to Pakman Manager
+void PakmanMPIWorker::sendPayload(int error_code, int payload_type,
+        const void *payload, int length)
+{
+    MPI_Datatype datatype =
+        (payload_type == PAKMAN_DOUBLE_PAYLOAD) ? MPI_DOUBLE : MPI_CHAR;
+
+    // Grow buffer for packed result if necessary
+    int int_size = 0, payload_size = 0;
+    MPI_Pack_size(3, MPI_INT, m_parent_comm, &int_size);
+    MPI_Pack_size(length, datatype, m_parent_comm, &payload_size);
+    if (m_send_buffer.size() < static_cast<size_t>(int_size + payload_size))
+        m_send_buffer.resize(int_size + payload_size);
+
+    // Pack error code, payload type, number of elements of payload and
+    // payload
+    char *buffer = &m_send_buffer[0];
+    int buffer_size = m_send_buffer.size();
+    int position = 0;
+    MPI_Pack(&error_code, 1, MPI_INT, buffer, buffer_size, &position,
+            m_parent_comm);
+    MPI_Pack(&payload_type, 1, MPI_INT, buffer, buffer_size, &position,
+            m_parent_comm);
+    MPI_Pack(&length, 1, MPI_INT, buffer, buffer_size, &position,
+            m_parent_comm);
+    if (length > 0)
+        MPI_Pack(payload, length, datatype, buffer, buffer_size, &position,
+                m_parent_comm);
+
+    // Send result as a single message
+    MPI_Send(buffer, position, MPI_PACKED, m_manager_rank,
+            PAKMAN_WORKER_RESULT_TAG, m_parent_comm);
+}
+
+// Send output string and error code to Pakman Manager
+void PakmanMPIWorker::sendResult(const std::string& output_string,
+        int error_code)
 {
-    // Send message
-    MPI_Send(message_string.c_str(), message_string.size() + 1, MPI_CHAR,
-            PAKMAN_ROOT, PAKMAN_WORKER_MSG_TAG, m_parent_comm);
+    sendPayload(error_code, PAKMAN_TEXT_PAYLOAD, output_string.data(),
+            output_string.size());
 }
 
-// Send error code to Pakman Manager
-void PakmanMPIWorker::sendErrorCode(int error_code)
+// Send output array and error code to Pakman Manager
+void PakmanMPIWorker::sendResult(const std::vector<double>& output,
+        int error_code)
 {
-    // Send error code
-    MPI_Send(&error_code, 1, MPI_INT, PAKMAN_ROOT,
-            PAKMAN_WORKER_ERROR_CODE_TAG, m_parent_comm);
+    sendPayload(error_code, PAKMAN_DOUBLE_PAYLOAD, output.data(),
+            output.size());
 }
 
 #endif // PAKMANMPIWORKER_HPP
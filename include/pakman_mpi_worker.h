@@ -26,6 +26,36 @@
  * pakman_run_mpi_worker().  Also, after pakman_run_mpi_worker() returns,
  * `MPI_Finalize()` should be called.
  *
+ * If Pakman spawns every MPI Worker as a group of several processes (see the
+ * option `--worker-procs`), pakman_run_mpi_worker() must be called on every
+ * process of the group.  The leader of the group receives every simulation
+ * task from Pakman and broadcasts it to the rest of the group, so that the
+ * simulator function is called collectively on all processes of the group.
+ * The output string and error code of the leader are sent back to Pakman.
+ * Within the simulator function, the processes of the group can communicate
+ * through the communicator returned by pakman_get_worker_comm().
+ *
+ * When Pakman no longer needs the result of a simulation, for example at the
+ * end of a generation of the ABC-SMC algorithm, it asks the MPI Worker to
+ * cancel the simulation.  Long-running simulator functions should call
+ * pakman_should_cancel() regularly and return early when it returns true.
+ * The output and error code of a cancelled simulation are discarded.
+ *
+ * Pakman may send the input of the next simulations while the current
+ * simulation is still running (see the option `--worker-prefetch`).  These
+ * inputs are queued by the MPI Worker and simulated one after the other.  The
+ * output string and error code of every simulation are sent back to Pakman in
+ * a single message.
+ *
+ * Simulators whose output is an array of numbers, such as summary statistics
+ * or a time series, can be run with pakman_run_mpi_worker_double() instead.
+ * The output array is then sent to Pakman as binary `MPI_DOUBLE` data with
+ * an explicit length, which avoids formatting and parsing decimal text.
+ * Pakman receives the output as the raw bytes of the array of doubles in the
+ * native representation of the Pakman process.  Binary outputs are only
+ * supported by the sweep controller, which can write them to a file with
+ * `--simulator-outputs`.
+ *
  * For more information, see
  * @ref mpi-simulator "Implementing an MPI simulator".
  */
@@ -41,21 +71,89 @@
 #define PAKMAN_ROOT                     0
 #define PAKMAN_MANAGER_MSG_TAG          2
 #define PAKMAN_MANAGER_SIGNAL_TAG       3
-#define PAKMAN_WORKER_MSG_TAG           5
-#define PAKMAN_WORKER_ERROR_CODE_TAG    6
+#define PAKMAN_WORKER_RESULT_TAG        7
 
 #define PAKMAN_TERMINATE_WORKER_SIGNAL  0
+#define PAKMAN_CANCEL_WORKER_SIGNAL     1
+
+#define PAKMAN_LEADER                   0
+#define PAKMAN_TERMINATE_TASK           0
+#define PAKMAN_SIMULATE_TASK            1
+#define PAKMAN_FAILURE_TASK             2
+
+#define PAKMAN_DROPPED_ERROR_CODE       1
+
+#define PAKMAN_TEXT_PAYLOAD             0
+#define PAKMAN_DOUBLE_PAYLOAD           1
+
+/* Rank of Pakman Manager in parent communicator */
+int pakman_manager_rank = PAKMAN_ROOT;
+
+/* Communicator of MPI Worker group */
+MPI_Comm pakman_worker_comm = MPI_COMM_NULL;
+
+/* Parent communicator */
+MPI_Comm pakman_parent_comm = MPI_COMM_NULL;
+
+/* Flag for cancellation of current simulation */
+int pakman_task_cancelled = 0;
+
+/* Input strings received from Pakman Manager but not yet simulated */
+char **pakman_input_queue = NULL;
+int pakman_input_queue_length = 0;
+int pakman_input_queue_capacity = 0;
+
+/* Task to perform when the input queue is empty */
+int pakman_pending_task = PAKMAN_SIMULATE_TASK;
+
+/* Buffer for packed results, which is reused across results */
+char *pakman_send_buffer = NULL;
+int pakman_send_buffer_size = 0;
 
 MPI_Comm pakman_get_parent_comm();
+int pakman_get_appnum();
+
+void pakman_push_input(char *input_string);
+char* pakman_pop_input();
+void pakman_drop_inputs(MPI_Comm comm);
 
 char* pakman_receive_message(MPI_Comm comm);
 int pakman_receive_signal(MPI_Comm comm);
+void pakman_handle_message(MPI_Comm comm, int tag);
+void pakman_poll_messages(MPI_Comm comm);
+int pakman_receive_task(MPI_Comm comm, char **p_input_string);
+void pakman_broadcast_task(int *p_task, char **p_input_string);
 
-void pakman_send_message(MPI_Comm comm, const char *message);
-void pakman_send_error_code(MPI_Comm comm, int error_code);
+void pakman_send_payload(MPI_Comm comm, int error_code, int payload_type,
+        const void *payload, int length);
+void pakman_send_result(MPI_Comm comm, const char *output_string,
+        int error_code);
+
+int pakman_run_mpi_worker_generic(
+        int argc, char *argv[],
+        int (*text_simulator)(int argc, char *argv[],
+            const char *input_string, char **p_output_string),
+        int (*double_simulator)(int argc, char *argv[],
+            const char *input_string, double **p_output, int *p_length));
 
 #endif /* DOXYGEN_SHOULD_SKIP_THIS */
 
+/** @return communicator of the processes of this MPI Worker.
+ *
+ * This communicator is only valid while pakman_run_mpi_worker() is running,
+ * and should be used instead of `MPI_COMM_WORLD`, since MPI Workers that are
+ * spawned together may share `MPI_COMM_WORLD`.
+ */
+MPI_Comm pakman_get_worker_comm();
+
+/** @return whether Pakman has cancelled the current simulation.
+ *
+ * This function does not block.  In MPI Workers consisting of several
+ * processes, it is collective over pakman_get_worker_comm() and must be
+ * called by all processes of the group.
+ */
+int pakman_should_cancel();
+
 /** Run the Pakman MPI Worker with the given simulator function.
  *
  * The simulator function must accept four arguments;
@@ -81,6 +179,33 @@ int pakman_run_mpi_worker(
         int (*simulator)(int argc, char *argv[],
             const char *input_string, char **p_output_string));
 
+/** Run the Pakman MPI Worker with a simulator function that outputs an array
+ * of doubles.
+ *
+ * The simulator function must accept five arguments;
+ * - **argc**  number of command-line arguments.
+ * - **argv**  array of command-line arguments.
+ * - **input_string**  input to simulator.
+ * - **p_output**  pointer to output array from simulator.
+ * - **p_length**  pointer to number of elements of output array.
+ *
+ * The returned *p_output must have been allocated using `malloc()`, or be
+ * `NULL` if *p_length is zero.  After sending the contents of *p_output to
+ * Pakman, the MPI Worker will call `free()` on *p_output.
+ *
+ * In addition, the simulator function must return an error code.
+ *
+ * @param argc  number of command-line arguments.
+ * @param argv  array of command-line arguments.
+ * @param simulator  function pointer to simulator function.
+ *
+ * @return exit code.
+ */
+int pakman_run_mpi_worker_double(
+        int argc, char *argv[],
+        int (*simulator)(int argc, char *argv[],
+            const char *input_string, double **p_output, int *p_length));
+
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
 
 MPI_Comm pakman_get_parent_comm()
@@ -91,11 +216,56 @@ MPI_Comm pakman_get_parent_comm()
     return parent_comm;
 }
 
+int pakman_get_appnum()
+{
+    int *p_appnum = NULL;
+    int flag = 0;
+    MPI_Comm_get_attr(MPI_COMM_WORLD, MPI_APPNUM, &p_appnum, &flag);
+
+    return flag ? *p_appnum : 0;
+}
+
+void pakman_push_input(char *input_string)
+{
+    /* Grow queue if it is full */
+    if (pakman_input_queue_length == pakman_input_queue_capacity)
+    {
+        pakman_input_queue_capacity = 2 * pakman_input_queue_capacity + 1;
+        pakman_input_queue = (char **) realloc(pakman_input_queue,
+                pakman_input_queue_capacity * sizeof(char *));
+    }
+
+    pakman_input_queue[pakman_input_queue_length++] = input_string;
+}
+
+char* pakman_pop_input()
+{
+    assert(pakman_input_queue_length > 0);
+
+    char *input_string = pakman_input_queue[0];
+    pakman_input_queue_length--;
+    memmove(pakman_input_queue, pakman_input_queue + 1,
+            pakman_input_queue_length * sizeof(char *));
+
+    return input_string;
+}
+
+void pakman_drop_inputs(MPI_Comm comm)
+{
+    /* Pakman expects exactly one result for every input string */
+    while (pakman_input_queue_length > 0)
+    {
+        char *input_string = pakman_pop_input();
+        pakman_send_result(comm, "", PAKMAN_DROPPED_ERROR_CODE);
+        free(input_string);
+    }
+}
+
 char* pakman_receive_message(MPI_Comm comm)
 {
     /* Probe for message */
     MPI_Status status;
-    MPI_Probe(PAKMAN_ROOT, PAKMAN_MANAGER_MSG_TAG, comm, &status);
+    MPI_Probe(pakman_manager_rank, PAKMAN_MANAGER_MSG_TAG, comm, &status);
 
     /* Allocate buffer to receive message */
     int count;
@@ -103,8 +273,8 @@ char* pakman_receive_message(MPI_Comm comm)
     char *buffer = (char *) malloc(count * sizeof(char));
 
     /* Receive message */
-    MPI_Recv(buffer, count, MPI_CHAR, PAKMAN_ROOT, PAKMAN_MANAGER_MSG_TAG,
-            comm, MPI_STATUS_IGNORE);
+    MPI_Recv(buffer, count, MPI_CHAR, pakman_manager_rank,
+            PAKMAN_MANAGER_MSG_TAG, comm, MPI_STATUS_IGNORE);
 
     return buffer;
 }
@@ -115,35 +285,215 @@ int pakman_receive_signal(MPI_Comm comm)
     int signal;
 
     /* Receive message */
-    MPI_Recv(&signal, 1, MPI_INT, PAKMAN_ROOT, PAKMAN_MANAGER_SIGNAL_TAG,
-            comm, MPI_STATUS_IGNORE);
+    MPI_Recv(&signal, 1, MPI_INT, pakman_manager_rank,
+            PAKMAN_MANAGER_SIGNAL_TAG, comm, MPI_STATUS_IGNORE);
 
     return signal;
 }
 
-void pakman_send_message(MPI_Comm comm, const char *message)
+void pakman_handle_message(MPI_Comm comm, int tag)
 {
-    /* Count length of output_string, including null-terminating character */
-    size_t count = strlen(message) + 1;
+    /* Check tag */
+    switch (tag)
+    {
+        case PAKMAN_MANAGER_MSG_TAG:
+            {
+            /* Queue input string */
+            pakman_push_input(pakman_receive_message(comm));
+            break;
+            }
+        case PAKMAN_MANAGER_SIGNAL_TAG:
+            {
+            /* Receive signal */
+            int signal = pakman_receive_signal(comm);
+
+            /* Check signal */
+            if (signal == PAKMAN_TERMINATE_WORKER_SIGNAL)
+            {
+                pakman_pending_task = PAKMAN_TERMINATE_TASK;
+                break;
+            }
+
+            /* A cancel signal applies to the running simulation, if any,
+             * and to all input strings received before it */
+            if (signal == PAKMAN_CANCEL_WORKER_SIGNAL)
+            {
+                pakman_task_cancelled = 1;
+                pakman_drop_inputs(comm);
+                break;
+            }
+
+            fputs("Pakman Worker error: signal not recognised, "
+                    "exiting...\n", stderr);
+            pakman_pending_task = PAKMAN_FAILURE_TASK;
+            break;
+            }
+        default:
+            {
+            fputs("Pakman Worker error: tag not recognised, "
+                    "exiting...\n", stderr);
+            pakman_pending_task = PAKMAN_FAILURE_TASK;
+            break;
+            }
+    }
+}
 
-    /* Send message */
-    MPI_Send(message, count, MPI_CHAR, PAKMAN_ROOT, PAKMAN_WORKER_MSG_TAG,
-            comm);
+void pakman_poll_messages(MPI_Comm comm)
+{
+    /* Handle messages in the order in which they were sent */
+    while (pakman_pending_task != PAKMAN_FAILURE_TASK)
+    {
+        int flag = 0;
+        MPI_Status status;
+        MPI_Iprobe(pakman_manager_rank, MPI_ANY_TAG, comm, &flag, &status);
+
+        if (!flag)
+            break;
+
+        pakman_handle_message(comm, status.MPI_TAG);
+    }
 }
 
-void pakman_send_error_code(MPI_Comm comm, int error_code)
+int pakman_receive_task(MPI_Comm comm, char **p_input_string)
 {
-    /* Send error_code */
-    MPI_Send(&error_code, 1, MPI_INT, PAKMAN_ROOT,
-            PAKMAN_WORKER_ERROR_CODE_TAG, comm);
+    while (1)
+    {
+        /* Handle messages that have arrived */
+        pakman_poll_messages(comm);
+
+        if (pakman_pending_task == PAKMAN_FAILURE_TASK)
+            return PAKMAN_FAILURE_TASK;
+
+        /* Simulate queued input strings first */
+        if (pakman_input_queue_length > 0)
+        {
+            *p_input_string = pakman_pop_input();
+            return PAKMAN_SIMULATE_TASK;
+        }
+
+        if (pakman_pending_task == PAKMAN_TERMINATE_TASK)
+            return PAKMAN_TERMINATE_TASK;
+
+        /* Wait for next message */
+        MPI_Probe(pakman_manager_rank, MPI_ANY_TAG, comm, MPI_STATUS_IGNORE);
+    }
+}
+
+void pakman_broadcast_task(int *p_task, char **p_input_string)
+{
+    int worker_rank;
+    MPI_Comm_rank(pakman_worker_comm, &worker_rank);
+
+    MPI_Bcast(p_task, 1, MPI_INT, PAKMAN_LEADER, pakman_worker_comm);
+
+    if (*p_task != PAKMAN_SIMULATE_TASK)
+        return;
+
+    /* Broadcast input string, including null-terminating character */
+    int count = 0;
+    if (worker_rank == PAKMAN_LEADER)
+        count = strlen(*p_input_string) + 1;
+
+    MPI_Bcast(&count, 1, MPI_INT, PAKMAN_LEADER, pakman_worker_comm);
+
+    if (worker_rank != PAKMAN_LEADER)
+        *p_input_string = (char *) malloc(count * sizeof(char));
+
+    MPI_Bcast(*p_input_string, count, MPI_CHAR, PAKMAN_LEADER,
+            pakman_worker_comm);
+}
+
+void pakman_send_payload(MPI_Comm comm, int error_code, int payload_type,
+        const void *payload, int length)
+{
+    MPI_Datatype datatype =
+        (payload_type == PAKMAN_DOUBLE_PAYLOAD) ? MPI_DOUBLE : MPI_CHAR;
+
+    /* Grow buffer for packed result if necessary */
+    int int_size, payload_size;
+    MPI_Pack_size(3, MPI_INT, comm, &int_size);
+    MPI_Pack_size(length, datatype, comm, &payload_size);
+    if (pakman_send_buffer_size < int_size + payload_size)
+    {
+        pakman_send_buffer_size = int_size + payload_size;
+        pakman_send_buffer = (char *) realloc(pakman_send_buffer,
+                pakman_send_buffer_size * sizeof(char));
+    }
+
+    char *buffer = pakman_send_buffer;
+    int buffer_size = pakman_send_buffer_size;
+
+    /* Pack error code, payload type, number of elements of payload and
+     * payload */
+    int position = 0;
+    MPI_Pack(&error_code, 1, MPI_INT, buffer, buffer_size, &position, comm);
+    MPI_Pack(&payload_type, 1, MPI_INT, buffer, buffer_size, &position, comm);
+    MPI_Pack(&length, 1, MPI_INT, buffer, buffer_size, &position, comm);
+    if (length > 0)
+        MPI_Pack(payload, length, datatype, buffer, buffer_size, &position,
+                comm);
+
+    /* Send result as a single message */
+    MPI_Send(buffer, position, MPI_PACKED, pakman_manager_rank,
+            PAKMAN_WORKER_RESULT_TAG, comm);
+}
+
+void pakman_send_result(MPI_Comm comm, const char *output_string,
+        int error_code)
+{
+    /* Send output string, excluding null-terminating character */
+    pakman_send_payload(comm, error_code, PAKMAN_TEXT_PAYLOAD, output_string,
+            strlen(output_string));
 }
 
 #endif /* DOXYGEN_SHOULD_SKIP_THIS */
 
+MPI_Comm pakman_get_worker_comm()
+{
+    return pakman_worker_comm;
+}
+
+int pakman_should_cancel()
+{
+    int worker_rank;
+    MPI_Comm_rank(pakman_worker_comm, &worker_rank);
+
+    /* Leader handles messages that have arrived.  Input strings are queued,
+     * and a cancel signal sets pakman_task_cancelled */
+    if (!pakman_task_cancelled && worker_rank == PAKMAN_LEADER)
+        pakman_poll_messages(pakman_parent_comm);
+
+    /* Share result with rest of MPI Worker group */
+    MPI_Bcast(&pakman_task_cancelled, 1, MPI_INT, PAKMAN_LEADER,
+            pakman_worker_comm);
+
+    return pakman_task_cancelled;
+}
+
 int pakman_run_mpi_worker(
         int argc, char *argv[],
         int (*simulator)(int argc, char *argv[],
             const char *input_string, char **p_output_string))
+{
+    return pakman_run_mpi_worker_generic(argc, argv, simulator, NULL);
+}
+
+int pakman_run_mpi_worker_double(
+        int argc, char *argv[],
+        int (*simulator)(int argc, char *argv[],
+            const char *input_string, double **p_output, int *p_length))
+{
+    return pakman_run_mpi_worker_generic(argc, argv, NULL, simulator);
+}
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+
+int pakman_run_mpi_worker_generic(
+        int argc, char *argv[],
+        int (*text_simulator)(int argc, char *argv[],
+            const char *input_string, char **p_output_string),
+        int (*double_simulator)(int argc, char *argv[],
+            const char *input_string, double **p_output, int *p_length))
 {
     /* Get parent communicator */
     MPI_Comm parent_comm = pakman_get_parent_comm();
@@ -156,71 +506,75 @@ int pakman_run_mpi_worker(
         return PAKMAN_EXIT_FAILURE;
     }
 
+    pakman_parent_comm = parent_comm;
+
+    /* MPI Workers that are spawned together share MPI_COMM_WORLD, so split
+     * it by application number into one communicator per MPI Worker */
+    pakman_manager_rank = pakman_get_appnum();
+    MPI_Comm_split(MPI_COMM_WORLD, pakman_manager_rank, 0,
+            &pakman_worker_comm);
+
+    int worker_rank;
+    MPI_Comm_rank(pakman_worker_comm, &worker_rank);
+
     /* Start loop */
-    int continue_loop = 1;
-    while (continue_loop)
+    while (1)
     {
-        /* Probe for message */
-        MPI_Status status;
-        MPI_Probe(PAKMAN_ROOT, MPI_ANY_TAG, parent_comm, &status);
+        /* Leader receives task from Pakman Manager and broadcasts it to the
+         * rest of the MPI Worker group */
+        int task = PAKMAN_TERMINATE_TASK;
+        char *input_string = NULL;
+        if (worker_rank == PAKMAN_LEADER)
+            task = pakman_receive_task(parent_comm, &input_string);
 
-        /* Check tag */
-        switch (status.MPI_TAG)
-        {
-            case PAKMAN_MANAGER_MSG_TAG:
-                {
-                /* Receive message */
-                char* input_string = pakman_receive_message(parent_comm);
+        pakman_broadcast_task(&task, &input_string);
 
-                /* Run simulation */
-                char *output_string;
-                int error_code = (*simulator)(argc, argv,
-                        input_string, &output_string);
+        if (task == PAKMAN_TERMINATE_TASK)
+            break;
 
-                /* Send output */
-                pakman_send_message(parent_comm, output_string);
+        if (task == PAKMAN_FAILURE_TASK)
+            return PAKMAN_EXIT_FAILURE;
 
-                /* Send error code */
-                pakman_send_error_code(parent_comm, error_code);
+        /* Run simulation and let leader send output and error code */
+        pakman_task_cancelled = 0;
+        if (text_simulator)
+        {
+            char *output_string;
+            int error_code = (*text_simulator)(argc, argv,
+                    input_string, &output_string);
 
-                /* Free input and output strings */
-                free(input_string);
-                free(output_string);
+            if (worker_rank == PAKMAN_LEADER)
+                pakman_send_result(parent_comm, output_string, error_code);
 
-                break;
-                }
-            case PAKMAN_MANAGER_SIGNAL_TAG:
-                {
-                /* Receive signal */
-                int signal = pakman_receive_signal(parent_comm);
-
-                /* Check signal */
-                switch (signal)
-                {
-                    case PAKMAN_TERMINATE_WORKER_SIGNAL:
-                        {
-                        /* Set loop condition to false */
-                        continue_loop = 0;
-                        break;
-                        }
-                    default:
-                        {
-                        fputs("Pakman Worker error: signal not recognised, "
-                                "exiting...\n", stderr);
-                        return PAKMAN_EXIT_FAILURE;
-                        }
-                }
-                break;
-                }
-            default:
-                {
-                fputs("Pakman Worker error: tag not recognised, exiting...\n",
-                        stderr);
-                return PAKMAN_EXIT_FAILURE;
-                }
+            free(output_string);
         }
+        else
+        {
+            double *output = NULL;
+            int length = 0;
+            int error_code = (*double_simulator)(argc, argv,
+                    input_string, &output, &length);
+
+            if (worker_rank == PAKMAN_LEADER)
+                pakman_send_payload(parent_comm, error_code,
+                        PAKMAN_DOUBLE_PAYLOAD, output, length);
+
+            free(output);
+        }
+
+        /* Free input string */
+        free(input_string);
     }
 
+    /* Free communicator of MPI Worker group and buffers */
+    MPI_Comm_free(&pakman_worker_comm);
+    free(pakman_input_queue);
+    pakman_input_queue = NULL;
+    pakman_input_queue_capacity = 0;
+    free(pakman_send_buffer);
+    pakman_send_buffer = NULL;
+    pakman_send_buffer_size = 0;
+
     /* Disconnect parent communicator */
     MPI_Comm_disconnect(&parent_comm);
 
@@ -228,4 +582,6 @@ int pakman_run_mpi_worker(
     return PAKMAN_EXIT_SUCCESS;
 }
 
+#endif /* DOXYGEN_SHOULD_SKIP_THIS */
+
 #endif /* PAKMAN_MPI_WORKER_H */
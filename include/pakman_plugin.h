@@ -0,0 +1,86 @@
+#ifndef PAKMAN_PLUGIN_H
+#define PAKMAN_PLUGIN_H
+
+/** @file pakman_plugin.h
+ *
+ * By default, Pakman runs every user executable (simulator, prior_sampler,
+ * perturber, prior_pdf and perturbation_pdf) as a separate process, which
+ * costs a process launch per call.  For cheap models, this overhead
+ * can dominate the total runtime.
+ *
+ * Instead, any of these programs can be supplied as a plugin, that is, a
+ * shared library that Pakman loads with `dlopen()` and calls directly.  A
+ * command is treated as a plugin if its first token ends in `.so`, for
+ * example
+ * ```
+ * --simulator="./libsimulator.so arg1 arg2"
+ * ```
+ * The remaining tokens are passed to the plugin as command-line arguments.
+ * If the path does not contain a slash, the library is searched for as
+ * described in `dlopen(3)`.
+ *
+ * A plugin must define the function pakman_plugin_run() with C linkage.
+ * Its input and output follow exactly the same protocol as the standard
+ * input and output of the corresponding executable.  A plugin is loaded once
+ * per process and runs in the address space of Pakman, so it must not call
+ * `exit()`, must free any memory it allocates apart from the output string,
+ * and must not keep state that would break consecutive calls.  A crash in a
+ * plugin takes Pakman down with it.
+ *
+ * Pakman calls the plugin on separate threads, so that it can go on with
+ * other work while a simulation runs.  With several jobs or Worker slots per
+ * process, several calls run at the same time, so the plugin must be
+ * thread-safe.  A call that is no longer needed cannot be interrupted and is
+ * left to finish in the background.
+ */
+
+/** Exit code indicating plugin ran successfully. */
+#ifndef PAKMAN_EXIT_SUCCESS
+#define PAKMAN_EXIT_SUCCESS 0
+#endif
+
+/** Exit code indicating plugin encountered an error. */
+#ifndef PAKMAN_EXIT_FAILURE
+#define PAKMAN_EXIT_FAILURE 1
+#endif
+
+/** Name of function that a plugin must define. */
+#define PAKMAN_PLUGIN_FUNCTION "pakman_plugin_run"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Type of function that a plugin must define. */
+typedef int (*pakman_plugin_function_t)(int argc, char *argv[],
+        const char *input_string, char **p_output_string);
+
+/** Run plugin.
+ *
+ * This function is defined by the plugin, not by Pakman.  It has the same
+ * signature as the simulator function given to pakman_run_mpi_worker().
+ *
+ * The returned *p_output_string must have been allocated using `malloc()`.
+ * Pakman will call `free()` on *p_output_string after copying its contents.
+ * If the plugin returns a nonzero error code, *p_output_string may be left
+ * as the null pointer.
+ *
+ * @param argc  number of command-line arguments.
+ * @param argv  array of command-line arguments, where argv[0] is the path to
+ * the plugin.
+ * @param input_string  input to plugin, as it would be written to the
+ * standard input of the corresponding executable.
+ * @param p_output_string  pointer to output from plugin, as it would be
+ * written to the standard output of the corresponding executable.
+ *
+ * @return error code, as it would be the exit status of the corresponding
+ * executable.
+ */
+int pakman_plugin_run(int argc, char *argv[],
+        const char *input_string, char **p_output_string);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PAKMAN_PLUGIN_H */
@@ -0,0 +1,142 @@
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <utility>
+#include <new>
+
+#include <stdlib.h>
+
+#include <mpi.h>
+
+#include "mpi/mpi_utils.h"
+
+// Number of calls to operator new, counted to measure allocations per message
+static long g_allocation_count = 0;
+
+void* operator new(std::size_t size)
+{
+    g_allocation_count++;
+    void *p = malloc(size ? size : 1);
+    if (!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void *p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept
+{
+    free(p);
+}
+
+const int BENCHMARK_TAG = 0;
+
+// Original receive path, kept for comparison: receive into a temporary array
+// and copy it into a new string
+std::string copy_receive_string(MPI_Comm comm, int source, int tag)
+{
+    MPI_Status status;
+    MPI_Probe(source, tag, comm, &status);
+
+    int count = 0;
+    MPI_Get_count(&status, MPI_CHAR, &count);
+    char *buffer = new char[count];
+    MPI_Recv(buffer, count, MPI_CHAR, source, tag, comm, MPI_STATUS_IGNORE);
+
+    std::string message(buffer);
+    delete[] buffer;
+    return message;
+}
+
+// Send message to own rank, then receive it with the given receiver.  Return
+// throughput in megabytes per second and allocations per message
+template <typename Receiver>
+std::pair<double, double> benchmark(const std::string& message,
+        int number_messages, Receiver receiver)
+{
+    long allocations = 0;
+    std::chrono::duration<double> elapsed(0.0);
+
+    for (int k = 0; k < number_messages; k++)
+    {
+        MPI_Request request;
+        MPI_Isend(message.c_str(), message.size() + 1, MPI_CHAR, 0,
+                BENCHMARK_TAG, MPI_COMM_SELF, &request);
+
+        // Only the receive is timed and counted
+        long count_before = g_allocation_count;
+        auto start = std::chrono::steady_clock::now();
+
+        receiver();
+
+        auto end = std::chrono::steady_clock::now();
+        allocations += g_allocation_count - count_before;
+        elapsed += end - start;
+
+        MPI_Wait(&request, MPI_STATUS_IGNORE);
+    }
+
+    double megabytes = static_cast<double>(message.size()) *
+        number_messages / (1 << 20);
+
+    return std::make_pair(megabytes / elapsed.count(),
+            static_cast<double>(allocations) / number_messages);
+}
+
+int main(int argc, char *argv[])
+{
+    // Process arguments
+    if (argc != 3)
+    {
+        std::cerr << "Usage: " << argv[0] << " MESSAGES MAX_KB\n"
+            "\n"
+            "Measure the receive throughput of MPI messages of 1, 16, 256,\n"
+            "..., MAX_KB kilobytes with the original receive path, which\n"
+            "receives into a temporary array and copies it into a new\n"
+            "string, with receive_string(), which receives directly into a\n"
+            "new string, and with receive_string() into a reusable buffer,\n"
+            "as used by the MPIMaster and Managers.  Every method receives\n"
+            "MESSAGES messages that the process sends to itself.\n"
+            "\n"
+            "The columns of the output are the message size in kilobytes,\n"
+            "and the throughput in megabytes per second and the number of\n"
+            "allocations per message of every method.\n";
+        return 1;
+    }
+
+    const int number_messages = std::stoi(argv[1]);
+    const int max_kb = std::stoi(argv[2]);
+
+    MPI_Init(nullptr, nullptr);
+
+    std::cout << "KB copy_MB/s copy_allocs direct_MB/s direct_allocs "
+        "reuse_MB/s reuse_allocs\n";
+
+    std::string buffer;
+
+    for (int kb = 1; kb <= max_kb; kb *= 16)
+    {
+        const std::string message(static_cast<size_t>(kb) << 10, 'x');
+
+        auto copy = benchmark(message, number_messages, [&]() {
+                return copy_receive_string(MPI_COMM_SELF, 0,
+                        BENCHMARK_TAG); });
+
+        auto direct = benchmark(message, number_messages, [&]() {
+                return receive_string(MPI_COMM_SELF, 0, BENCHMARK_TAG); });
+
+        auto reuse = benchmark(message, number_messages, [&]() {
+                receive_string(MPI_COMM_SELF, 0, BENCHMARK_TAG, buffer); });
+
+        std::cout << kb << ' ' << copy.first << ' ' << copy.second << ' '
+            << direct.first << ' ' << direct.second << ' '
+            << reuse.first << ' ' << reuse.second << '\n';
+    }
+
+    MPI_Finalize();
+
+    return 0;
+}
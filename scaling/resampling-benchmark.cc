@@ -0,0 +1,120 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <random>
+#include <chrono>
+
+#include "controller/sample_population.h"
+
+// Original linear scan over cumulative sum, kept for comparison
+int sample_population_linear(const std::vector<double>& norm_cumsum_array,
+           std::uniform_real_distribution<double>& distribution,
+           std::default_random_engine& generator)
+{
+    double u = distribution(generator);
+
+    for (size_t idx = 0; idx < norm_cumsum_array.size(); idx++)
+        if (u <= norm_cumsum_array[idx])
+            return idx;
+
+    return norm_cumsum_array.size() - 1;
+}
+
+// Return average time per draw in nanoseconds
+template <typename Sampler>
+double time_per_draw(Sampler sampler, int number_draws)
+{
+    long checksum = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    for (int k = 0; k < number_draws; k++)
+        checksum += sampler();
+
+    auto end = std::chrono::steady_clock::now();
+
+    // Print checksum so that the draws are not optimised away
+    std::cerr << checksum << '\n';
+
+    return std::chrono::duration<double, std::nano>(end - start).count() /
+        number_draws;
+}
+
+int main(int argc, char *argv[])
+{
+    // Process arguments
+    if (argc != 3)
+    {
+        std::cerr << "Usage: " << argv[0] <<
+            " MAX_N DRAWS\n"
+            "\n"
+            "Measure the time per draw of weighted resampling from populations\n"
+            "of size N = 10, 100, ..., MAX_N with random weights.  Every\n"
+            "method is timed over DRAWS draws.\n"
+            "\n"
+            "The columns of the output are N and the time per draw in\n"
+            "nanoseconds of linear search, binary search, alias table, and\n"
+            "systematic and residual resampling.  The last two include the\n"
+            "cost of resampling a whole population at a time.\n";
+        return 1;
+    }
+
+    const int max_n = std::stoi(argv[1]);
+    const int number_draws = std::stoi(argv[2]);
+
+    std::default_random_engine generator(0);
+    std::uniform_real_distribution<double> distribution(0.0, 1.0);
+
+    std::cout << "N linear binary alias systematic residual\n";
+
+    for (int n = 10; n <= max_n; n *= 10)
+    {
+        // Make random normalized weights
+        std::vector<double> weights(n), weights_cumsum(n);
+        for (double& weight : weights)
+            weight = distribution(generator);
+        normalize(weights);
+        cumsum(weights, weights_cumsum);
+
+        std::vector<double> probabilities;
+        std::vector<int> aliases;
+        make_alias_table(weights, probabilities, aliases);
+
+        // Linear search is quadratic in N, so limit number of draws
+        double linear = time_per_draw([&]() {
+                return sample_population_linear(weights_cumsum, distribution,
+                        generator); },
+                std::min(number_draws, 100000000 / n));
+
+        double binary = time_per_draw([&]() {
+                return sample_population(weights_cumsum, distribution,
+                        generator); }, number_draws);
+
+        double alias = time_per_draw([&]() {
+                return sample_population(probabilities, aliases,
+                        distribution, generator); }, number_draws);
+
+        // Systematic and residual resampling hand out indices from a
+        // resampled population
+        std::vector<int> indices;
+        auto block_sampler = [&](resampling_t resampling) {
+            return [&, resampling]() {
+                if (indices.empty())
+                    resample_population(resampling, weights, weights_cumsum,
+                            indices, distribution, generator);
+                int idx = indices.back();
+                indices.pop_back();
+                return idx; };
+        };
+
+        double systematic_time = time_per_draw(block_sampler(systematic),
+                number_draws);
+        indices.clear();
+        double residual_time = time_per_draw(block_sampler(residual),
+                number_draws);
+
+        std::cout << n << ' ' << linear << ' ' << binary << ' ' << alias
+            << ' ' << systematic_time << ' ' << residual_time << '\n';
+    }
+
+    return 0;
+}
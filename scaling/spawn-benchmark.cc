@@ -0,0 +1,129 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <stdexcept>
+
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/types.h>
+#include <fcntl.h>
+
+#include "core/Command.h"
+#include "system/system_call.h"
+#include "system/pipe_io.h"
+
+// Global variable used by system_call()
+bool g_discard_child_stderr = false;
+
+// Original launch path, kept for comparison: look up the executable and
+// fork() the calling process before every exec
+std::string fork_exec_call(const std::string& raw_command,
+        const std::string& input)
+{
+    Command cmd(raw_command);
+    if (!cmd.isExecutable())
+        throw std::runtime_error("cannot access " + raw_command);
+
+    int send_pipefd[2], recv_pipefd[2];
+    if ( (pipe(send_pipefd) == -1) || (pipe(recv_pipefd) == -1) )
+        throw std::runtime_error("pipe failed");
+
+    pid_t child_pid = fork();
+
+    if (child_pid == -1)
+        throw std::runtime_error("fork failed");
+
+    if (child_pid == 0)
+    {
+        close(send_pipefd[1]);
+        dup2(send_pipefd[0], STDIN_FILENO);
+        close(send_pipefd[0]);
+
+        close(recv_pipefd[0]);
+        dup2(recv_pipefd[1], STDOUT_FILENO);
+        close(recv_pipefd[1]);
+
+        execvp(cmd.argv()[0], cmd.argv());
+        _exit(127);
+    }
+
+    close(send_pipefd[0]);
+    close(recv_pipefd[1]);
+
+    std::string output;
+    write_to_pipe(send_pipefd, input);
+    close(send_pipefd[1]);
+    read_from_pipe(recv_pipefd, output);
+    close(recv_pipefd[0]);
+
+    waitpid(child_pid, nullptr, 0);
+
+    return output;
+}
+
+// Return average time per launch in microseconds
+template <typename Launcher>
+double time_per_launch(Launcher launcher, int number_launches)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    for (int k = 0; k < number_launches; k++)
+        launcher();
+
+    auto end = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double, std::micro>(end - start).count() /
+        number_launches;
+}
+
+int main(int argc, char *argv[])
+{
+    // Process arguments
+    if ((argc != 3) && (argc != 4))
+    {
+        std::cerr << "Usage: " << argv[0] <<
+            " LAUNCHES MAX_MB [COMMAND]\n"
+            "\n"
+            "Measure the time per launch of COMMAND (default: cat) with\n"
+            "fork()--execvp(), as pakman used to launch simulators, and with\n"
+            "system_call(), which uses posix_spawn() and a cached executable\n"
+            "path.  The launching process first touches a ballast of\n"
+            "resident memory of 0, 16, 64, ..., MAX_MB megabytes to mimic\n"
+            "an MPI process holding large populations.  Every method is\n"
+            "timed over LAUNCHES launches.\n"
+            "\n"
+            "The columns of the output are the ballast size in megabytes and\n"
+            "the time per launch in microseconds of fork()--execvp() and\n"
+            "posix_spawn().\n";
+        return 1;
+    }
+
+    const int number_launches = std::stoi(argv[1]);
+    const int max_mb = std::stoi(argv[2]);
+    const std::string raw_command = (argc == 4) ? argv[3] : "cat";
+
+    const Command cmd(raw_command);
+    const std::string input("0.5\n");
+
+    std::vector<char> ballast;
+
+    std::cout << "MB fork spawn\n";
+
+    for (int mb = 0; mb <= max_mb; mb = (mb == 0) ? 16 : 4 * mb)
+    {
+        // Touch every page of ballast so that it is resident
+        ballast.assign(static_cast<size_t>(mb) << 20, 1);
+
+        double fork_time = time_per_launch([&]() {
+                return fork_exec_call(raw_command, input); },
+                number_launches);
+
+        double spawn_time = time_per_launch([&]() {
+                return system_call(cmd, input); }, number_launches);
+
+        std::cout << mb << ' ' << fork_time << ' ' << spawn_time << '\n';
+    }
+
+    return 0;
+}
@@ -13,15 +13,16 @@
 #include "interface/output.h"
 #include "master/AbstractMaster.h"
 
+#include "ProposalGenerator.h"
 #include "ABCRejectionController.h"
 
 // Constructor
 ABCRejectionController::ABCRejectionController(const Input& input_obj) :
-    m_number_accept(input_obj.number_accept),
     m_epsilon(input_obj.epsilon),
-    m_prior_sampler(input_obj.prior_sampler),
     m_parameter_names(input_obj.parameter_names),
-    m_simulator(input_obj.simulator)
+    m_number_accept(input_obj.number_accept),
+    m_simulator(input_obj.simulator),
+    m_prior_sampler(input_obj.prior_sampler)
 {
 }
 
@@ -43,7 +44,20 @@ void ABCRejectionController::iterate()
         AbstractMaster::TaskHandler& task = m_p_master->frontFinishedTask();
 
         // Check if error occured
-        if (!task.didErrorOccur())
+        if (!task.didErrorOccur() && m_distribute_proposals)
+        {
+            // Parse parameter and simulator output
+            Parameter parameter;
+            double prior_pdf = 0.0;
+            std::string simulator_output;
+            parse_proposal_output(task.getOutputString(), parameter,
+                    prior_pdf, simulator_output);
+
+            // Push parameter if it was accepted
+            if (parse_simulator_output(simulator_output))
+                m_prmtr_accepted.push_back(std::move(parameter));
+        }
+        else if (!task.didErrorOccur())
         {
             // Check if parameter was accepted
             if (parse_simulator_output(task.getOutputString()))
@@ -97,8 +111,15 @@ void ABCRejectionController::iterate()
     // There is still work to be done, so make sure there are as many tasks
     // queued as there are Managers
     while (m_p_master->needMorePendingTasks())
-        m_p_master->pushPendingTask(format_simulator_input(m_epsilon.str(),
-                    sample_from_prior(m_prior_sampler)));
+    {
+        // If proposals are distributed, the Managers sample from the prior
+        if (m_distribute_proposals)
+            m_p_master->pushPendingTask(format_proposal_request(m_epsilon, 0,
+                        Parameter()));
+        else
+            m_p_master->pushPendingTask(format_simulator_input(
+                        m_epsilon.str(), sample_from_prior(m_prior_sampler)));
+    }
 
     m_entered = false;
 }
@@ -107,3 +128,15 @@ Command ABCRejectionController::getSimulator() const
 {
     return m_simulator;
 }
+
+bool ABCRejectionController::acceptsUnorderedResults() const
+{
+    return true;
+}
+
+std::shared_ptr<ProposalGenerator>
+ABCRejectionController::distributeProposals()
+{
+    m_distribute_proposals = true;
+    return std::make_shared<ProposalGenerator>(m_prior_sampler);
+}
@@ -4,6 +4,7 @@
 #include <string>
 #include <vector>
 #include <istream>
+#include <memory>
 
 #include "core/Command.h"
 
@@ -61,6 +62,16 @@ class ABCRejectionController : public AbstractController
         /** @return simulator command. */
         virtual Command getSimulator() const override;
 
+        /** @return true, since the order of simulations does not matter. */
+        virtual bool acceptsUnorderedResults() const override;
+
+        /** Switch to distributed proposals.
+         *
+         * @return pointer to ProposalGenerator.
+         */
+        virtual std::shared_ptr<ProposalGenerator> distributeProposals()
+            override;
+
         /** @return help message string. */
         static std::string help();
 
@@ -125,6 +136,9 @@ class ABCRejectionController : public AbstractController
         // Number of parameters simulated
         int m_number_simulated = 0;
 
+        // Whether parameters are generated by the Managers
+        bool m_distribute_proposals = false;
+
         // Simulator command
         Command m_simulator;
 
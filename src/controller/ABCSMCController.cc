@@ -17,6 +17,8 @@
 
 #include "smc_weight.h"
 #include "sample_population.h"
+#include "ProposalGenerator.h"
+#include "PerturbationKernel.h"
 
 #include "ABCSMCController.h"
 
@@ -24,17 +26,20 @@
 ABCSMCController::ABCSMCController(const Input &input_obj,
         std::shared_ptr<std::default_random_engine> p_generator) :
     m_epsilons(input_obj.epsilons),
+    m_perturbation_pdf(input_obj.perturbation_pdf),
+    m_batch_perturbation_pdf(input_obj.batch_perturbation_pdf),
+    m_p_perturbation_kernel(input_obj.perturbation_kernel),
     m_parameter_names(input_obj.parameter_names),
     m_population_size(input_obj.population_size),
     m_simulator(input_obj.simulator),
-    m_prior_sampler(input_obj.prior_sampler),
-    m_prior_pdf(input_obj.prior_pdf),
-    m_perturber(input_obj.perturber),
-    m_perturbation_pdf(input_obj.perturbation_pdf),
-    m_p_generator(p_generator),
     m_distribution(0.0, 1.0),
+    m_p_generator(p_generator),
     m_prmtr_accepted_old(input_obj.population_size),
-    m_weights_old(input_obj.population_size)
+    m_weights_old(input_obj.population_size),
+    m_resampling(input_obj.resampling),
+    m_prior_sampler(input_obj.prior_sampler),
+    m_perturber(input_obj.perturber),
+    m_prior_pdf(input_obj.prior_pdf)
 {
 }
 
@@ -61,38 +66,61 @@ void ABCSMCController::iterate()
     while (!m_p_master->finishedTasksEmpty()
             && m_prmtr_accepted_new.size() < m_population_size)
     {
-        // m_prior_pdf_pending should not be empty
-        assert(!m_prior_pdf_pending.empty());
-
-        // Increment counter
-        m_number_simulated++;
-
         // Get reference to front finished task
         AbstractMaster::TaskHandler& task = m_p_master->frontFinishedTask();
 
-        // Check if error occured
-        if (!task.didErrorOccur())
+        // Get parameter, its prior_pdf and simulator output.  If proposals
+        // are distributed, these are returned by the Manager.  Otherwise, the
+        // parameter is read from the input string and the prior_pdf was
+        // attached to the task as metadata
+        Parameter parameter;
+        double prior_pdf = task.getMetadata();
+        std::string simulator_output = task.getOutputString();
+
+        if (m_distribute_proposals)
         {
-            // Check if parameter was accepted
-            if (parse_simulator_output(task.getOutputString()))
+            std::string proposal_output = task.getOutputString();
+            parse_proposal_output(proposal_output, parameter, prior_pdf,
+                    simulator_output);
+
+            // Discard parameters that lie outside the support of the prior,
+            // these were not simulated
+            if ((m_t > 0) && (prior_pdf == 0.0))
             {
-                // Declare raw parameter
-                std::string raw_parameter;
+                m_p_master->popFinishedTask();
+                continue;
+            }
+        }
+        else
+        {
+            // Declare raw parameter
+            std::string raw_parameter;
 
-                // Get input string
-                std::stringstream input_sstrm(task.getInputString());
+            // Get input string
+            std::stringstream input_sstrm(task.getInputString());
 
-                // Discard epsilon
-                std::getline(input_sstrm, raw_parameter);
+            // Discard epsilon
+            std::getline(input_sstrm, raw_parameter);
 
-                // Read accepted parameter
-                std::getline(input_sstrm, raw_parameter);
+            // Read parameter
+            std::getline(input_sstrm, raw_parameter);
+            parameter = std::move(raw_parameter);
+        }
+
+        // Increment counter
+        m_number_simulated++;
 
+        // Check if error occured
+        if (!task.didErrorOccur())
+        {
+            // Check if parameter was accepted
+            if (parse_simulator_output(simulator_output))
+            {
                 // Push accepted parameter
-                m_prmtr_accepted_new.push_back(std::move(raw_parameter));
+                m_prmtr_accepted_new.push_back(std::move(parameter));
 
                 // Push prior_pdf of accepted parameter
-                m_prior_pdf_accepted.push_back(m_prior_pdf_pending.front());
+                m_prior_pdf_accepted.push_back(prior_pdf);
             }
         }
         // If error occurred, check if g_ignore_errors is set
@@ -104,13 +132,23 @@ void ABCSMCController::iterate()
 
         // Pop finished task
         m_p_master->popFinishedTask();
-
-        // Pop prior_pdf of finished task
-        m_prior_pdf_pending.pop();
     }
 
-    // Iterate over parameters whose weights have not yet been computed
-    for (int i = m_weights_new.size(); i < m_prmtr_accepted_new.size(); i++)
+    // Iterate over parameters whose weights have not yet been computed, using
+    // the built-in perturbation kernel if given and the perturbation pdf
+    // otherwise.  If the perturbation pdf follows the batch protocol, the
+    // weights are computed once the generation is complete instead
+    for (size_t i = m_weights_new.size(); m_p_perturbation_kernel
+            && (i < m_prmtr_accepted_new.size()); i++)
+        m_weights_new.push_back(smc_weight(
+                *m_p_perturbation_kernel,
+                m_prior_pdf_accepted[i],
+                m_t,
+                m_population_size,
+                m_prmtr_accepted_new[i]));
+
+    for (size_t i = m_weights_new.size(); !m_batch_perturbation_pdf
+            && (i < m_prmtr_accepted_new.size()); i++)
         m_weights_new.push_back(smc_weight(
                 m_perturbation_pdf,
                 m_prior_pdf_accepted[i],
@@ -131,6 +169,16 @@ void ABCSMCController::iterate()
                 (100.0 * m_population_size / (double) m_number_simulated));
         m_number_simulated = 0;
 
+        // Compute all weights of this generation in a single call
+        if (m_batch_perturbation_pdf)
+            m_weights_new = smc_weights(
+                    m_perturbation_pdf,
+                    m_prior_pdf_accepted,
+                    m_t,
+                    m_prmtr_accepted_old,
+                    m_weights_old,
+                    m_prmtr_accepted_new);
+
         // Increment generation counter
         m_t++;
 
@@ -156,6 +204,21 @@ void ABCSMCController::iterate()
         normalize(m_weights_old);
         cumsum(m_weights_old, m_weights_cumsum);
 
+        if (spdlog::get(g_program_name)->level() <= spdlog::level::debug)
+            for (size_t i = 0; i < m_weights_old.size(); i++)
+                spdlog::debug("ABCSMCController: generation {}, weight of "
+                        "'{}': {:.17g}", m_t - 1,
+                        m_prmtr_accepted_old[i].str(), m_weights_old[i]);
+
+        // Prepare resampling, so that every draw costs constant time
+        make_alias_table(m_weights_old, m_alias_probabilities, m_aliases);
+        m_resampled_indices.clear();
+
+        // Pass previous generation to built-in perturbation kernel
+        if (m_p_perturbation_kernel)
+            m_p_perturbation_kernel->setPopulation(m_prmtr_accepted_old,
+                    m_weights_old);
+
         // Clear m_weights_new, m_prmtr_accepted_new and m_prior_pdf_accepted
         m_weights_new.clear();
         m_prmtr_accepted_new.clear();
@@ -165,10 +228,6 @@ void ABCSMCController::iterate()
         m_p_master->flush();
         m_entered = false;
 
-        // Clear m_prior_pdf_pending
-        while (!m_prior_pdf_pending.empty())
-            m_prior_pdf_pending.pop();
-
         // Print message
         spdlog::info("Computing generation {}, epsilon = {}", m_t,
                 m_epsilons[m_t].str());
@@ -178,9 +237,20 @@ void ABCSMCController::iterate()
     // There is still work to be done, so make sure there are as many tasks
     // queued as there are Managers
     while (m_p_master->needMorePendingTasks())
+    {
+        // If proposals are distributed, the Managers perturb the parameter
+        if (m_distribute_proposals)
+        {
+            m_p_master->pushPendingTask(sampleProposalRequest());
+            continue;
+        }
+
+        double prior_pdf = 0.0;
+        Parameter parameter = sampleParameter(prior_pdf);
         m_p_master->pushPendingTask(
-                format_simulator_input(
-                    m_epsilons[m_t].str(), sampleParameter()));
+                format_simulator_input(m_epsilons[m_t].str(), parameter),
+                prior_pdf);
+    }
 
     m_entered = false;
 }
@@ -190,13 +260,25 @@ Command ABCSMCController::getSimulator() const
     return m_simulator;
 }
 
-Parameter ABCSMCController::sampleParameter()
+bool ABCSMCController::acceptsUnorderedResults() const
+{
+    return true;
+}
+
+std::shared_ptr<ProposalGenerator> ABCSMCController::distributeProposals()
+{
+    m_distribute_proposals = true;
+    return std::make_shared<ProposalGenerator>(m_prior_sampler, m_perturber,
+            m_prior_pdf);
+}
+
+Parameter ABCSMCController::sampleParameter(double& prior_pdf)
 {
     // If in generation 0
     if (m_t == 0)
     {
-        // Push dummy prior_pdf to m_prior_pdf_pending
-        m_prior_pdf_pending.push(0.0);
+        // Set dummy prior_pdf
+        prior_pdf = 0.0;
 
         // Sample from prior
         return sample_from_prior(m_prior_sampler);
@@ -209,9 +291,7 @@ Parameter ABCSMCController::sampleParameter()
     do
     {
         // Sample parameter population
-        int idx = sample_population(m_weights_cumsum, m_distribution,
-                *m_p_generator);
-        Parameter source_parameter = m_prmtr_accepted_old[idx];
+        Parameter source_parameter = m_prmtr_accepted_old[sampleIndex()];
 
         // Perturb parameter
         sampled_parameter = perturb_parameter(m_perturber, m_t,
@@ -221,8 +301,38 @@ Parameter ABCSMCController::sampleParameter()
         sampled_prior_pdf = get_prior_pdf(m_prior_pdf, sampled_parameter);
     } while (sampled_prior_pdf == 0.0);
 
-    // Push sampled_prior_pdf to m_prior_pdf_pending
-    m_prior_pdf_pending.push(sampled_prior_pdf);
+    // Return sampled_prior_pdf
+    prior_pdf = sampled_prior_pdf;
 
     return sampled_parameter;
 }
+
+std::string ABCSMCController::sampleProposalRequest()
+{
+    // If in generation 0, the Manager samples from prior
+    if (m_t == 0)
+        return format_proposal_request(m_epsilons[m_t], m_t, Parameter());
+
+    // Else, sample parameter population and let the Manager perturb it
+    return format_proposal_request(m_epsilons[m_t], m_t,
+            m_prmtr_accepted_old[sampleIndex()]);
+}
+
+int ABCSMCController::sampleIndex()
+{
+    // Multinomial resampling draws every index independently
+    if (m_resampling == multinomial)
+        return sample_population(m_alias_probabilities, m_aliases,
+                m_distribution, *m_p_generator);
+
+    // Else, resample a whole population at a time and hand out its indices
+    // one by one
+    if (m_resampled_indices.empty())
+        resample_population(m_resampling, m_weights_old, m_weights_cumsum,
+                m_resampled_indices, m_distribution, *m_p_generator);
+
+    int idx = m_resampled_indices.back();
+    m_resampled_indices.pop_back();
+
+    return idx;
+}
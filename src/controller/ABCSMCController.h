@@ -3,16 +3,18 @@
 
 #include <string>
 #include <vector>
-#include <queue>
 #include <memory>
 #include <random>
 
 #include "core/Command.h"
 
+#include "sample_population.h"
+
 #include "AbstractController.h"
 
 class LongOptions;
 class Arguments;
+class PerturbationKernel;
 
 /** A Controller class implementing the ABC SMC algorithm.
  *
@@ -58,6 +60,16 @@ class ABCSMCController : public AbstractController
         /** @return simulator command. */
         virtual Command getSimulator() const override;
 
+        /** @return true, since the order of simulations does not matter. */
+        virtual bool acceptsUnorderedResults() const override;
+
+        /** Switch to distributed proposals.
+         *
+         * @return pointer to ProposalGenerator.
+         */
+        virtual std::shared_ptr<ProposalGenerator> distributeProposals()
+            override;
+
         /** @return help message string. */
         static std::string help();
 
@@ -113,13 +125,39 @@ class ABCSMCController : public AbstractController
              * distribution.
              */
             Command perturbation_pdf;
+
+            /** Whether perturbation_pdf follows the batch perturbation_pdf
+             * protocol (see format_batch_perturbation_pdf_input()).
+             */
+            bool batch_perturbation_pdf = false;
+
+            /** Built-in perturbation kernel, replaces perturbation_pdf if not
+             * the null pointer.
+             */
+            std::shared_ptr<PerturbationKernel> perturbation_kernel;
+
+            /** Resampling scheme for choosing parameters from the previous
+             * generation.
+             */
+            resampling_t resampling = multinomial;
+
+            /** Seed of random number generator, which is based on the
+             * current time unless it is given.
+             */
+            unsigned long seed;
         };
 
     private:
 
         ///// Member functions /////
-        // Sample parameter
-        Parameter sampleParameter();
+        // Sample parameter and compute its prior pdf
+        Parameter sampleParameter(double& prior_pdf);
+
+        // Sample source parameter and make proposal request
+        std::string sampleProposalRequest();
+
+        // Sample index of parameter from previous generation
+        int sampleIndex();
 
         ///// Member variables /////
         // Epsilons
@@ -131,6 +169,12 @@ class ABCSMCController : public AbstractController
         // Perturbation pdf for weights calculation
         Command m_perturbation_pdf;
 
+        // Whether perturbation pdf follows batch protocol
+        bool m_batch_perturbation_pdf;
+
+        // Built-in perturbation kernel for weights calculation
+        std::shared_ptr<PerturbationKernel> m_p_perturbation_kernel;
+
         // Parameter names
         std::vector<ParameterName> m_parameter_names;
 
@@ -158,9 +202,6 @@ class ABCSMCController : public AbstractController
         // Random number generator
         std::shared_ptr<std::default_random_engine> m_p_generator;
 
-        // Prior pdf values of pending parameters
-        std::queue<double> m_prior_pdf_pending;
-
         // Parameters accepted in previous generation
         std::vector<Parameter> m_prmtr_accepted_old;
 
@@ -170,6 +211,16 @@ class ABCSMCController : public AbstractController
         // Cumulative sum of weights
         std::vector<double> m_weights_cumsum;
 
+        // Resampling scheme
+        resampling_t m_resampling;
+
+        // Alias table of weights for multinomial resampling
+        std::vector<double> m_alias_probabilities;
+        std::vector<int> m_aliases;
+
+        // Indices resampled in blocks for systematic and residual resampling
+        std::vector<int> m_resampled_indices;
+
         // Prior sampler command
         Command m_prior_sampler;
 
@@ -182,6 +233,9 @@ class ABCSMCController : public AbstractController
         // First iteration
         bool m_first = true;
 
+        // Whether parameters are generated by the Managers
+        bool m_distribute_proposals = false;
+
         // Entered iterate()
         bool m_entered = false;
 };
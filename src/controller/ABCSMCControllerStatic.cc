@@ -10,6 +10,8 @@
 #include "core/Arguments.h"
 #include "interface/input.h"
 
+#include "PerturbationKernel.h"
+
 #include "ABCSMCController.h"
 
 std::string ABCSMCController::help()
@@ -47,6 +49,32 @@ Description:
   on its stdout the corresponding probability density for reaching the
   perturbed parameter by perturbing the given parameter.
 
+  Since 'perturbation_pdf' is called for every accepted parameter and is given
+  the whole previous generation every time, it can be replaced by
+  'batch_perturbation_pdf', which is called once per generation.
+  'batch_perturbation_pdf' accepts on its stdin the current generation 't',
+  the number of perturbed parameters 'M', 'M' perturbed parameters, the size
+  of the previous generation 'N', 'N' weights of the previous generation and
+  the 'N' parameters of the previous generation, each on a separate line.  For
+  every perturbed parameter, 'batch_perturbation_pdf' outputs on its stdout
+  the sum over the previous generation of the weight of each parameter times
+  the probability density for reaching the perturbed parameter by perturbing
+  that parameter.
+
+  For Gaussian and uniform random-walk kernels, 'perturbation_pdf' can be
+  replaced by a built-in perturbation kernel, which is evaluated by pakman
+  itself.  The kernel is given as 'TYPE:W1,W2,...', where 'TYPE' is 'gaussian'
+  or 'uniform' and 'W1,W2,...' are the standard deviations or half-widths,
+  respectively, of the kernel in every parameter component.  Parameters must
+  then consist of whitespace-separated numbers, and 'perturber' should sample
+  from the same kernel.
+
+  Parameters are chosen from the previous generation by multinomial
+  resampling by default.  With systematic or residual resampling, a whole
+  population of indices is resampled at a time and handed out in random
+  order, which reduces the variance of the number of times every parameter is
+  chosen.
+
   For every candidate parameter, 'simulator' is invoked and given two lines as
   its input; the first line contains the current epsilon value and the second
   line contains the candidate parameter.
@@ -70,6 +98,18 @@ Required arguments:
   -T, --perturber=CMD           CMD is perturber command
   -I, --prior-pdf=CMD           CMD is prior_pdf command
   -U, --perturbation-pdf=CMD    CMD is perturbation_pdf command
+
+Optional arguments:
+  -B, --batch-perturbation-pdf=CMD
+                                CMD is batch_perturbation_pdf command,
+                                replaces --perturbation-pdf
+  -K, --perturbation-kernel=KERNEL
+                                KERNEL is built-in perturbation kernel,
+                                replaces --perturbation-pdf
+  -M, --resampling=SCHEME       SCHEME is 'multinomial' (default),
+                                'systematic' or 'residual'
+  -D, --seed=SEED               SEED is seed of random number generator
+                                (default based on current time)
 )";
 }
 
@@ -84,6 +124,10 @@ void ABCSMCController::addLongOptions(
     lopts.add({"perturber", required_argument, nullptr, 'T'});
     lopts.add({"prior-pdf", required_argument, nullptr, 'I'});
     lopts.add({"perturbation-pdf", required_argument, nullptr, 'U'});
+    lopts.add({"batch-perturbation-pdf", required_argument, nullptr, 'B'});
+    lopts.add({"perturbation-kernel", required_argument, nullptr, 'K'});
+    lopts.add({"resampling", required_argument, nullptr, 'M'});
+    lopts.add({"seed", required_argument, nullptr, 'D'});
 }
 
 ABCSMCController* ABCSMCController::makeController(const Arguments& args)
@@ -94,10 +138,8 @@ ABCSMCController* ABCSMCController::makeController(const Arguments& args)
     input_obj = Input::makeInput(args);
 
     // Create random number generator
-    // TODO accept other seeds
-    unsigned seed =
-        std::chrono::system_clock::now().time_since_epoch().count();
-    auto p_generator = std::make_shared<std::default_random_engine>(seed);
+    auto p_generator =
+        std::make_shared<std::default_random_engine>(input_obj.seed);
 
     // Make ABCSMCController
     return new ABCSMCController(input_obj, p_generator);
@@ -132,8 +174,40 @@ ABCSMCController::Input ABCSMCController::Input::makeInput(
         input_obj.prior_pdf =
             parse_command(args.optionalArgument("prior-pdf"));
 
-        input_obj.perturbation_pdf =
-            parse_command(args.optionalArgument("perturbation-pdf"));
+        // Exactly one of perturbation_pdf, batch_perturbation_pdf and
+        // perturbation_kernel must be given
+        if (    args.isOptionalArgumentSet("perturbation-pdf") +
+                args.isOptionalArgumentSet("batch-perturbation-pdf") +
+                args.isOptionalArgumentSet("perturbation-kernel") > 1)
+            throw std::invalid_argument("only one of the options "
+                    "--perturbation-pdf, --batch-perturbation-pdf and "
+                    "--perturbation-kernel can be set");
+
+        if (args.isOptionalArgumentSet("perturbation-kernel"))
+            input_obj.perturbation_kernel =
+                std::make_shared<PerturbationKernel>(
+                        args.optionalArgument("perturbation-kernel"));
+        else if (args.isOptionalArgumentSet("batch-perturbation-pdf"))
+        {
+            input_obj.perturbation_pdf = parse_command(
+                    args.optionalArgument("batch-perturbation-pdf"));
+            input_obj.batch_perturbation_pdf = true;
+        }
+        else
+            input_obj.perturbation_pdf =
+                parse_command(args.optionalArgument("perturbation-pdf"));
+
+        // Resampling scheme is optional
+        if (args.isOptionalArgumentSet("resampling"))
+            input_obj.resampling =
+                parse_resampling(args.optionalArgument("resampling"));
+
+        // Seed is optional
+        if (args.isOptionalArgumentSet("seed"))
+            input_obj.seed = std::stoul(args.optionalArgument("seed"));
+        else
+            input_obj.seed =
+                std::chrono::system_clock::now().time_since_epoch().count();
     }
     catch (const std::out_of_range& e)
     {
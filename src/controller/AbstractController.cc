@@ -1,5 +1,7 @@
 #include <memory>
 
+#include "ProposalGenerator.h"
+
 #include "AbstractController.h"
 
 // Assign Master
@@ -7,3 +9,21 @@ void AbstractController::assignMaster(std::shared_ptr<AbstractMaster> p_master)
 {
     m_p_master = p_master;
 }
+
+// By default, finished tasks must be delivered in order
+bool AbstractController::acceptsUnorderedResults() const
+{
+    return false;
+}
+
+// By default, output strings are interpreted as text
+bool AbstractController::acceptsBinaryOutput() const
+{
+    return false;
+}
+
+// By default, proposals cannot be distributed
+std::shared_ptr<ProposalGenerator> AbstractController::distributeProposals()
+{
+    return nullptr;
+}
@@ -11,6 +11,7 @@ class AbstractMaster;
 class LongOptions;
 class Arguments;
 class Command;
+class ProposalGenerator;
 
 /** An abstract class for submitting simulation tasks.
  *
@@ -64,6 +65,39 @@ class AbstractController
         /** @return simulator command. */
         virtual Command getSimulator() const = 0;
 
+        /** @return whether the Controller can process finished tasks in any
+         * order.
+         *
+         * By default, finished tasks are delivered in the order in which they
+         * were pushed.  Controllers whose results do not depend on this order
+         * can override this method to return true, so that the Master may
+         * deliver finished tasks as soon as they finish (see
+         * AbstractMaster::unorderedCompletion()).
+         */
+        virtual bool acceptsUnorderedResults() const;
+
+        /** @return whether the Controller accepts binary simulator output.
+         *
+         * MPI simulators may output an array of doubles instead of text, in
+         * which case the output string of a task holds the raw bytes of the
+         * array.  By default, Controllers interpret output strings as text
+         * and do not accept binary output.  Controllers that only pass
+         * output strings on can override this method to return true.
+         */
+        virtual bool acceptsBinaryOutput() const;
+
+        /** Switch to distributed proposals.
+         *
+         * With distributed proposals, the Controller pushes proposal requests
+         * instead of simulator input, and the Managers generate parameters
+         * using the returned ProposalGenerator (see ProposalGenerator).
+         *
+         * @return pointer to ProposalGenerator, or the null pointer if the
+         * Controller does not support distributed proposals, in which case
+         * nothing is changed.
+         */
+        virtual std::shared_ptr<ProposalGenerator> distributeProposals();
+
         /** Interpret string as Controller type.
          *
          * The controller_t enumeration type is defined in common.h.
@@ -0,0 +1,171 @@
+#include <string>
+#include <vector>
+#include <sstream>
+#include <stdexcept>
+#include <cmath>
+#include <algorithm>
+
+#include "core/utils.h"
+
+#include "PerturbationKernel.h"
+
+// Construct from kernel specification string
+PerturbationKernel::PerturbationKernel(const std::string& spec)
+{
+    // Split specification into type and widths
+    std::string::size_type colon = spec.find(':');
+    if (colon == std::string::npos)
+    {
+        std::string error_msg;
+        error_msg += "Perturbation kernel must be of the form "
+            "TYPE:W1,W2,..., given: ";
+        error_msg += spec;
+        throw std::invalid_argument(error_msg);
+    }
+
+    std::string type = spec.substr(0, colon);
+    if (type == "gaussian")
+        m_type = gaussian;
+    else if (type == "uniform")
+        m_type = uniform;
+    else
+    {
+        std::string error_msg;
+        error_msg += "Unknown perturbation kernel type: ";
+        error_msg += type;
+        throw std::invalid_argument(error_msg);
+    }
+
+    // Parse widths, std::stod throws std::invalid_argument on bad input
+    for (const std::string& token : parse_tokens(spec.substr(colon + 1), ","))
+    {
+        double width = std::stod(token);
+        if (!(width > 0.0))
+        {
+            std::string error_msg;
+            error_msg += "Perturbation kernel widths must be positive, "
+                "given: ";
+            error_msg += token;
+            throw std::invalid_argument(error_msg);
+        }
+        m_widths.push_back(width);
+    }
+
+    if (m_widths.empty())
+    {
+        std::string error_msg;
+        error_msg += "Perturbation kernel has no widths, given: ";
+        error_msg += spec;
+        throw std::invalid_argument(error_msg);
+    }
+
+    // Compute normalization constant.  It cancels when the weights are
+    // normalized, but is kept so that weightedDensity() returns a density
+    m_normalization = 1.0;
+    for (double width : m_widths)
+    {
+        if (m_type == gaussian)
+            m_normalization /= std::sqrt(2.0 * M_PI) * width;
+        else
+            m_normalization /= 2.0 * width;
+    }
+}
+
+int PerturbationKernel::dimension() const
+{
+    return m_widths.size();
+}
+
+// Set previous generation
+void PerturbationKernel::setPopulation(
+        const std::vector<Parameter>& prmtr_accepted_old,
+        const std::vector<double>& weights_old)
+{
+    m_weights = weights_old;
+    m_scratch.resize(weights_old.size());
+
+    // Transpose parameters into one array per component
+    m_components.assign(dimension(),
+            std::vector<double>(prmtr_accepted_old.size()));
+    for (size_t i = 0; i < prmtr_accepted_old.size(); i++)
+    {
+        std::vector<double> components =
+            parseComponents(prmtr_accepted_old[i]);
+        for (int d = 0; d < dimension(); d++)
+            m_components[d][i] = components[d];
+    }
+}
+
+// Compute weighted sum of kernel densities
+double PerturbationKernel::weightedDensity(
+        const Parameter& prmtr_perturbed) const
+{
+    const std::vector<double> x = parseComponents(prmtr_perturbed);
+    const int n = m_weights.size();
+    double* const scratch = m_scratch.data();
+
+    double sum = 0.0;
+
+    if (m_type == gaussian)
+    {
+        // Accumulate exponents component by component
+        std::fill(m_scratch.begin(), m_scratch.end(), 0.0);
+        for (int d = 0; d < dimension(); d++)
+        {
+            const double* const component = m_components[d].data();
+            const double x_d = x[d];
+            const double scale = 0.5 / (m_widths[d] * m_widths[d]);
+            for (int i = 0; i < n; i++)
+            {
+                const double diff = x_d - component[i];
+                scratch[i] += diff * diff * scale;
+            }
+        }
+
+        for (int i = 0; i < n; i++)
+            sum += m_weights[i] * std::exp(-scratch[i]);
+    }
+    else
+    {
+        // Multiply indicators component by component
+        std::fill(m_scratch.begin(), m_scratch.end(), 1.0);
+        for (int d = 0; d < dimension(); d++)
+        {
+            const double* const component = m_components[d].data();
+            const double x_d = x[d];
+            const double width = m_widths[d];
+            for (int i = 0; i < n; i++)
+                scratch[i] *= std::fabs(x_d - component[i]) <= width;
+        }
+
+        for (int i = 0; i < n; i++)
+            sum += m_weights[i] * scratch[i];
+    }
+
+    return m_normalization * sum;
+}
+
+// Parse parameter into its components
+std::vector<double> PerturbationKernel::parseComponents(
+        const Parameter& parameter) const
+{
+    std::istringstream sstrm(parameter.str());
+    std::vector<double> components;
+    double component;
+    while (sstrm >> component)
+        components.push_back(component);
+
+    if (!sstrm.eof()
+            || components.size() != static_cast<std::size_t>(dimension()))
+    {
+        std::string error_msg;
+        error_msg += "Parameter does not consist of ";
+        error_msg += std::to_string(dimension());
+        error_msg += " numbers as required by perturbation kernel, "
+            "given parameter: ";
+        error_msg += parameter.str();
+        throw std::runtime_error(error_msg);
+    }
+
+    return components;
+}
@@ -0,0 +1,92 @@
+#ifndef PERTURBATIONKERNEL_H
+#define PERTURBATIONKERNEL_H
+
+#include <string>
+#include <vector>
+
+#include "interface/types.h"
+
+/** A class for evaluating built-in perturbation kernels.
+ *
+ * The weight of a parameter in the ABC SMC algorithm involves a sum over the
+ * whole previous generation, which costs O(N^2) kernel evaluations per
+ * generation.  With an external perturbation_pdf command, each of the N
+ * sums also costs a process launch.  For the common random-walk kernels, the
+ * PerturbationKernel evaluates these sums in-process instead.
+ *
+ * The kernel is the product of independent one-dimensional kernels, one for
+ * every parameter component.  It is specified as a string of the form
+ * `TYPE:W1,W2,...`, where `TYPE` is `gaussian` or `uniform` and `Wd` is the
+ * standard deviation or half-width, respectively, of the kernel in component
+ * `d`.  Parameters are parsed as whitespace-separated numbers.
+ *
+ * The previous generation is stored as a structure of arrays, that is, one
+ * contiguous array per component, so that the inner loops of
+ * weightedDensity() run over contiguous memory and can be vectorized by the
+ * compiler.
+ */
+
+class PerturbationKernel
+{
+    public:
+
+        /** Enumeration type for kernel type. */
+        enum kernel_t
+        {
+            gaussian,
+            uniform,
+        };
+
+        /** Construct from kernel specification string.
+         *
+         * @param spec  kernel specification of the form `TYPE:W1,W2,...`.
+         */
+        PerturbationKernel(const std::string& spec);
+
+        /** @return number of parameter components. */
+        int dimension() const;
+
+        /** Set previous generation.
+         *
+         * @param prmtr_accepted_old  parameters of previous generation.
+         * @param weights_old  weights of previous generation.
+         */
+        void setPopulation(const std::vector<Parameter>& prmtr_accepted_old,
+                const std::vector<double>& weights_old);
+
+        /** Compute weighted sum of kernel densities.
+         *
+         * @param prmtr_perturbed  perturbed parameter.
+         *
+         * @return sum over the previous generation of the weight of each
+         * parameter times the probability density for reaching the perturbed
+         * parameter by perturbing that parameter.
+         */
+        double weightedDensity(const Parameter& prmtr_perturbed) const;
+
+    private:
+
+        // Parse parameter into its components
+        std::vector<double> parseComponents(const Parameter& parameter) const;
+
+        // Kernel type
+        kernel_t m_type;
+
+        // Standard deviations or half-widths of kernel
+        std::vector<double> m_widths;
+
+        // Normalization constant of kernel
+        double m_normalization;
+
+        // Weights of previous generation
+        std::vector<double> m_weights;
+
+        // Components of parameters of previous generation, stored as one
+        // array per component
+        std::vector<std::vector<double>> m_components;
+
+        // Scratch array for the per-parameter exponents or indicators
+        mutable std::vector<double> m_scratch;
+};
+
+#endif // PERTURBATIONKERNEL_H
@@ -0,0 +1,46 @@
+#include <string>
+
+#include "interface/protocols.h"
+
+#include "ProposalGenerator.h"
+
+// Construct from commands
+ProposalGenerator::ProposalGenerator(const Command& prior_sampler,
+        const Command& perturber, const Command& prior_pdf) :
+    m_prior_sampler(prior_sampler),
+    m_perturber(perturber),
+    m_prior_pdf(prior_pdf)
+{
+}
+
+// Generate parameter from proposal request
+bool ProposalGenerator::generate(const std::string& proposal_request,
+        Parameter& parameter, double& prior_pdf,
+        std::string& simulator_input) const
+{
+    // Parse proposal request
+    Epsilon epsilon;
+    int t = 0;
+    Parameter source_parameter;
+    parse_proposal_request(proposal_request, epsilon, t, source_parameter);
+
+    // If in generation 0, sample from prior and set dummy prior_pdf
+    if (t == 0)
+    {
+        parameter = sample_from_prior(m_prior_sampler);
+        prior_pdf = 0.0;
+    }
+    // Else, perturb source parameter and calculate prior_pdf
+    else
+    {
+        parameter = perturb_parameter(m_perturber, t, source_parameter);
+        prior_pdf = get_prior_pdf(m_prior_pdf, parameter);
+
+        // Parameter lies outside support of prior
+        if (prior_pdf == 0.0)
+            return false;
+    }
+
+    simulator_input = format_simulator_input(epsilon, parameter);
+    return true;
+}
@@ -0,0 +1,77 @@
+#ifndef PROPOSALGENERATOR_H
+#define PROPOSALGENERATOR_H
+
+#include <string>
+
+#include "core/Command.h"
+#include "interface/types.h"
+
+/** A class for generating parameters on the Managers.
+ *
+ * By default, the AbstractController samples every parameter itself, which
+ * involves calling the prior_sampler, perturber and prior_pdf user
+ * executables.  With the MPI master, these calls are made by the process with
+ * rank 0 only, so the Managers sit idle while it is busy spawning them.
+ *
+ * When proposals are distributed, the AbstractController pushes proposal
+ * requests instead (see format_proposal_request()), and the Manager that
+ * receives a request uses a ProposalGenerator to turn it into the input of
+ * the simulator.  The Manager then reports the generated parameter and its
+ * prior pdf together with the output of the simulator (see
+ * format_proposal_output()).
+ *
+ * A perturbed parameter may lie outside the support of the prior.  Since
+ * resampling the source parameter requires the whole parameter population,
+ * the ProposalGenerator does not retry in that case.  Instead, the proposal
+ * is reported with a prior pdf of zero without running the simulator, and the
+ * AbstractController discards it.
+ */
+
+class ProposalGenerator
+{
+    public:
+
+        /** Construct from commands.
+         *
+         * @param prior_sampler  command to sample from prior.
+         * @param perturber  command to perturb parameter (only needed if
+         * proposal requests have a nonzero generation).
+         * @param prior_pdf  command to get prior pdf (only needed if proposal
+         * requests have a nonzero generation).
+         */
+        ProposalGenerator(const Command& prior_sampler,
+                const Command& perturber = Command(),
+                const Command& prior_pdf = Command());
+
+        /** Generate parameter from proposal request.
+         *
+         * In generation zero, the parameter is sampled from the prior and its
+         * prior pdf is set to zero, since it is not needed.  In later
+         * generations, the source parameter is perturbed and the prior pdf of
+         * the perturbed parameter is computed.
+         *
+         * @param proposal_request  proposal request string.
+         * @param parameter  generated parameter.
+         * @param prior_pdf  prior probability density of generated parameter.
+         * @param simulator_input  input string to simulator, only set if this
+         * function returns true.
+         *
+         * @return whether the generated parameter should be simulated.
+         */
+        bool generate(const std::string& proposal_request,
+                Parameter& parameter, double& prior_pdf,
+                std::string& simulator_input) const;
+
+    private:
+
+        // Command to sample from prior
+        const Command m_prior_sampler;
+
+        // Command to perturb parameter
+        const Command m_perturber;
+
+        // Command to get prior pdf
+        const Command m_prior_pdf;
+};
+
+#endif // PROPOSALGENERATOR_H
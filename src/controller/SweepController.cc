@@ -16,7 +16,8 @@
 
 SweepController::SweepController(const Input &input_obj) :
     m_parameter_names(input_obj.parameter_names),
-    m_simulator(input_obj.simulator)
+    m_simulator(input_obj.simulator),
+    m_simulator_outputs(input_obj.simulator_outputs)
 {
     // Read output from generator
     std::string generator_output = system_call(input_obj.generator);
@@ -44,6 +45,21 @@ void SweepController::iterate()
         // Unset flag
         m_first_iteration = false;
 
+        // Open file for simulator outputs.  Outputs are written as raw
+        // bytes, so that binary outputs are not altered
+        if (!m_simulator_outputs.empty())
+        {
+            m_simulator_outputs_stream.open(m_simulator_outputs,
+                    std::ios::out | std::ios::binary | std::ios::trunc);
+
+            if (!m_simulator_outputs_stream)
+            {
+                std::runtime_error e("could not open file for simulator "
+                        "outputs");
+                throw e;
+            }
+        }
+
         // Push all parameters
         for (auto it = m_prmtr_list.begin(); it != m_prmtr_list.end(); it++)
         {
@@ -74,6 +90,15 @@ void SweepController::iterate()
             throw e;
         }
 
+        // Write simulator output.  Finished tasks are delivered in the order
+        // of the parameters, since unordered results are not accepted
+        if (m_simulator_outputs_stream.is_open())
+        {
+            const std::string output_string = task.getOutputString();
+            m_simulator_outputs_stream.write(output_string.data(),
+                    output_string.size());
+        }
+
         // Pop finished parameters
         m_p_master->popFinishedTask();
     }
@@ -86,6 +111,10 @@ void SweepController::iterate()
         write_parameters(OutputStreamHandler::instance()->getOutputStream(),
                 m_parameter_names, m_prmtr_list);
 
+        // Close file for simulator outputs
+        if (m_simulator_outputs_stream.is_open())
+            m_simulator_outputs_stream.close();
+
         // Terminate Master
         m_p_master->terminate();
         m_entered = false;
@@ -99,3 +128,8 @@ Command SweepController::getSimulator() const
 {
     return m_simulator;
 }
+
+bool SweepController::acceptsBinaryOutput() const
+{
+    return true;
+}
@@ -3,6 +3,7 @@
 
 #include <string>
 #include <vector>
+#include <fstream>
 
 #include "interface/types.h"
 
@@ -12,8 +13,11 @@
  *
  * The SweepController class implements a simple parameter sweep algorithm.
  * The parameter sets to simulate are given by the Input::generator command.
- * The simulator is then called for each of these parameter sets, and the
- * output of the simulator is discarded.
+ * The simulator is then called for each of these parameter sets.  The output
+ * of the simulator is discarded, unless Input::simulator_outputs names a file
+ * to which the outputs of all simulations are written in the order of the
+ * parameter sets.  Since the outputs are written as they are, MPI simulators
+ * may output binary arrays of doubles in this way.
  *
  * For instructions on how to use Pakman with the sweep controller, execute the
  * following command
@@ -44,6 +48,10 @@ class SweepController : public AbstractController
         /** @return simulator command. */
         virtual Command getSimulator() const override;
 
+        /** @return true, since the simulator output is only written to a
+         * file. */
+        virtual bool acceptsBinaryOutput() const override;
+
         /** @return help message string. */
         static std::string help();
 
@@ -83,6 +91,10 @@ class SweepController : public AbstractController
 
             /** Command to generate parameter sets to simulate. */
             Command generator;
+
+            /** File to write simulator outputs to, or empty string if
+             * simulator outputs are discarded. */
+            std::string simulator_outputs;
         };
 
     private:
@@ -105,6 +117,13 @@ class SweepController : public AbstractController
         // Simulator command
         Command m_simulator;
 
+        // File to write simulator outputs to, or empty string
+        std::string m_simulator_outputs;
+
+        // Stream of simulator outputs.  It is opened in the first iteration,
+        // since only the MPIMaster process iterates the SweepController
+        std::ofstream m_simulator_outputs_stream;
+
         // Entered iterate()
         bool m_entered = false;
 };
@@ -22,11 +22,21 @@ Description:
   Upon completion, the controller outputs the parameter names, followed by
   newline-separated list of simulated parameters.
 
+  The outputs of 'simulator' are discarded, unless --simulator-outputs is
+  given.  The outputs are then written to FILE one after the other, in the
+  order of the parameters and without separators.  Outputs of MPI simulators
+  that output arrays of doubles are written as the raw bytes of the arrays in
+  the native representation, so that they can be read with, for example,
+  'od -A n -t f8 FILE'.
+
 Required arguments:
   -P, --parameter-names=NAMES   NAMES is a comma-separated list of
                                 parameter names
   -S, --simulator=CMD           CMD is simulator command
   -G, --generator=CMD           CMD is generator command
+
+Optional arguments:
+  -O, --simulator-outputs=FILE  FILE is file to write simulator outputs to
 )";
 }
 
@@ -35,6 +45,7 @@ void SweepController::addLongOptions(LongOptions& lopts)
     lopts.add({"parameter-names", required_argument, nullptr, 'P'});
     lopts.add({"simulator", required_argument, nullptr, 'S'});
     lopts.add({"generator", required_argument, nullptr, 'G'});
+    lopts.add({"simulator-outputs", required_argument, nullptr, 'O'});
 }
 
 SweepController* SweepController::makeController(const Arguments& args)
@@ -64,6 +75,10 @@ SweepController::Input SweepController::Input::makeInput(const Arguments& args)
 
         input_obj.generator =
             parse_command(args.optionalArgument("generator"));
+
+        if (args.isOptionalArgumentSet("simulator-outputs"))
+            input_obj.simulator_outputs =
+                args.optionalArgument("simulator-outputs");
     }
     catch (const std::out_of_range& e)
     {
@@ -1,9 +1,26 @@
 #include <vector>
+#include <string>
 #include <random>
+#include <algorithm>
 #include <stdexcept>
 
 #include "sample_population.h"
 
+resampling_t parse_resampling(const std::string& raw_input)
+{
+    if (raw_input == "multinomial")
+        return multinomial;
+    else if (raw_input == "systematic")
+        return systematic;
+    else if (raw_input == "residual")
+        return residual;
+
+    std::string error_msg;
+    error_msg += "Unknown resampling scheme: ";
+    error_msg += raw_input;
+    throw std::invalid_argument(error_msg);
+}
+
 void cumsum(const std::vector<double>& array,
         std::vector<double>& cumsum_array)
 {
@@ -33,11 +50,131 @@ int sample_population(const std::vector<double>& norm_cumsum_array,
 
     double u = distribution(generator);
 
-    for (int idx = 0; idx < norm_cumsum_array.size(); idx++)
-        if (u <= norm_cumsum_array[idx])
-            return idx;
+    // Find first index whose cumulative sum is not less than u
+    auto it = std::lower_bound(norm_cumsum_array.begin(),
+            norm_cumsum_array.end(), u);
+
+    if (it != norm_cumsum_array.end())
+        return it - norm_cumsum_array.begin();
 
     // If execution reaches this, something must have gone wrong
     std::runtime_error e("could not sample population");
     throw e;
 }
+
+// Build alias table using Vose's method
+void make_alias_table(const std::vector<double>& norm_array,
+        std::vector<double>& probabilities,
+        std::vector<int>& aliases)
+{
+    const int n = norm_array.size();
+    probabilities.resize(n);
+    aliases.resize(n);
+
+    // Scale probabilities so that their mean is one and split indices into
+    // those below and above the mean
+    std::vector<int> small, large;
+    for (int i = 0; i < n; i++)
+    {
+        probabilities[i] = norm_array[i] * n;
+        aliases[i] = i;
+        if (probabilities[i] < 1.0)
+            small.push_back(i);
+        else
+            large.push_back(i);
+    }
+
+    // Fill up every small column with the excess of a large column
+    while (!small.empty() && !large.empty())
+    {
+        int s = small.back();
+        small.pop_back();
+        int l = large.back();
+
+        aliases[s] = l;
+        probabilities[l] -= 1.0 - probabilities[s];
+
+        if (probabilities[l] < 1.0)
+        {
+            large.pop_back();
+            small.push_back(l);
+        }
+    }
+
+    // Remaining columns are full up to rounding errors
+    for (int l : large)
+        probabilities[l] = 1.0;
+    for (int s : small)
+        probabilities[s] = 1.0;
+}
+
+int sample_population(const std::vector<double>& probabilities,
+           const std::vector<int>& aliases,
+           std::uniform_real_distribution<double>& distribution,
+           std::default_random_engine& generator)
+{
+    // Use integer part of scaled uniform variate to choose column and
+    // fractional part to choose between column and its alias
+    double u = distribution(generator) * probabilities.size();
+    int idx = std::min(static_cast<int>(u), (int) probabilities.size() - 1);
+
+    return (u - idx < probabilities[idx]) ? idx : aliases[idx];
+}
+
+void resample_population(resampling_t resampling,
+        const std::vector<double>& norm_array,
+        const std::vector<double>& norm_cumsum_array,
+        std::vector<int>& indices,
+        std::uniform_real_distribution<double>& distribution,
+        std::default_random_engine& generator)
+{
+    const int n = norm_array.size();
+    indices.clear();
+    indices.reserve(n);
+
+    if (resampling == residual)
+    {
+        // Take floor(n * w_i) copies of every index deterministically and
+        // keep the remainders as weights for sampling the rest at random
+        std::vector<double> residual_array(n);
+        for (int i = 0; i < n; i++)
+        {
+            int copies = static_cast<int>(n * norm_array[i]);
+            indices.insert(indices.end(), copies, i);
+            residual_array[i] = n * norm_array[i] - copies;
+        }
+        int number_random = n - indices.size();
+
+        // Sample the remaining indices from the residual weights
+        if (number_random > 0)
+        {
+            std::vector<double> residual_cumsum(n);
+            normalize(residual_array);
+            cumsum(residual_array, residual_cumsum);
+            for (int k = 0; k < number_random; k++)
+                indices.push_back(sample_population(residual_cumsum,
+                            distribution, generator));
+        }
+    }
+    else if (resampling == systematic)
+    {
+        // Use a single uniform variate for n evenly spaced points
+        double u = distribution(generator) / n;
+        int idx = 0;
+        for (int k = 0; k < n; k++, u += 1.0 / n)
+        {
+            while ((idx < n - 1) && (norm_cumsum_array[idx] < u))
+                idx++;
+            indices.push_back(idx);
+        }
+    }
+    else
+    {
+        for (int k = 0; k < n; k++)
+            indices.push_back(sample_population(norm_cumsum_array,
+                        distribution, generator));
+    }
+
+    // Shuffle indices, since they are consumed one at a time
+    std::shuffle(indices.begin(), indices.end(), generator);
+}
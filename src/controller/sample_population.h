@@ -2,8 +2,19 @@
 #define SAMPLE_POPULATION_H
 
 #include <vector>
+#include <string>
 #include <random>
 
+/** Enumeration type for resampling scheme. */
+enum resampling_t
+{
+    multinomial,
+    systematic,
+    residual,
+};
+
+resampling_t parse_resampling(const std::string& raw_input);
+
 void cumsum(const std::vector<double>& array,
         std::vector<double>& cumsum_array);
 void normalize(std::vector<double>& array);
@@ -11,4 +22,19 @@ int sample_population(const std::vector<double>& norm_cumsum_array,
            std::uniform_real_distribution<double>& distribution,
            std::default_random_engine& generator);
 
+void make_alias_table(const std::vector<double>& norm_array,
+        std::vector<double>& probabilities,
+        std::vector<int>& aliases);
+int sample_population(const std::vector<double>& probabilities,
+           const std::vector<int>& aliases,
+           std::uniform_real_distribution<double>& distribution,
+           std::default_random_engine& generator);
+
+void resample_population(resampling_t resampling,
+        const std::vector<double>& norm_array,
+        const std::vector<double>& norm_cumsum_array,
+        std::vector<int>& indices,
+        std::uniform_real_distribution<double>& distribution,
+        std::default_random_engine& generator);
+
 #endif // SAMPLE_POPULATION_H
@@ -8,6 +8,8 @@
 #include "system/system_call.h"
 #include "interface/protocols.h"
 
+#include "PerturbationKernel.h"
+
 #include "smc_weight.h"
 
 double smc_weight(const Command& perturbation_pdf,
@@ -51,3 +53,48 @@ double smc_weight(const Command& perturbation_pdf,
     // Return weight
     return prmtr_prior_pdf / denominator;
 }
+
+std::vector<double> smc_weights(const Command& batch_perturbation_pdf,
+                  const std::vector<double>& prmtrs_prior_pdf,
+                  const int t,
+                  const std::vector<Parameter>& prmtr_accepted_old,
+                  const std::vector<double>& weights_old,
+                  const std::vector<Parameter>& prmtrs_perturbed)
+{
+    // Sanity check: prmtr_accepted_old and weights_old should have the same
+    // size, as should prmtrs_prior_pdf and prmtrs_perturbed
+    assert(prmtr_accepted_old.size() == weights_old.size());
+    assert(prmtrs_prior_pdf.size() == prmtrs_perturbed.size());
+
+    // If in generation 0, return uniform weights
+    if (t == 0)
+        return std::vector<double>(prmtrs_perturbed.size(),
+                1.0 / ((double) prmtr_accepted_old.size()));
+
+    // Get denominators of all weights in a single call
+    std::vector<double> denominators =
+        get_batch_perturbation_pdf(batch_perturbation_pdf, t,
+                prmtrs_perturbed, prmtr_accepted_old, weights_old);
+
+    // Return weights
+    std::vector<double> weights(prmtrs_perturbed.size());
+    for (size_t i = 0; i < weights.size(); i++)
+        weights[i] = prmtrs_prior_pdf[i] / denominators[i];
+
+    return weights;
+}
+
+double smc_weight(const PerturbationKernel& perturbation_kernel,
+                  const double prmtr_prior_pdf,
+                  const int t,
+                  const int population_size,
+                  const Parameter& prmtr_perturbed)
+{
+    // If in generation 0, return uniform weight
+    if (t == 0)
+        return 1.0 / ((double) population_size);
+
+    // Return weight
+    return prmtr_prior_pdf /
+        perturbation_kernel.weightedDensity(prmtr_perturbed);
+}
@@ -5,6 +5,7 @@
 #include <string>
 
 class Command;
+class PerturbationKernel;
 
 double smc_weight(const Command& perturbation_pdf,
                   const double prmtr_prior_pdf,
@@ -13,4 +14,17 @@ double smc_weight(const Command& perturbation_pdf,
                   const std::vector<double>& weights_old,
                   const Parameter& prmtr_perturbed);
 
+std::vector<double> smc_weights(const Command& batch_perturbation_pdf,
+                  const std::vector<double>& prmtrs_prior_pdf,
+                  const int t,
+                  const std::vector<Parameter>& prmtr_accepted_old,
+                  const std::vector<double>& weights_old,
+                  const std::vector<Parameter>& prmtrs_perturbed);
+
+double smc_weight(const PerturbationKernel& perturbation_kernel,
+                  const double prmtr_prior_pdf,
+                  const int t,
+                  const int population_size,
+                  const Parameter& prmtr_perturbed);
+
 #endif // SMC_WEIGHT_H
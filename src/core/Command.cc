@@ -26,6 +26,10 @@ Command::Command(const std::string& raw_command)
 
     // Copy command tokens to argv
     copyCommandTokensToArgv();
+
+    // Search for executable once, so that copies of the command, such as
+    // those held by Worker handlers, do not search PATH again
+    m_executable_path = resolveExecutablePath();
 }
 
 // Construct from c-style string
@@ -36,7 +40,8 @@ Command::Command(const char raw_command[]) :
 
 // Copy constructor
 Command::Command(const Command& command) :
-    m_raw_command(command.m_raw_command), m_cmd_tokens(command.m_cmd_tokens)
+    m_raw_command(command.m_raw_command), m_cmd_tokens(command.m_cmd_tokens),
+    m_executable_path(command.m_executable_path)
 {
     // Allocate memory for argv
     m_argv = new char*[m_cmd_tokens.size() + 1];
@@ -48,7 +53,8 @@ Command::Command(const Command& command) :
 // Move constructor
 Command::Command(Command&& command) :
     m_raw_command(std::move(command.m_raw_command)),
-    m_cmd_tokens(std::move(command.m_cmd_tokens))
+    m_cmd_tokens(std::move(command.m_cmd_tokens)),
+    m_executable_path(std::move(command.m_executable_path))
 {
     // Move argv
     m_argv = command.m_argv;
@@ -68,6 +74,9 @@ Command& Command::operator=(const Command& command)
     // Copy assign command tokens
     m_cmd_tokens = command.m_cmd_tokens;
 
+    // Copy assign executable path
+    m_executable_path = command.m_executable_path;
+
     // Allocate memory for argv
     m_argv = new char*[m_cmd_tokens.size() + 1];
 
@@ -92,6 +101,9 @@ Command& Command::operator=(Command&& command)
         // Move assign command tokens
         m_cmd_tokens = std::move(command.m_cmd_tokens);
 
+        // Move assign executable path
+        m_executable_path = std::move(command.m_executable_path);
+
         // Move argv
         m_argv = command.m_argv;
         command.m_argv = nullptr;
@@ -152,6 +164,21 @@ void Command::freeArgv()
 
 bool Command::isExecutable() const
 {
+    return !executablePath().empty();
+}
+
+const std::string& Command::executablePath() const
+{
+    return m_executable_path;
+}
+
+// Search for executable of argv[0], return empty string if not found
+std::string Command::resolveExecutablePath() const
+{
+    // An empty command has no executable
+    if (m_argv[0] == nullptr)
+        return std::string();
+
     // Copy executable into file
     std::string file = m_argv[0];
 
@@ -159,7 +186,7 @@ bool Command::isExecutable() const
     // access
     size_t found = file.find('/');
     if (found != std::string::npos)
-        return (access(file.c_str(), F_OK | X_OK) == 0);
+        return access(file.c_str(), F_OK | X_OK) == 0 ? file : std::string();
 
     // Else, we need to check PATH
     char *path = getenv("PATH");
@@ -201,10 +228,10 @@ bool Command::isExecutable() const
         }
 
         if (access(cmd.c_str(), F_OK | X_OK) == 0)
-            return true;
+            return cmd;
 
     } while (++right != 0);
 
     // Executable was not found
-    return false;
+    return std::string();
 }
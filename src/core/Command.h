@@ -76,6 +76,17 @@ class Command
         /** @return whether argv[0] is a valid executable. */
         bool isExecutable() const;
 
+        /** @return path to executable of argv[0].
+         *
+         * If argv[0] contains no slash, it is looked up in `PATH` in the same
+         * way as `execvp()` does.  The path is resolved once when the Command
+         * is constructed from a raw command string and is carried over to
+         * copies, so that repeatedly launching the same command does not
+         * search `PATH` every time.  If no executable is found, the empty
+         * string is returned.
+         */
+        const std::string& executablePath() const;
+
     private:
 
         // Copy command tokens to argv
@@ -84,6 +95,9 @@ class Command
         // Free argv
         void freeArgv();
 
+        // Search for executable of argv[0]
+        std::string resolveExecutablePath() const;
+
         // Save raw command as string
         std::string m_raw_command;
 
@@ -92,6 +106,9 @@ class Command
 
         // Save parsed command as argv
         char **m_argv;
+
+        // Path to executable
+        std::string m_executable_path;
 };
 
 #endif // COMMAND_H
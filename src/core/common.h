@@ -21,6 +21,9 @@ extern bool g_force_host_spawn;
 /** Global flag for ignoring errors from simulator. */
 extern bool g_ignore_errors;
 
+/** Global flag for delivering finished tasks in order of completion. */
+extern bool g_unordered_completion;
+
 /** Global flag for discarding standard error from all child processes. */
 extern bool g_discard_child_stderr;
 
@@ -38,6 +41,7 @@ enum master_t
 {
     no_master,
     serial,
+    local,
     mpi,
 };
 
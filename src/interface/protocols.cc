@@ -1,6 +1,8 @@
 #include <string>
 #include <vector>
 #include <sstream>
+#include <iomanip>
+#include <limits>
 #include <stdexcept>
 
 #include "system/system_call.h"
@@ -61,6 +63,192 @@ bool parse_simulator_output(const std::string& simulator_output)
     }
 }
 
+// persistent simulator protocol
+std::string format_persistent_simulator_input(
+        const std::string& input_string)
+{
+    std::string input_frame;
+    input_frame += std::to_string(input_string.size());
+    input_frame += '\n';
+    input_frame += input_string;
+
+    return input_frame;
+}
+
+bool parse_persistent_simulator_output(std::string& buffer,
+        std::string& output_string, int& error_code)
+{
+    // Check if header line is complete
+    size_t header_end = buffer.find('\n');
+    if (header_end == std::string::npos)
+        return false;
+
+    // Parse header line
+    std::string header = buffer.substr(0, header_end);
+    std::istringstream sstrm(header);
+    long length = -1;
+    int code = 0;
+    sstrm >> length >> code;
+
+    // Ensure that header contains exactly a nonnegative length and an error
+    // code
+    if (sstrm.fail() || (length < 0) || !(sstrm >> std::ws).eof())
+    {
+        std::string error_msg;
+        error_msg += "Cannot parse header of persistent simulator output "
+            "frame: ";
+        error_msg += header;
+        throw std::runtime_error(error_msg);
+    }
+
+    // Check if output string is complete
+    size_t frame_size = header_end + 1 + length;
+    if (buffer.size() < frame_size)
+        return false;
+
+    // Extract output string and error code, and remove frame from buffer
+    output_string = buffer.substr(header_end + 1, length);
+    error_code = code;
+    buffer.erase(0, frame_size);
+
+    return true;
+}
+
+bool parse_persistent_simulator_input(std::string& buffer,
+        std::string& input_string)
+{
+    // Check if header line is complete
+    size_t header_end = buffer.find('\n');
+    if (header_end == std::string::npos)
+        return false;
+
+    // Parse header line
+    std::string header = buffer.substr(0, header_end);
+    std::istringstream sstrm(header);
+    long length = -1;
+    sstrm >> length;
+
+    // Ensure that header contains exactly a nonnegative length
+    if (sstrm.fail() || (length < 0) || !(sstrm >> std::ws).eof())
+    {
+        std::string error_msg;
+        error_msg += "Cannot parse header of persistent simulator input "
+            "frame: ";
+        error_msg += header;
+        throw std::runtime_error(error_msg);
+    }
+
+    // Check if input string is complete
+    size_t frame_size = header_end + 1 + length;
+    if (buffer.size() < frame_size)
+        return false;
+
+    // Extract input string and remove frame from buffer
+    input_string = buffer.substr(header_end + 1, length);
+    buffer.erase(0, frame_size);
+
+    return true;
+}
+
+std::string format_persistent_simulator_output(
+        const std::string& output_string, int error_code)
+{
+    std::string output_frame;
+    output_frame += std::to_string(output_string.size());
+    output_frame += ' ';
+    output_frame += std::to_string(error_code);
+    output_frame += '\n';
+    output_frame += output_string;
+
+    return output_frame;
+}
+
+// proposal protocol
+std::string format_proposal_request(const Epsilon& epsilon, int t,
+        const Parameter& source_parameter)
+{
+    std::string proposal_request;
+    proposal_request += epsilon.str();
+    proposal_request += '\n';
+    proposal_request += std::to_string(t);
+    proposal_request += '\n';
+
+    // Source parameter is only needed for perturbation
+    if (t > 0)
+    {
+        proposal_request += source_parameter.str();
+        proposal_request += '\n';
+    }
+
+    return proposal_request;
+}
+
+void parse_proposal_request(const std::string& proposal_request,
+        Epsilon& epsilon, int& t, Parameter& source_parameter)
+{
+    std::istringstream sstrm(proposal_request);
+    std::string line;
+
+    // Parse epsilon and generation
+    std::getline(sstrm, line);
+    epsilon = line;
+
+    std::getline(sstrm, line);
+    t = std::stoi(line);
+
+    // Parse source parameter
+    if (t > 0)
+    {
+        std::getline(sstrm, line);
+        source_parameter = line;
+    }
+
+    // Ensure that end of input has been reached
+    if (sstrm.fail() || (sstrm.peek() != EOF))
+    {
+        std::string error_msg;
+        error_msg += "Cannot parse proposal request: ";
+        error_msg += proposal_request;
+        throw std::runtime_error(error_msg);
+    }
+}
+
+std::string format_proposal_output(const Parameter& parameter,
+        double prior_pdf, const std::string& simulator_output)
+{
+    // Print prior pdf with enough digits to be read back exactly
+    std::ostringstream sstrm;
+    sstrm << parameter.str() << '\n';
+    sstrm << std::setprecision(std::numeric_limits<double>::max_digits10)
+        << prior_pdf << '\n';
+    sstrm << simulator_output;
+
+    return sstrm.str();
+}
+
+void parse_proposal_output(const std::string& proposal_output,
+        Parameter& parameter, double& prior_pdf,
+        std::string& simulator_output)
+{
+    // Find end of parameter and prior pdf lines
+    size_t parameter_end = proposal_output.find('\n');
+    size_t prior_pdf_end = (parameter_end == std::string::npos) ?
+        std::string::npos : proposal_output.find('\n', parameter_end + 1);
+
+    if (prior_pdf_end == std::string::npos)
+    {
+        std::string error_msg;
+        error_msg += "Cannot parse output of proposal task: ";
+        error_msg += proposal_output;
+        throw std::runtime_error(error_msg);
+    }
+
+    parameter = proposal_output.substr(0, parameter_end);
+    prior_pdf = std::stod(proposal_output.substr(parameter_end + 1,
+                prior_pdf_end - parameter_end - 1));
+    simulator_output = proposal_output.substr(prior_pdf_end + 1);
+}
+
 // prior_sampler protocol
 Parameter parse_prior_sampler_output(const std::string& prior_sampler_output)
 {
@@ -249,6 +437,57 @@ std::vector<double> parse_perturbation_pdf_output(
     return perturbation_pdf_vector;
 }
 
+// batch perturbation_pdf protocol
+std::string format_batch_perturbation_pdf_input(
+        int t,
+        const std::vector<Parameter>& perturbed_parameters,
+        const std::vector<Parameter>& parameter_population,
+        const std::vector<double>& weights)
+{
+    std::ostringstream sstrm;
+    sstrm << t << '\n';
+
+    sstrm << perturbed_parameters.size() << '\n';
+    for (const Parameter& parameter : perturbed_parameters)
+        sstrm << parameter.str() << '\n';
+
+    // Print weights with enough digits to be read back exactly
+    sstrm << parameter_population.size() << '\n';
+    sstrm << std::setprecision(std::numeric_limits<double>::max_digits10);
+    for (const double& weight : weights)
+        sstrm << weight << '\n';
+
+    for (const Parameter& parameter : parameter_population)
+        sstrm << parameter.str() << '\n';
+
+    return sstrm.str();
+}
+
+std::vector<double> parse_batch_perturbation_pdf_output(
+        const std::string& batch_perturbation_pdf_output,
+        int number_perturbed)
+{
+    // Parse lines as perturbation_pdf output
+    std::vector<double> perturbation_pdf_vector;
+    if (!batch_perturbation_pdf_output.empty())
+        perturbation_pdf_vector =
+            parse_perturbation_pdf_output(batch_perturbation_pdf_output);
+
+    // Ensure that there is exactly one line for every perturbed parameter
+    if (perturbation_pdf_vector.size()
+            != static_cast<std::size_t>(number_perturbed))
+    {
+        std::string error_msg;
+        error_msg += "Batch perturbation_pdf output must contain exactly ";
+        error_msg += std::to_string(number_perturbed);
+        error_msg += " lines, given output: ";
+        error_msg += batch_perturbation_pdf_output;
+        throw std::runtime_error(error_msg);
+    }
+
+    return perturbation_pdf_vector;
+}
+
 // generator protocol
 std::vector<Parameter> parse_generator_output(
         const std::string& generator_output)
@@ -326,3 +565,20 @@ std::vector<double> get_perturbation_pdf(const Command& perturbation_pdf,
             perturbation_pdf_input);
     return parse_perturbation_pdf_output(perturbation_pdf_output);
 }
+
+// Call batch perturbation_pdf to get weighted perturbation pdfs of block of
+// perturbed parameters
+std::vector<double> get_batch_perturbation_pdf(
+        const Command& batch_perturbation_pdf, int t,
+        const std::vector<Parameter>& perturbed_parameters,
+        const std::vector<Parameter>& parameter_population,
+        const std::vector<double>& weights)
+{
+    std::string batch_perturbation_pdf_input =
+        format_batch_perturbation_pdf_input(t, perturbed_parameters,
+                parameter_population, weights);
+    std::string batch_perturbation_pdf_output =
+        system_call(batch_perturbation_pdf, batch_perturbation_pdf_input);
+    return parse_batch_perturbation_pdf_output(batch_perturbation_pdf_output,
+            perturbed_parameters.size());
+}
@@ -37,6 +37,124 @@ std::string format_simulator_input(
  */
 bool parse_simulator_output(const std::string& simulator_output);
 
+/** Format input frame to persistent simulator.
+ *
+ * A persistent simulator is started once and then reads any number of input
+ * frames from its standard input.  An input frame consists of a header line
+ * containing the length of the input string in bytes, followed by the input
+ * string itself.
+ *
+ * @param input_string  input string to simulator.
+ *
+ * @return input frame to persistent simulator.
+ */
+std::string format_persistent_simulator_input(
+        const std::string& input_string);
+
+/** Parse output frame from persistent simulator.
+ *
+ * For every input frame, a persistent simulator writes an output frame to its
+ * standard output.  An output frame consists of a header line containing the
+ * length of the output string in bytes and the error code, separated by a
+ * space, followed by the output string itself.
+ *
+ * If the buffer starts with a complete output frame, the frame is removed
+ * from the buffer.  Otherwise, the buffer is left untouched.
+ *
+ * @param buffer  output received so far from persistent simulator.
+ * @param output_string  output string of simulator, set if a complete frame
+ * was parsed.
+ * @param error_code  error code of simulator, set if a complete frame was
+ * parsed.
+ *
+ * @return whether a complete output frame was parsed.
+ */
+bool parse_persistent_simulator_output(std::string& buffer,
+        std::string& output_string, int& error_code);
+
+/** Parse input frame to persistent simulator.
+ *
+ * This is the counterpart of format_persistent_simulator_input(), for use on
+ * the receiving end of input frames.
+ *
+ * If the buffer starts with a complete input frame, the frame is removed from
+ * the buffer.  Otherwise, the buffer is left untouched.
+ *
+ * @param buffer  input received so far.
+ * @param input_string  input string, set if a complete frame was parsed.
+ *
+ * @return whether a complete input frame was parsed.
+ */
+bool parse_persistent_simulator_input(std::string& buffer,
+        std::string& input_string);
+
+/** Format output frame from persistent simulator.
+ *
+ * This is the counterpart of parse_persistent_simulator_output(), for use on
+ * the sending end of output frames.
+ *
+ * @param output_string  output string of simulator.
+ * @param error_code  error code of simulator.
+ *
+ * @return output frame from persistent simulator.
+ */
+std::string format_persistent_simulator_output(
+        const std::string& output_string, int error_code);
+
+/** Format proposal request.
+ *
+ * A proposal request asks a Manager to generate a parameter itself before
+ * simulating it, see ProposalGenerator.  It consists of the epsilon, the
+ * current generation and, if the generation is not zero, the source parameter
+ * to be perturbed, each on a separate line.
+ *
+ * @param epsilon  distance tolerance.
+ * @param t  current generation.
+ * @param source_parameter  source parameter to be perturbed (ignored if t is
+ * zero).
+ *
+ * @return proposal request string.
+ */
+std::string format_proposal_request(const Epsilon& epsilon, int t,
+        const Parameter& source_parameter);
+
+/** Parse proposal request.
+ *
+ * @param proposal_request  proposal request string.
+ * @param epsilon  distance tolerance.
+ * @param t  current generation.
+ * @param source_parameter  source parameter to be perturbed, only set if t is
+ * not zero.
+ */
+void parse_proposal_request(const std::string& proposal_request,
+        Epsilon& epsilon, int& t, Parameter& source_parameter);
+
+/** Format output of proposal task.
+ *
+ * The output of a proposal task consists of the generated parameter and its
+ * prior pdf, each on a separate line, followed by the output of the
+ * simulator.
+ *
+ * @param parameter  generated parameter.
+ * @param prior_pdf  prior probability density of generated parameter.
+ * @param simulator_output  output string from simulator.
+ *
+ * @return output string of proposal task.
+ */
+std::string format_proposal_output(const Parameter& parameter,
+        double prior_pdf, const std::string& simulator_output);
+
+/** Parse output of proposal task.
+ *
+ * @param proposal_output  output string of proposal task.
+ * @param parameter  generated parameter.
+ * @param prior_pdf  prior probability density of generated parameter.
+ * @param simulator_output  output string from simulator.
+ */
+void parse_proposal_output(const std::string& proposal_output,
+        Parameter& parameter, double& prior_pdf,
+        std::string& simulator_output);
+
 /** Parse output from prior_sampler.
  *
  * @param prior_sampler_output  output string from prior_sampler.
@@ -101,6 +219,46 @@ std::string format_perturbation_pdf_input(
 std::vector<double> parse_perturbation_pdf_output(
         const std::string& perturbation_pdf_output);
 
+/** Format input to batch perturbation_pdf.
+ *
+ * As opposed to perturbation_pdf, which is called once for every perturbed
+ * parameter, batch perturbation_pdf is called once for a block of perturbed
+ * parameters.  Its input consists of the current generation, the number of
+ * perturbed parameters, the perturbed parameters, the size of the parameter
+ * population, the weights of the parameter population and the parameter
+ * population, each on a separate line.
+ *
+ * @param t  current generation.
+ * @param perturbed_parameters  perturbed parameters.
+ * @param parameter_population  parameter population.
+ * @param weights  weights of parameter population.
+ *
+ * @return input string to batch perturbation_pdf.
+ */
+std::string format_batch_perturbation_pdf_input(
+        int t,
+        const std::vector<Parameter>& perturbed_parameters,
+        const std::vector<Parameter>& parameter_population,
+        const std::vector<double>& weights);
+
+/** Parse output from batch perturbation_pdf.
+ *
+ * For every perturbed parameter, batch perturbation_pdf outputs a line
+ * containing the sum over the parameter population of the weight of each
+ * parameter times the probability density for reaching the perturbed
+ * parameter by perturbing that parameter.
+ *
+ * @param batch_perturbation_pdf_output  output string from batch
+ * perturbation_pdf.
+ * @param number_perturbed  number of perturbed parameters.
+ *
+ * @return weighted perturbation kernel probability densities, one for every
+ * perturbed parameter.
+ */
+std::vector<double> parse_batch_perturbation_pdf_output(
+        const std::string& batch_perturbation_pdf_output,
+        int number_perturbed);
+
 /** Parse output from generator.
  *
  * @param generator_output  output string from generator.
@@ -152,4 +310,22 @@ std::vector<double> get_perturbation_pdf(const Command& perturbation_pdf,
         int t, const Parameter& perturbed_parameter,
         const std::vector<Parameter>& parameter_population);
 
+/** Get weighted perturbation probability density functions in one call.
+ *
+ * @param batch_perturbation_pdf  command to get weighted perturbation pdfs
+ * using the batch perturbation_pdf protocol.
+ * @param t  current generation.
+ * @param perturbed_parameters  perturbed parameters.
+ * @param parameter_population  parameter population.
+ * @param weights  weights of parameter population.
+ *
+ * @return weighted sums of perturbation kernel probability densities, one for
+ * every perturbed parameter.
+ */
+std::vector<double> get_batch_perturbation_pdf(
+        const Command& batch_perturbation_pdf, int t,
+        const std::vector<Parameter>& perturbed_parameters,
+        const std::vector<Parameter>& parameter_population,
+        const std::vector<double>& weights);
+
 #endif // PROTOCOLS_H
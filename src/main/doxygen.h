@@ -82,11 +82,74 @@
  * for an example of an MPI simulator and see @ref mpi-simulator "this
  * documentation page" for instructions on how to implement an MPI simulator.
  *
+ * If your simulator takes a long time to start up compared to the time it
+ * takes to run a single simulation, for example because it is written in an
+ * interpreted language, you can turn it into a persistent simulator that is
+ * started once and reused for many simulations.  See @ref
+ * persistent-simulator "this documentation page" for the protocol that a
+ * persistent simulator must follow.
+ *
  * If you wish to implement an ABC algorithm that is currently not part of
  * Pakman, please see @ref controller "this link" on how to write a new
  * Controller subclass.
  */
 
+/** @page persistent-simulator Implementing a persistent simulator
+ *
+ * # Persistent simulators
+ *
+ * A standard simulator is started anew for every simulation.  It reads its
+ * input from standard input until the end of input is reached, writes its
+ * output to standard output and exits.  For simulators whose startup time
+ * dominates their runtime, this is wasteful.
+ *
+ * When the flag `--persistent-simulator` is given, Pakman starts the
+ * simulator once per Worker and sends it any number of simulation tasks.
+ * Since the end of input can no longer be used to delimit tasks, input and
+ * output are exchanged in frames.
+ *
+ * An input frame consists of a header line containing the length of the
+ * input in bytes, followed by the input itself:
+ * ```
+ * <length>\n
+ * <input>
+ * ```
+ * Here, `<input>` is the same input that a standard simulator would receive,
+ * i.e.\ the tolerance and the parameter, each terminated by a newline.
+ *
+ * For every input frame, the simulator must write an output frame consisting
+ * of a header line containing the length of the output in bytes and the
+ * error code, followed by the output itself:
+ * ```
+ * <length> <error code>\n
+ * <output>
+ * ```
+ * Here, `<output>` is the same output that a standard simulator would write
+ * and `<error code>` takes the place of its exit status.  The simulator must
+ * flush its standard output after every output frame.
+ *
+ * A persistent simulator should exit when it reaches the end of its standard
+ * input.  Pakman restarts the simulator when it exits unexpectedly, when a
+ * simulation finishes with a nonzero error code, or when a simulation is
+ * interrupted, for example at the end of an ABC SMC generation.
+ *
+ * For example, a persistent simulator can be implemented in Python as follows.
+ * ```
+ * import sys
+ *
+ * while True:
+ *     header = sys.stdin.buffer.readline()
+ *     if not header:
+ *         break
+ *     epsilon, parameter = sys.stdin.buffer.read(int(header)).split()
+ *
+ *     output = simulate(epsilon, parameter)
+ *
+ *     sys.stdout.buffer.write(b"%d 0\n" % len(output) + output)
+ *     sys.stdout.buffer.flush()
+ * ```
+ */
+
 /** @page mpi-simulator Implementing an MPI simulator
  *
  * # MPI simulators
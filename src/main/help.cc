@@ -23,6 +23,8 @@ std::string general_options()
   -h, --help                    show help message
   -i, --ignore-errors           ignore nonzero return code from simulator
   -d, --discard-child-stderr    discard stderr from child processes
+  -u, --unordered               process simulation results in order of
+                                completion (rejection and smc only)
   -v, --verbosity=level         set verbosity level to debug/info/off
                                 (default info)
   -o, --output-file             set output file (default stdout)
@@ -43,6 +45,7 @@ void overview(int status)
     std::cout <<
 R"(Available masters:
   serial        run at most one simulation overall
+  local         run at most N simulations concurrently on the local machine
   mpi           run at most one simulation per launched MPI process
 See ')" << g_program_name << R"( <master> --help' for more info.
 
@@ -28,6 +28,7 @@ std::chrono::milliseconds g_kill_timeout(100);
 bool g_ignore_errors = false;
 bool g_force_host_spawn = false;
 bool g_discard_child_stderr = false;
+bool g_unordered_completion = false;
 
 bool g_program_terminated = false;
 
@@ -45,6 +46,7 @@ void add_general_long_options(LongOptions& lopts)
     lopts.add({"help", no_argument, nullptr, 'h'});
     lopts.add({"ignore-errors", no_argument, nullptr, 'i'});
     lopts.add({"discard-child-stderr", no_argument, nullptr, 'd'});
+    lopts.add({"unordered", no_argument, nullptr, 'u'});
     lopts.add({"verbosity", required_argument, nullptr, 'v'});
     lopts.add({"output-file", required_argument, nullptr, 'o'});
 }
@@ -62,6 +64,9 @@ void process_general_options(master_t master, controller_t controller,
     if (args.isOptionalArgumentSet("discard-child-stderr"))
         g_discard_child_stderr = true;
 
+    if (args.isOptionalArgumentSet("unordered"))
+        g_unordered_completion = true;
+
     if (args.isOptionalArgumentSet("verbosity"))
     {
         std::string arg = args.optionalArgument("verbosity");
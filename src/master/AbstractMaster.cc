@@ -1,8 +1,12 @@
 #include <string>
 #include <memory>
+#include <list>
+#include <queue>
 
 #include <assert.h>
 
+#include "controller/AbstractController.h"
+
 #include "AbstractMaster.h"
 
 // Construct from pointer to program terminated flag
@@ -16,6 +20,16 @@ void AbstractMaster::assignController(
         std::shared_ptr<AbstractController> p_controller)
 {
     m_p_controller = p_controller;
+
+    // Enable unordered completion if requested and accepted by controller
+    m_unordered_completion = g_unordered_completion
+        && p_controller->acceptsUnorderedResults();
+}
+
+// Getter for m_unordered_completion
+bool AbstractMaster::unorderedCompletion() const
+{
+    return m_unordered_completion;
 }
 
 // Getter for m_p_program_terminated
@@ -24,18 +38,45 @@ bool AbstractMaster::programTerminated() const
     return *m_p_program_terminated;
 }
 
-// Construct from input string
-AbstractMaster::TaskHandler::TaskHandler(const std::string& input_string) :
-    m_input_string(input_string)
+// Move finished tasks from busy tasks list to finished tasks queue
+void AbstractMaster::moveFinishedTasks(std::list<TaskHandler>& busy_tasks,
+        std::queue<TaskHandler>& finished_tasks) const
+{
+    auto it = busy_tasks.begin();
+    while (it != busy_tasks.end())
+    {
+        // A pending task holds back all tasks behind it, unless tasks may be
+        // delivered out of order
+        if (it->isPending())
+        {
+            if (!m_unordered_completion)
+                break;
+
+            it++;
+            continue;
+        }
+
+        // Move TaskHandler to finished tasks and erase it from busy tasks
+        finished_tasks.push(std::move(*it));
+        it = busy_tasks.erase(it);
+    }
+}
+
+// Construct from input string and metadata
+AbstractMaster::TaskHandler::TaskHandler(const std::string& input_string,
+        double metadata) :
+    m_input_string(input_string),
+    m_metadata(metadata)
 {
 }
 
 // Move constructor
 AbstractMaster::TaskHandler::TaskHandler(TaskHandler &&t) :
+    m_state(t.m_state),
     m_input_string(std::move(t.m_input_string)),
+    m_metadata(t.m_metadata),
     m_output_string(std::move(t.m_output_string)),
-    m_error_code(t.m_error_code),
-    m_state(t.m_state)
+    m_error_code(t.m_error_code)
 {
 }
 
@@ -46,6 +87,12 @@ AbstractMaster::TaskHandler::getState() const
     return m_state;
 }
 
+// Get metadata
+double AbstractMaster::TaskHandler::getMetadata() const
+{
+    return m_metadata;
+}
+
 // Probe whether task is pending
 bool AbstractMaster::TaskHandler::isPending() const
 {
@@ -67,6 +114,15 @@ bool AbstractMaster::TaskHandler::didErrorOccur() const
     return m_error_code != 0;
 }
 
+// Get error code
+int AbstractMaster::TaskHandler::getErrorCode() const
+{
+    // This should only be called in the finished state
+    assert(m_state == finished);
+
+    return m_error_code;
+}
+
 // Get input string
 std::string AbstractMaster::TaskHandler::getInputString() const
 {
@@ -3,6 +3,8 @@
 
 #include <memory>
 #include <string>
+#include <list>
+#include <queue>
 
 #include "core/common.h"
 
@@ -34,7 +36,8 @@ class Arguments;
  * AbstractMaster is responsible for popping tasks from the pending tasks
  * queue, running the corresponding simulation and pushing finished tasks to
  * the finished tasks queue.  The finished tasks should be pushed in the same
- * order as they were added to the pending tasks queue.  The flush() method
+ * order as they were added to the pending tasks queue, unless unordered
+ * completion is enabled (see unorderedCompletion()).  The flush() method
  * flushes all queues and discards all running simulations.
  *
  * The use of AbstractMaster is governed by static methods.  The static
@@ -70,8 +73,11 @@ class AbstractMaster
         /** Push a new pending task.
          *
          * @param input_string  input string to simulation job.
+         * @param metadata  number that the AbstractController attaches to the
+         * task, for example the prior pdf of the simulated parameter.
          */
-        virtual void pushPendingTask(const std::string& input_string) = 0;
+        virtual void pushPendingTask(const std::string& input_string,
+                double metadata = 0.0) = 0;
 
         /** @return whether finished tasks queue is empty. */
         virtual bool finishedTasksEmpty() const = 0;
@@ -88,6 +94,18 @@ class AbstractMaster
         /** Terminate AbstractMaster. */
         virtual void terminate() = 0;
 
+        /** @return whether finished tasks may be delivered out of order.
+         *
+         * In unordered completion mode, a task is pushed to the finished
+         * tasks queue as soon as it finishes, instead of waiting for all
+         * tasks that were pushed before it.  This prevents a single slow
+         * simulation from holding back all results behind it.  The mode is
+         * enabled by the general option `--unordered` and only if the
+         * assigned AbstractController accepts unordered results (see
+         * AbstractController::acceptsUnorderedResults()).
+         */
+        bool unorderedCompletion() const;
+
         /** Interpret string as Master type.
          *
          * The master_t enumeration type is defined in common.h.
@@ -182,6 +200,19 @@ class AbstractMaster
         /** @return whether the program has been terminated. */
         bool programTerminated() const;
 
+        /** Move finished tasks from busy tasks list to finished tasks queue.
+         *
+         * Finished tasks are moved from the front of the busy tasks list
+         * until a task that is still pending is found.  In unordered
+         * completion mode, finished tasks are moved from anywhere in the busy
+         * tasks list.
+         *
+         * @param busy_tasks  busy tasks in the order they were pushed.
+         * @param finished_tasks  queue of finished tasks.
+         */
+        void moveFinishedTasks(std::list<TaskHandler>& busy_tasks,
+                std::queue<TaskHandler>& finished_tasks) const;
+
         ///// Member variables /////
         /** Weak pointer to AbstractController. */
         std::weak_ptr<AbstractController> m_p_controller;
@@ -192,12 +223,18 @@ class AbstractMaster
         // Pointer to program terminated flag
         bool *m_p_program_terminated;
 
+        // Whether finished tasks may be delivered out of order
+        bool m_unordered_completion = false;
+
     public:
 
         /** A class for representing tasks.
          *
          * A task represents a simulation job, which consists of spawning a
-         * simulator, feeding it some input and retrieving the output.
+         * simulator, feeding it some input and retrieving the output.  Every
+         * task carries a number that the AbstractController attached to it,
+         * so that results can be matched to their origin even when they are
+         * delivered out of order.
          */
         class TaskHandler
         {
@@ -206,11 +243,14 @@ class AbstractMaster
                 /** Enumeration type for TaskHandler states. */
                 enum state_t { pending, finished };
 
-                /** Construct from input string.
+                /** Construct from input string and metadata.
                  *
                  * @param input_string  input string to simulator.
+                 * @param metadata  number attached to task by
+                 * AbstractController.
                  */
-                TaskHandler(const std::string& input_string);
+                TaskHandler(const std::string& input_string,
+                        double metadata = 0.0);
 
                 /** Move constructor. */
                 TaskHandler(TaskHandler &&t);
@@ -221,6 +261,9 @@ class AbstractMaster
                 /** @return state of TaskHandler. */
                 state_t getState() const;
 
+                /** @return number attached to task by AbstractController. */
+                double getMetadata() const;
+
                 /** @return whether task is pending. */
                 bool isPending() const;
 
@@ -257,6 +300,9 @@ class AbstractMaster
                 // Input string
                 const std::string m_input_string;
 
+                // Number attached to task by AbstractController
+                double m_metadata;
+
                 // Output string, only valid in finished state
                 std::string m_output_string;
 
@@ -6,6 +6,7 @@
 #include "core/Command.h"
 
 #include "SerialMaster.h"
+#include "LocalMaster.h"
 #include "MPIMaster.h"
 
 #include "AbstractMaster.h"
@@ -17,6 +18,10 @@ master_t AbstractMaster::getMaster(const std::string& arg)
     if (arg.compare("serial") == 0)
         return serial;
 
+    // Check for local master
+    else if (arg.compare("local") == 0)
+        return local;
+
     // Check for mpi master
     else if (arg.compare("mpi") == 0)
         return mpi;
@@ -31,6 +36,8 @@ std::string AbstractMaster::help(master_t master)
     {
         case serial:
             return SerialMaster::help();
+        case local:
+            return LocalMaster::help();
         case mpi:
             return MPIMaster::help();
         default:
@@ -48,6 +55,9 @@ void AbstractMaster::addLongOptions(master_t master,
         case serial:
             SerialMaster::addLongOptions(lopts);
             return;
+        case local:
+            LocalMaster::addLongOptions(lopts);
+            return;
         case mpi:
             MPIMaster::addLongOptions(lopts);
             return;
@@ -66,6 +76,9 @@ void AbstractMaster::run(master_t master, controller_t controller,
         case serial:
             SerialMaster::run(controller, args);
             return;
+        case local:
+            LocalMaster::run(controller, args);
+            return;
         case mpi:
             MPIMaster::run(controller, args);
             return;
@@ -83,6 +96,9 @@ void AbstractMaster::cleanup(master_t master)
         case serial:
             SerialMaster::cleanup();
             return;
+        case local:
+            LocalMaster::cleanup();
+            return;
         case mpi:
             MPIMaster::cleanup();
             return;
@@ -1,6 +1,12 @@
 #include <string>
+#include <thread>
+#include <chrono>
 
 #include <assert.h>
+#include <poll.h>
+
+#include "system/pipe_io.h"
+#include "system/ChildSupervisor.h"
 
 #include "AbstractWorkerHandler.h"
 
@@ -12,6 +18,89 @@ AbstractWorkerHandler::AbstractWorkerHandler(
 {
 }
 
+AbstractWorkerHandler::~AbstractWorkerHandler()
+{
+    unwatch();
+}
+
+bool AbstractWorkerHandler::waitForOutput(std::chrono::microseconds timeout)
+{
+    if (isDone())
+        return true;
+
+    // If there is nothing to poll, sleep for timeout
+    int read_fd = getReadFileDescriptor();
+    if (read_fd == -1)
+    {
+        std::this_thread::sleep_for(timeout);
+        return false;
+    }
+
+    // poll() has a resolution of milliseconds, so sleep for shorter timeouts
+    // after checking the read file descriptor once
+    int timeout_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+            timeout).count();
+
+    // Also wake up when pending input can be written.  poll() ignores
+    // negative file descriptors
+    struct pollfd fds[2];
+    fds[0].fd = read_fd;
+    fds[0].events = POLLIN;
+    fds[0].revents = 0;
+    fds[1].fd = getWriteFileDescriptor();
+    fds[1].events = POLLOUT;
+    fds[1].revents = 0;
+
+    check_poll(fds, 2, timeout_ms);
+
+    if (    (fds[0].revents & (POLLIN | POLLHUP)) ||
+            (fds[1].revents & (POLLOUT | POLLERR)) )
+        return true;
+
+    if (timeout_ms == 0)
+        std::this_thread::sleep_for(timeout);
+
+    return false;
+}
+
+int AbstractWorkerHandler::getReadFileDescriptor() const
+{
+    return -1;
+}
+
+int AbstractWorkerHandler::getWriteFileDescriptor() const
+{
+    return -1;
+}
+
+bool AbstractWorkerHandler::watch(ChildSupervisor& supervisor, int key)
+{
+    if (getReadFileDescriptor() == -1)
+        return false;
+
+    m_p_supervisor = &supervisor;
+    m_supervisor_key = key;
+    updateWatch();
+
+    return true;
+}
+
+void AbstractWorkerHandler::updateWatch()
+{
+    if (m_p_supervisor)
+        m_p_supervisor->watch(m_supervisor_key, getReadFileDescriptor(),
+                getWriteFileDescriptor());
+}
+
+void AbstractWorkerHandler::unwatch()
+{
+    if (!m_p_supervisor)
+        return;
+
+    m_p_supervisor->unwatch(m_supervisor_key);
+    m_p_supervisor = nullptr;
+}
+
 std::string AbstractWorkerHandler::getOutput()
 {
     assert(isDone());
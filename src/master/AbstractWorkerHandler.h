@@ -2,9 +2,12 @@
 #define ABSTRACTWORKERHANDLER_H
 
 #include <string>
+#include <chrono>
 
 #include "core/Command.h"
 
+class ChildSupervisor;
+
 /** An abstract class for representing Workers.
  *
  * Workers are instantiations of the simulator user executable.  Since they can
@@ -18,6 +21,11 @@
  *
  * The destructor of a WorkerHandler ensures that the simulation is terminated,
  * but the Worker process may persist, as in the case of MPIWorkerHandler.
+ *
+ * Event loops that supervise many Workers at once register the pipes of every
+ * Worker with a ChildSupervisor using watch().  From then on, the Worker
+ * handler keeps the registration up to date, and removes it before it closes
+ * the pipes or is destroyed, so that the event loop never has to.
  */
 
 class AbstractWorkerHandler
@@ -33,12 +41,58 @@ class AbstractWorkerHandler
         AbstractWorkerHandler(const Command& simulator,
                 const std::string& input_string);
 
-        /** Default destructor does nothing. */
-        virtual ~AbstractWorkerHandler() = default;
+        /** Destructor stops watching the pipes of the Worker. */
+        virtual ~AbstractWorkerHandler();
 
         /** @return whether Worker has finished. */
         virtual bool isDone() = 0;
 
+        /** Wait until the Worker may have made progress or the timeout has
+         * elapsed, whichever comes first.
+         *
+         * This function is used by event loops that wait for events instead
+         * of sleeping for a fixed amount of time.  If the Worker has a read
+         * file descriptor, the calling process sleeps in `poll()` on it, so
+         * that it is woken up by the kernel as soon as the Worker writes
+         * output or exits.  Otherwise, this function sleeps for the given
+         * timeout.
+         *
+         * @param timeout  maximum time to wait.
+         *
+         * @return whether the Worker may have made progress.
+         */
+        virtual bool waitForOutput(std::chrono::microseconds timeout);
+
+        /** @return file descriptor from which the output of the Worker is
+         * read, or -1 if there is no such file descriptor.
+         *
+         * The file descriptor is non-blocking, so it can be multiplexed with
+         * other file descriptors using `poll()`.  It is only valid as long as
+         * isDone() has not returned true.
+         */
+        virtual int getReadFileDescriptor() const;
+
+        /** @return file descriptor to which input of the Worker is still
+         * being written, or -1 if there is no pending input.
+         *
+         * Large inputs are written without blocking, a pipe buffer at a
+         * time, whenever isDone() is called.  Event loops should therefore
+         * also wake up when this file descriptor becomes writable.
+         */
+        virtual int getWriteFileDescriptor() const;
+
+        /** Watch the pipes of the Worker with a ChildSupervisor.
+         *
+         * @param supervisor  supervisor to register the pipes with.  It must
+         * outlive the Worker handler.
+         * @param key  key of the Worker in the supervisor.
+         *
+         * @return whether the pipes are watched.  If the Worker has no read
+         * file descriptor, nothing is watched and the caller has to check
+         * isDone() itself.
+         */
+        virtual bool watch(ChildSupervisor& supervisor, int key);
+
         /** @return output of finished Worker.
          *
          * @warning Calling this function before Worker is finished will result
@@ -55,6 +109,23 @@ class AbstractWorkerHandler
 
     protected:
 
+        /** Register the current pipes of the Worker with the supervisor.
+         *
+         * Derived classes call this function whenever the file descriptors
+         * returned by getReadFileDescriptor() or getWriteFileDescriptor()
+         * change while the Worker is running.  Does nothing if the pipes are
+         * not watched.
+         */
+        void updateWatch();
+
+        /** Stop watching the pipes of the Worker.
+         *
+         * Since `epoll` cannot deregister a file descriptor once it has been
+         * closed, derived classes call this function before closing the read
+         * pipe.  Does nothing if the pipes are not watched.
+         */
+        void unwatch();
+
         /** Command to run simulation. */
         const Command m_simulator;
 
@@ -66,6 +137,14 @@ class AbstractWorkerHandler
 
         /** Error code received from simulator. */
         int m_error_code = -1;
+
+    private:
+
+        // Supervisor watching the pipes, or null pointer if not watched
+        ChildSupervisor *m_p_supervisor = nullptr;
+
+        // Key of Worker in supervisor
+        int m_supervisor_key = -1;
 };
 
 #endif // ABSTRACTWORKERHANDLER_H
@@ -1,13 +1,14 @@
 #include <string>
-#include <thread>
 #include <stdexcept>
 #include <signal.h>
 #include <sys/wait.h>
 #include <sys/types.h>
+#include <limits.h>
 
 #include "core/common.h"
 #include "system/system_call.h"
 #include "system/pipe_io.h"
+#include "system/reaper.h"
 #include "mpi/mpi_common.h"
 
 #include "ForkedWorkerHandler.h"
@@ -22,27 +23,55 @@ ForkedWorkerHandler::ForkedWorkerHandler(
     std::tie(m_child_pid, m_pipe_write_fd, m_pipe_read_fd) =
         system_call_non_blocking_read_write(m_simulator);
 
-    // Write input string to stdin of process
-    write_to_pipe(m_pipe_write_fd, input_string);
-    close_check(m_pipe_write_fd);
+    // Make read pipe non-blocking so that isDone() never stalls on a Worker
+    // that has written only part of its output
+    set_non_blocking(m_pipe_read_fd);
+
+    // An input string that fits into the pipe is written at once.  A larger
+    // one is written without blocking, and the rest of it whenever isDone()
+    // is called, so that a simulator that writes output before reading all
+    // of its input cannot deadlock with the caller
+    if (input_string.size() > PIPE_BUF)
+    {
+        enlarge_pipe(m_pipe_write_fd, input_string.size());
+        set_non_blocking(m_pipe_write_fd);
+    }
+
+    writeInput();
 }
 
 ForkedWorkerHandler::~ForkedWorkerHandler()
 {
+    unwatch();
+
     // Wait on child process if it has not yet been waited for
     if (m_child_pid) terminate();
 
-    // Close pipe if not already closed
+    // Close pipes if not already closed
+    if (!m_write_done) close_check(m_pipe_write_fd);
     if (!m_read_done) close_check(m_pipe_read_fd);
 }
 
+void ForkedWorkerHandler::writeInput()
+{
+    // Close write pipe once the whole input string has been written, this
+    // signals end of input to the simulator
+    if (poll_write_to_pipe(m_pipe_write_fd, m_input_string, m_input_offset))
+    {
+        close_check(m_pipe_write_fd);
+        m_write_done = true;
+        updateWatch();
+    }
+}
+
 void ForkedWorkerHandler::terminate()
 {
     // If already terminated, return immediately
     if (!m_child_pid) return;
 
-    // If simulation has finished, mark by setting m_child_pid to zero
-    if ( waitpid_success(m_child_pid, WNOHANG, m_simulator) )
+    // If simulation has finished, mark by setting m_child_pid to zero.  The
+    // results are being discarded, so the exit status is ignored
+    if ( waitpid_success(m_child_pid, WNOHANG, m_simulator, ignore_error) )
     {
         m_child_pid = 0;
         return;
@@ -56,37 +85,33 @@ void ForkedWorkerHandler::terminate()
         throw e;
     }
 
-    // Sleep for g_kill_timeout
-    std::this_thread::sleep_for(g_kill_timeout);
-
-    // If simulation has finished, mark by setting m_child_pid to zero
-    if ( waitpid_success(m_child_pid, WNOHANG, m_simulator, ignore_error) )
-    {
-        m_child_pid = 0;
-        return;
-    }
-
-    // Send SIGKILL to child process
-    if ( kill(m_child_pid, SIGKILL) )
-    {
-        std::runtime_error e("an error occurred while trying to kill "
-                             "child process");
-        throw e;
-    }
-
-     waitpid_success(m_child_pid, 0, m_simulator, ignore_error);
-     m_child_pid = 0;
+    // Leave sending SIGKILL and reaping to the event loop
+    terminate_child_async(m_child_pid, m_simulator, true);
+    m_child_pid = 0;
 }
 
 bool ForkedWorkerHandler::isDone()
 {
+    // Continue writing input string if it did not fit into the pipe
+    if (!m_write_done && !m_read_done)
+        writeInput();
+
     // Poll pipe if m_read_done flag is false. If pipe is finished reading,
     // close pipe and set m_read_done flag to true
     if (    !m_read_done &&
             poll_read_from_pipe(m_pipe_read_fd, m_output_buffer) )
     {
+        unwatch();
         close_check(m_pipe_read_fd);
 
+        // If simulator has exited without reading all of its input, close
+        // write pipe as well
+        if (!m_write_done)
+        {
+            close_check(m_pipe_write_fd);
+            m_write_done = true;
+        }
+
         // Get error code
         waitpid_success(m_child_pid, m_error_code, 0);
         m_child_pid = 0;
@@ -96,3 +121,13 @@ bool ForkedWorkerHandler::isDone()
 
     return m_read_done;
 }
+
+int ForkedWorkerHandler::getReadFileDescriptor() const
+{
+    return m_pipe_read_fd;
+}
+
+int ForkedWorkerHandler::getWriteFileDescriptor() const
+{
+    return m_write_done ? -1 : m_pipe_write_fd;
+}
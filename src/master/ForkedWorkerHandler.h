@@ -2,13 +2,14 @@
 #define FORKEDWORKERHANDLER_H
 
 #include <string>
+#include <cstddef>
 
 #include "AbstractWorkerHandler.h"
 
 /** A class for representing forked Workers.
  *
- * Forked Workers are spawned using a `fork()`--`exec()` pattern.  This is the
- * default choice for instantiating simulators and is analogous to how
+ * Forked Workers are spawned as child processes using `posix_spawn()`.  This
+ * is the default choice for instantiating simulators and is analogous to how
  * SerialMaster launches simulations.
  */
 
@@ -21,7 +22,8 @@ class ForkedWorkerHandler : public AbstractWorkerHandler
          *
          * The constructor will fork a process whose standard input and output
          * is redirected to a write and a read pipe, respectively..  The input
-         * string is immediately written to the write pipe.
+         * string is immediately written to the write pipe.  If it does not
+         * fit into the pipe, the remainder is written by isDone().
          *
          * @param simulator  command to run simulation.
          * @param input_string  input string to simulator.
@@ -31,27 +33,41 @@ class ForkedWorkerHandler : public AbstractWorkerHandler
 
         /** Destructor.
          *
-         * The destructor waits on the forked process and closes the read
-         * pipe.
+         * The destructor terminates the forked process if it is still
+         * running and closes the read pipe.
          */
         virtual ~ForkedWorkerHandler() override;
 
         /** @return whether Worker has finished.
          *
-         * Poll read pipe for any outstanding output and check whether forked
-         * process has finished.
+         * Write any outstanding input, poll read pipe for any outstanding
+         * output and check whether forked process has finished.
          */
         virtual bool isDone() override;
 
+        /** @return file descriptor of read pipe. */
+        virtual int getReadFileDescriptor() const override;
+
+        /** @return file descriptor of write pipe while input string is
+         * being written, else -1.
+         */
+        virtual int getWriteFileDescriptor() const override;
+
     private:
 
         /** Terminate active Worker with system signals.
          *
          * Terminate simulation by sending `SIGTERM` first, followed by
-         * `SIGKILL` if process does not respond.
+         * `SIGKILL` if process does not respond.  Only `SIGTERM` is sent
+         * here; the process is then handed over to terminate_child_async(),
+         * so that the caller does not block for the kill timeout.
          */
         void terminate();
 
+        // Write as much of the remaining input string as the write pipe
+        // accepts, and close the write pipe when done
+        void writeInput();
+
         // Process id of simulator
         pid_t m_child_pid;
 
@@ -59,7 +75,11 @@ class ForkedWorkerHandler : public AbstractWorkerHandler
         int m_pipe_write_fd;
         int m_pipe_read_fd;
 
-        // Read pipe status flag
+        // Number of bytes of input string written so far
+        std::size_t m_input_offset = 0;
+
+        // Pipe status flags
+        bool m_write_done = false;
         bool m_read_done = false;
 };
 
@@ -0,0 +1,258 @@
+#include <string>
+#include <memory>
+#include <vector>
+#include <utility>
+
+#include <assert.h>
+
+#include "spdlog/spdlog.h"
+
+#include "system/plugin.h"
+#include "controller/AbstractController.h"
+
+#include "ForkedWorkerHandler.h"
+#include "PersistentWorker.h"
+#include "PersistentWorkerHandler.h"
+#include "PluginWorkerHandler.h"
+
+#include "LocalMaster.h"
+
+// Construct from simulator, number of jobs, simulator persistence and pointer
+// to program terminated flag
+LocalMaster::LocalMaster(const Command& simulator, int num_jobs,
+        bool persistent_simulator, bool *p_program_terminated) :
+    AbstractMaster(p_program_terminated),
+    m_simulator(simulator),
+    m_plugin_simulator(is_plugin(simulator)),
+    m_num_jobs(num_jobs),
+    m_persistent_simulator(persistent_simulator),
+    m_persistent_workers(num_jobs),
+    m_worker_handlers(num_jobs),
+    m_map_slot_to_task(num_jobs, nullptr)
+{
+    // Initialize idle slots
+    for (int i = 0; i < m_num_jobs; i++)
+        m_idle_slots.insert(i);
+}
+
+// Terminate remaining Workers
+LocalMaster::~LocalMaster()
+{
+    terminateWorkers();
+}
+
+// Probe whether Master is active
+bool LocalMaster::isActive() const
+{
+    return m_state != terminated;
+}
+
+// Iterate
+void LocalMaster::iterate()
+{
+    // This function should never be called recursively
+    assert(!m_entered);
+    m_entered = true;
+
+    // This function should never be called if the Master has
+    // terminated
+    assert(m_state != terminated);
+
+    // Check for program termination interrupt
+    if (programTerminated())
+    {
+        // Terminate Workers and Master
+        terminateWorkers();
+        m_state = terminated;
+        m_entered = false;
+        return;
+    }
+
+    // Listen to Workers
+    listenToWorkers();
+
+    // Pop finished tasks from busy queue and insert into finished queue
+    popBusyQueue();
+
+    // Call controller
+    if (auto p_controller = m_p_controller.lock())
+        p_controller->iterate();
+
+    // Check if controller has terminated Master
+    if (m_state == terminated)
+    {
+        terminateWorkers();
+        m_entered = false;
+        return;
+    }
+
+    // Delegate pending tasks to Workers
+    delegateToWorkers();
+
+    m_entered = false;
+}
+
+// Returns true if more pending tasks are needed
+bool LocalMaster::needMorePendingTasks() const
+{
+    return m_pending_tasks.size() < static_cast<std::size_t>(m_num_jobs);
+}
+
+// Push pending task
+void LocalMaster::pushPendingTask(const std::string& input_string,
+        double metadata)
+{
+    m_pending_tasks.emplace(input_string, metadata);
+}
+
+// Returns whether finished tasks queue is empty
+bool LocalMaster::finishedTasksEmpty() const
+{
+    return m_finished_tasks.empty();
+}
+
+// Returns reference to front finished task
+AbstractMaster::TaskHandler& LocalMaster::frontFinishedTask()
+{
+    return m_finished_tasks.front();
+}
+
+// Pop finished task
+void LocalMaster::popFinishedTask()
+{
+    m_finished_tasks.pop();
+}
+
+// Flush finished, busy and pending tasks
+void LocalMaster::flush()
+{
+    // Discard all running simulations
+    terminateWorkers();
+
+    // Flush all TaskHandler queues
+    flushQueues();
+}
+
+// Terminate Master
+void LocalMaster::terminate()
+{
+    m_state = terminated;
+}
+
+// Wait until a busy Worker is ready or the timeout has elapsed, then record
+// the results of finished Workers
+void LocalMaster::listenToWorkers()
+{
+    // If there are no busy Workers, there is nothing to wait for
+    if (m_idle_slots.size() == static_cast<std::size_t>(m_num_jobs))
+        return;
+
+    // Workers without a read pipe are checked directly.  If any of them has
+    // finished, do not sleep
+    m_ready_slots.assign(m_unwatched_slots.begin(), m_unwatched_slots.end());
+
+    bool unwatched_worker_done = false;
+    for (int slot : m_unwatched_slots)
+        unwatched_worker_done |= m_worker_handlers[slot]->isDone();
+
+    // Sleep until any Worker is ready, or until the timeout has elapsed
+    m_supervisor.wait(unwatched_worker_done ? 0 : g_main_timeout.count(),
+            m_ready_slots);
+
+    // Check ready Workers, skipping slots that have been released since
+    // they were reported
+    for (int slot : m_ready_slots)
+    {
+        if (!m_worker_handlers[slot])
+            continue;
+
+        if (!m_worker_handlers[slot]->isDone())
+            continue;
+
+        spdlog::debug("LocalMaster::listenToWorkers: Worker in slot {} "
+                "is done!", slot);
+
+        // Record output string and error code
+        m_map_slot_to_task[slot]->recordOutputAndErrorCode(
+                m_worker_handlers[slot]->getOutput(),
+                m_worker_handlers[slot]->getErrorCode());
+
+        // Destroy Worker handler and mark slot as idle
+        releaseSlot(slot);
+    }
+}
+
+// Pop finished tasks from busy queue and insert into finished queue
+void LocalMaster::popBusyQueue()
+{
+    moveFinishedTasks(m_busy_tasks, m_finished_tasks);
+}
+
+// Delegate pending tasks to idle Worker slots
+void LocalMaster::delegateToWorkers()
+{
+    // While there are idle slots and pending tasks
+    auto it = m_idle_slots.begin();
+    for (; (it != m_idle_slots.end()) && !m_pending_tasks.empty(); it++)
+    {
+        spdlog::debug("LocalMaster::delegateToWorkers: "
+                "starting Worker in slot {}", *it);
+
+        // Start Worker
+        const std::string& input_string =
+            m_pending_tasks.front().getInputString();
+
+        if (m_plugin_simulator)
+            m_worker_handlers[*it].reset(new PluginWorkerHandler(m_simulator,
+                        input_string));
+        else if (m_persistent_simulator)
+            m_worker_handlers[*it].reset(new PersistentWorkerHandler(
+                        m_simulator, input_string,
+                        m_persistent_workers[*it]));
+        else
+            m_worker_handlers[*it].reset(new ForkedWorkerHandler(m_simulator,
+                        input_string));
+
+        // Move pending TaskHandler to busy queue
+        m_busy_tasks.push_back(std::move(m_pending_tasks.front()));
+
+        // Pop front TaskHandler from pending queue
+        m_pending_tasks.pop();
+
+        // Set map from slot to TaskHandler
+        m_map_slot_to_task[*it] = &m_busy_tasks.back();
+
+        // Watch pipes of Worker, or check it directly if it has none
+        if (!m_worker_handlers[*it]->watch(m_supervisor, *it))
+            m_unwatched_slots.insert(*it);
+    }
+
+    // Mark slots as busy
+    m_idle_slots.erase(m_idle_slots.begin(), it);
+}
+
+// Terminate all busy Workers and mark their slots as idle
+void LocalMaster::terminateWorkers()
+{
+    // Resetting the Worker handler terminates the Worker
+    for (int slot = 0; slot < m_num_jobs; slot++)
+        releaseSlot(slot);
+}
+
+// Destroy Worker handler of slot, which stops watching its pipes, and mark
+// slot as idle
+void LocalMaster::releaseSlot(int slot)
+{
+    m_unwatched_slots.erase(slot);
+    m_worker_handlers[slot].reset();
+    m_map_slot_to_task[slot] = nullptr;
+    m_idle_slots.insert(slot);
+}
+
+// Flush all task queues (finished, busy, pending)
+void LocalMaster::flushQueues()
+{
+    while (!m_finished_tasks.empty()) m_finished_tasks.pop();
+    m_busy_tasks.clear();
+    while (!m_pending_tasks.empty()) m_pending_tasks.pop();
+}
@@ -0,0 +1,206 @@
+#ifndef LOCALMASTER_H
+#define LOCALMASTER_H
+
+#include <string>
+#include <queue>
+#include <list>
+#include <vector>
+#include <set>
+#include <memory>
+
+#include "core/common.h"
+#include "core/Command.h"
+#include "system/ChildSupervisor.h"
+
+#include "AbstractMaster.h"
+
+class LongOptions;
+class Arguments;
+class AbstractWorkerHandler;
+class PersistentWorker;
+
+/** A Master class for performing simulation tasks in parallel on the local
+ * node without MPI.
+ *
+ * The LocalMaster class keeps up to a fixed number of forked Workers (as
+ * implemented by the ForkedWorkerHandler class) running concurrently.  The
+ * pipes of all busy Workers are watched by a ChildSupervisor, so that the
+ * LocalMaster only wakes up when a Worker has produced output or exited, and
+ * then only checks the Workers that are ready.
+ *
+ * If the simulator is persistent, every slot owns a PersistentWorker that is
+ * reused across simulation tasks (as implemented by the
+ * PersistentWorkerHandler class).
+ *
+ * As with the other Masters, finished tasks are pushed to the finished queue
+ * in the same order as they were added to the pending queue, unless unordered
+ * completion is enabled (see AbstractMaster::unorderedCompletion()).
+ *
+ * For instructions on how to use Pakman with the local master, execute the
+ * following command
+ * ```
+ * $ pakman local --help
+ * ```
+ */
+
+class LocalMaster : public AbstractMaster
+{
+    public:
+
+        /** Constructor saves simulator command, number of concurrent jobs,
+         * simulator persistence and program termination flag.
+         *
+         * @param simulator  command to run simulation.
+         * @param num_jobs  maximum number of simulations to run concurrently.
+         * @param persistent_simulator  whether simulator is persistent.
+         * @param p_program_terminated  pointer to boolean flag that is set
+         * when the execution of Pakman is terminated by the user.
+         */
+        LocalMaster(const Command& simulator, int num_jobs,
+                bool persistent_simulator, bool *p_program_terminated);
+
+        /** Destructor terminates any remaining Workers. */
+        virtual ~LocalMaster() override;
+
+        /** @return whether the LocalMaster is active. */
+        virtual bool isActive() const override;
+
+        /** @return whether more pending tasks are needed. */
+        virtual bool needMorePendingTasks() const override;
+
+        /** Push a new pending task.
+         *
+         * @param input_string  input string to simulation job.
+         * @param metadata  number attached to task by AbstractController.
+         */
+        virtual void pushPendingTask(const std::string& input_string,
+                double metadata = 0.0) override;
+
+        /** @return whether finished tasks queue is empty. */
+        virtual bool finishedTasksEmpty() const override;
+
+        /** @return reference to front finished task. */
+        virtual TaskHandler& frontFinishedTask() override;
+
+        /** Pop front finished task. */
+        virtual void popFinishedTask() override;
+
+        /** Flush all finished, busy and pending tasks. */
+        virtual void flush() override;
+
+        /** Terminate LocalMaster. */
+        virtual void terminate() override;
+
+        /** @return help message string. */
+        static std::string help();
+
+        /** Add long command-line options.
+         *
+         * @param lopts  long command-line options that the LocalMaster needs.
+         */
+        static void addLongOptions(LongOptions& lopts);
+
+        /** Run LocalMaster in an event loop.
+         *
+         * This function creates the LocalMaster and Controller objects, and
+         * runs them in an event loop.
+         *
+         * @param controller  controller type.
+         * @param args  command-line arguments.
+         */
+        static void run(controller_t controller, const Arguments& args);
+
+        /** For LocalMaster, this function does nothing. */
+        static void cleanup();
+
+    protected:
+
+        /** Iterates the LocalMaster in an event loop. */
+        virtual void iterate() override;
+
+    private:
+
+        /** Enumerate type for LocalMaster states.
+         *
+         * The LocalMaster can either in a `normal` state, or in a `terminated`
+         * state.  When the LocalMaster is in a `terminated` state, the member
+         * function isActive() will return false and the event loop should
+         * terminate.
+         */
+        enum state_t { normal, terminated };
+
+        ///// Member functions /////
+        // Wait until a busy Worker is ready or the timeout has elapsed, then
+        // record the results of finished Workers
+        void listenToWorkers();
+
+        // Pop finished tasks from busy queue and insert into finished queue
+        void popBusyQueue();
+
+        // Delegate pending tasks to idle Worker slots
+        void delegateToWorkers();
+
+        // Terminate all busy Workers and mark their slots as idle
+        void terminateWorkers();
+
+        // Destroy Worker handler of slot, stop watching its pipes and mark
+        // slot as idle
+        void releaseSlot(int slot);
+
+        // Flush all task queues (finished, busy, pending)
+        void flushQueues();
+
+        ///// Member variables /////
+        // Initial state is normal
+        state_t m_state = normal;
+
+        // Simulator command
+        const Command m_simulator;
+
+        // Whether simulator is a plugin
+        const bool m_plugin_simulator;
+
+        // Maximum number of concurrent Workers
+        const int m_num_jobs;
+
+        // Whether simulator is persistent
+        const bool m_persistent_simulator;
+
+        // Persistent Worker for each slot (only used for persistent
+        // simulators)
+        std::vector<std::unique_ptr<PersistentWorker>> m_persistent_workers;
+
+        // Supervisor watching the pipes of busy Workers, keyed by slot.  It
+        // must outlive the Worker handlers
+        ChildSupervisor m_supervisor;
+
+        // Worker handler for each slot (null pointer if slot is idle)
+        std::vector<std::unique_ptr<AbstractWorkerHandler>> m_worker_handlers;
+
+        // Busy slots whose Workers have no read pipe, such as plugin
+        // simulators, and are therefore checked directly
+        std::set<int> m_unwatched_slots;
+
+        // Slots to check for finished Workers
+        std::vector<int> m_ready_slots;
+
+        // Mapping from slot to corresponding task
+        std::vector<TaskHandler*> m_map_slot_to_task;
+
+        // Set of idle slots
+        std::set<int> m_idle_slots;
+
+        // Finished tasks
+        std::queue<TaskHandler> m_finished_tasks;
+
+        // Busy tasks in the order they were pushed
+        std::list<TaskHandler> m_busy_tasks;
+
+        // Pending tasks
+        std::queue<TaskHandler> m_pending_tasks;
+
+        // Entered iterate()
+        bool m_entered = false;
+};
+
+#endif // LOCALMASTER_H
@@ -0,0 +1,148 @@
+#include <string>
+#include <memory>
+#include <thread>
+#include <iostream>
+
+#include <getopt.h>
+
+#include "core/common.h"
+#include "core/Arguments.h"
+#include "core/LongOptions.h"
+#include "core/Command.h"
+#include "system/signal_handler.h"
+#include "system/debug.h"
+#include "system/reaper.h"
+#include "main/help.h"
+#include "controller/AbstractController.h"
+
+#include "LocalMaster.h"
+
+// Static help function
+std::string LocalMaster::help()
+{
+    return
+R"(* Help message for 'local' master *
+
+Description:
+  The local master runs up to N instances of the simulator, also called
+  "workers", concurrently on the local machine without requiring MPI.  It is
+  assumed that the simulator is a standard simulator, which means that it
+  communicates with pakman through its stdin and stdout.
+
+  If the optional argument --persistent-simulator is given, every worker slot
+  starts the simulator once and reuses it for all of its simulations.  The
+  persistent simulator must then read length-prefixed input frames from its
+  stdin and write output frames to its stdout in a loop.  It is only restarted
+  when a simulation fails or is interrupted.
+
+  If the first token of the simulator command ends in '.so', the simulator is
+  a plugin written with the header pakman_plugin.h.  Plugins are called
+  directly by pakman on separate threads, so up to --jobs simulations run at
+  the same time and the plugin must be thread-safe.
+
+  The number of concurrent workers is given by the optional argument --jobs.
+  By default, it is equal to the number of hardware threads.
+
+  The local master waits for output from all running workers at once.  The
+  maximum time spent waiting at each iteration of the event loop can be
+  adjusted using the optional argument --main-timeout.
+
+  When a worker needs to be shut down, pakman first sends SIGTERM to the
+  worker.  If the worker has not exited after a fixed amount of time, it is
+  killed by sending the SIGKILL signal.  The amount of time between sending
+  SIGTERM and SIGKILL can be changed using the optional argument
+  --kill-timeout.
+
+Local master options:
+  -j, --jobs=N                 run at most N workers concurrently
+                               (default number of hardware threads)
+  -p, --persistent-simulator   simulator is started once per worker slot
+                               and reused
+  -t, --main-timeout=TIME      wait at most TIME ms in event loop (default 1)
+  -k, --kill-timeout=TIME      wait for TIME ms before sending SIGKILL
+                               (default 100)
+)";
+}
+
+// Static addLongOptions function
+void LocalMaster::addLongOptions(LongOptions& lopts)
+{
+    lopts.add({"jobs", required_argument, nullptr, 'j'});
+    lopts.add({"persistent-simulator", no_argument, nullptr, 'p'});
+    lopts.add({"main-timeout", required_argument, nullptr, 't'});
+    lopts.add({"kill-timeout", required_argument, nullptr, 'k'});
+}
+
+// Static run function
+void LocalMaster::run(controller_t controller, const Arguments& args)
+{
+    // Default number of jobs is the number of hardware threads
+    int num_jobs = std::thread::hardware_concurrency();
+    if (num_jobs < 1)
+        num_jobs = 1;
+
+    // Process optional arguments
+    if (args.isOptionalArgumentSet("jobs"))
+    {
+        std::string&& arg = args.optionalArgument("jobs");
+        num_jobs = std::stoi(arg);
+
+        if (num_jobs < 1)
+        {
+            std::cout << "Error: option --jobs must be a positive integer\n";
+            ::help(local, controller, EXIT_FAILURE);
+        }
+    }
+
+    bool persistent_simulator =
+        args.isOptionalArgumentSet("persistent-simulator");
+
+    if (args.isOptionalArgumentSet("main-timeout"))
+    {
+        std::string&& arg = args.optionalArgument("main-timeout");
+        g_main_timeout = std::chrono::milliseconds(std::stoi(arg));
+    }
+
+    if (args.isOptionalArgumentSet("kill-timeout"))
+    {
+        std::string&& arg = args.optionalArgument("kill-timeout");
+        g_kill_timeout = std::chrono::milliseconds(std::stoi(arg));
+    }
+
+    // Set signal handlers
+    set_handlers();
+    set_signal_handler();
+
+    // Create controller and LocalMaster
+    std::shared_ptr<AbstractController>
+        p_controller(AbstractController::makeController(controller, args));
+
+    auto p_master =
+        std::make_shared<LocalMaster>(p_controller->getSimulator(),
+                num_jobs, persistent_simulator, &g_program_terminated);
+
+    // Associate with each other
+    p_master->assignController(p_controller);
+    p_controller->assignMaster(p_master);
+
+    // Start event loop
+    while (p_master->isActive())
+    {
+        p_master->iterate();
+
+        // Advance termination of Workers that are shutting down
+        reap_children();
+    }
+
+    // Destroy Master and Controller
+    p_master.reset();
+    p_controller.reset();
+
+    // Wait for Workers that are shutting down
+    reap_children_blocking();
+}
+
+// Static cleanup function
+void LocalMaster::cleanup()
+{
+}
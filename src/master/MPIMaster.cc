@@ -2,8 +2,13 @@
 #include <memory>
 #include <string>
 #include <queue>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <stdexcept>
 
 #include <assert.h>
+#include <math.h>
 
 #include <mpi.h>
 
@@ -11,16 +16,28 @@
 
 #include "mpi/mpi_utils.h"
 #include "mpi/mpi_common.h"
+#include "interface/protocols.h"
 #include "controller/AbstractController.h"
 
 #include "MPIMaster.h"
 
-// Construct from pointer to program terminated flag
-MPIMaster::MPIMaster(bool *p_program_terminated) :
+// Construct from pointer to program terminated flag, maximum batch size,
+// prefetch depth, number of Workers per Manager, communicator shared with
+// Managers and work stealing flag
+MPIMaster::MPIMaster(bool *p_program_terminated, int max_batch_size,
+        int prefetch_depth, int workers_per_manager, MPI_Comm comm,
+        bool work_stealing) :
     AbstractMaster(p_program_terminated),
-    m_comm_size(get_mpi_comm_world_size()),
-    m_map_manager_to_task(get_mpi_comm_world_size()),
-    m_message_buffers(get_mpi_comm_world_size())
+    m_comm(comm),
+    m_comm_size(get_mpi_comm_size(comm)),
+    m_max_batch_size(max_batch_size),
+    m_prefetch_depth(prefetch_depth),
+    m_manager_slots(get_mpi_comm_size(comm), workers_per_manager),
+    m_num_slots(get_mpi_comm_size(comm) * workers_per_manager),
+    m_work_stealing(work_stealing),
+    m_manager_batches(get_mpi_comm_size(comm)),
+    m_reply_times(get_mpi_comm_size(comm)),
+    m_message_buffers(get_mpi_comm_size(comm))
 {
     // Initialize requests to MPI_REQUEST_NULL
     // and initialize idle managers
@@ -58,6 +75,16 @@ bool MPIMaster::isActive() const
     return m_state != terminated;
 }
 
+// Probe whether any Manager has outstanding batches
+bool MPIMaster::awaitsManagers() const
+{
+    for (const auto& batches : m_manager_batches)
+        if (!batches.empty())
+            return true;
+
+    return false;
+}
+
 // Iterate
 void MPIMaster::iterate()
 {
@@ -76,10 +103,6 @@ void MPIMaster::iterate()
             doNormalStuff();
             break;
 
-        case flushing:
-            doFlushingStuff();
-            break;
-
         default:
             throw;
     }
@@ -90,7 +113,25 @@ void MPIMaster::iterate()
 // Returns true if more pending tasks are needed
 bool MPIMaster::needMorePendingTasks() const
 {
-    return m_pending_tasks.size() < m_comm_size;
+    return m_pending_tasks.size() < static_cast<std::size_t>(
+            m_num_slots * m_max_batch_size * (1 + m_prefetch_depth));
+}
+
+// Set number of Worker slots of every Manager
+void MPIMaster::setManagerSlots(const std::vector<int>& manager_slots)
+{
+    // Sanity check: there must be one entry for every Manager
+    if (static_cast<int>(manager_slots.size()) != m_comm_size)
+    {
+        std::runtime_error e("number of Worker slots must be given for "
+                "every Manager");
+        throw e;
+    }
+
+    m_manager_slots = manager_slots;
+    m_num_slots = 0;
+    for (int slots : m_manager_slots)
+        m_num_slots += slots;
 }
 
 // Do normal stuff
@@ -128,7 +169,9 @@ void MPIMaster::doNormalStuff()
         return;
     }
 
-    // Check for flushing of Workers
+    // Check for flushing of Workers.  Managers discard the batches of
+    // earlier epochs by themselves, so tasks of the new epoch can be
+    // delegated right away
     if (m_worker_flushed)
     {
         spdlog::debug("MPIMaster::doNormalStuff: Flushing workers!");
@@ -138,69 +181,17 @@ void MPIMaster::doNormalStuff()
 
         // Reset flag
         m_worker_flushed = false;
-
-        // Switch to flushing state
-        m_state = flushing;
-        return;
     }
 
     // Delegate tasks to Managers
     delegateToManagers();
 }
 
-// Do flushing stuff
-void MPIMaster::doFlushingStuff()
-{
-    // This function should never be called if the Master has
-    // terminated
-    assert(m_state != terminated);
-
-    // Check for program termination interrupt
-    if (programTerminated())
-    {
-        // Terminate Master
-        m_state = terminated;
-        return;
-    }
-
-    // Check for termination of Master and Managers
-    if (m_master_manager_terminated)
-    {
-        // Send TERMINATE_MANAGER_SIGNAL to all Managers
-        sendSignalToAllManagers(TERMINATE_MANAGER_SIGNAL);
-
-        // Terminate Master
-        m_state = terminated;
-        return;
-    }
-
-    // Discard messages, error codes and signals
-    discardMessagesErrorCodesAndSignals();
-
-    // If all Managers are idle, transition to normal state
-    if (m_idle_managers.size() == m_comm_size)
-    {
-        // Debug info
-        if (spdlog::get(g_program_name)->level() <= spdlog::level::debug)
-        {
-            spdlog::debug("MPIMaster::doFlushingStuff: "
-                    "transition to normal state!");
-            spdlog::debug("Idle managers:");
-            for (auto it = m_idle_managers.begin();
-                    it != m_idle_managers.end(); it++)
-                spdlog::debug("{}", *it);
-            spdlog::debug("-- END --");
-        }
-
-        m_state = normal;
-        return;
-    }
-}
-
 // Push pending task
-void MPIMaster::pushPendingTask(const std::string& input_string)
+void MPIMaster::pushPendingTask(const std::string& input_string,
+        double metadata)
 {
-    m_pending_tasks.push(input_string);
+    m_pending_tasks.emplace(input_string, metadata);
 }
 
 // Returns whether finished tasks queue is empty
@@ -226,6 +217,9 @@ void MPIMaster::flush()
 {
     m_worker_flushed = true;
 
+    // Start new epoch, replies to batches of earlier epochs are discarded
+    m_epoch++;
+
     // Flush all TaskHandler queues
     flushQueues();
 }
@@ -246,17 +240,35 @@ void MPIMaster::listenToManagers()
         int manager_rank = probeMessageManager();
 
         // Receive message
-        std::string&& output_string = receiveMessage(manager_rank);
+        std::string& message = receiveMessage(manager_rank);
 
-        // Receive error code
-        int error_code = receiveErrorCode(manager_rank);
+        // Record output string and error code of every task in batch.  The
+        // tasks of batches of earlier epochs have already been flushed
+        const Batch& batch = m_manager_batches[manager_rank].front();
+        if (batch.epoch != m_epoch)
+            spdlog::debug("MPIMaster::listenToManagers: discarding reply "
+                    "of epoch {} from manager {}", batch.epoch, manager_rank);
 
-        // Record output string
-        m_map_manager_to_task[manager_rank]->recordOutputAndErrorCode(
-                output_string, error_code);
+        for (TaskHandler* p_task : batch.tasks)
+        {
+            std::string output_string;
+            int error_code = 0;
+            if (!parse_persistent_simulator_output(message, output_string,
+                        error_code))
+            {
+                std::runtime_error e("reply from Manager contains fewer "
+                        "results than tasks in batch");
+                throw e;
+            }
+
+            p_task->recordOutputAndErrorCode(output_string, error_code);
+        }
 
-        // Mark manager as idle
-        m_idle_managers.insert(manager_rank);
+        // Update estimate of task duration
+        updateTaskDuration(manager_rank, batch);
+
+        // Pop batch and mark manager as idle if it has no more batches
+        popManagerBatch(manager_rank);
     }
 }
 
@@ -267,28 +279,19 @@ void MPIMaster::popBusyQueue()
     if (m_busy_tasks.empty())
         return;
 
-    // While there are finished tasks (or tasks where errors occured) in the
-    // front of the queue
-    while (!m_busy_tasks.empty() && !m_busy_tasks.front().isPending())
-    {
-        spdlog::debug("MPIMaster::popBusyQueue: "
-                "Moving TaskHandler from busy to finished!");
-        spdlog::debug("finished, busy, pending: {}, {}, {}",
-                m_finished_tasks.size(), m_busy_tasks.size(),
-                m_pending_tasks.size());
-
-        // Move TaskHandler to finished tasks
-        m_finished_tasks.push(std::move(m_busy_tasks.front()));
-
-        // Pop front TaskHandler from busy queue
-        m_busy_tasks.pop();
-
-        spdlog::debug("MPIMaster::popBusyQueue: "
-                "Done moving TaskHandler from busy to finished!");
-        spdlog::debug("finished, busy, pending: {}, {}, {}",
-                m_finished_tasks.size(), m_busy_tasks.size(),
-                m_pending_tasks.size());
-    }
+    spdlog::debug("MPIMaster::popBusyQueue: "
+            "Moving TaskHandlers from busy to finished!");
+    spdlog::debug("finished, busy, pending: {}, {}, {}",
+            m_finished_tasks.size(), m_busy_tasks.size(),
+            m_pending_tasks.size());
+
+    moveFinishedTasks(m_busy_tasks, m_finished_tasks);
+
+    spdlog::debug("MPIMaster::popBusyQueue: "
+            "Done moving TaskHandlers from busy to finished!");
+    spdlog::debug("finished, busy, pending: {}, {}, {}",
+            m_finished_tasks.size(), m_busy_tasks.size(),
+            m_pending_tasks.size());
 }
 
 // Delegate to Managers
@@ -304,37 +307,44 @@ void MPIMaster::delegateToManagers()
         spdlog::debug("-- END --");
     }
 
-    // While there are idle managers
-    auto it = m_idle_managers.begin();
-    for (; (it != m_idle_managers.end()) && !m_pending_tasks.empty(); it++)
+    // With work stealing, the pending tasks are partitioned right away and
+    // never queued at busy Managers
+    if (m_work_stealing)
     {
-        spdlog::debug("MPIMaster::delegateToManagers: "
-                "Moving TaskHandler from pending to busy!");
-        spdlog::debug("finished, busy, pending: {}, {}, {}",
-                m_finished_tasks.size(), m_busy_tasks.size(),
-                m_pending_tasks.size());
-
-        // Send message to Manager
-        sendMessageToManager(*it, m_pending_tasks.front().getInputString());
-
-        // Move pending TaskHandler to busy queue
-        m_busy_tasks.push(std::move(m_pending_tasks.front()));
-
-        // Pop front TaskHandler from pending queue
-        m_pending_tasks.pop();
-
-        // Set map from Manager to TaskHandler
-        m_map_manager_to_task[*it] = &m_busy_tasks.back();
-
-        spdlog::debug("MPIMaster::delegateToManagers: "
-                "Done moving TaskHandler from pending to busy!");
-        spdlog::debug("finished, busy, pending: {}, {}, {}",
-                m_finished_tasks.size(), m_busy_tasks.size(),
-                m_pending_tasks.size());
+        partitionOverManagers();
+        return;
     }
 
-    // Mark Managers as busy
-    m_idle_managers.erase(m_idle_managers.begin(), it);
+    // Serve Managers with fewer outstanding batches first, so that idle
+    // Managers are given work before the queues of busy Managers are topped
+    // up.  A Manager with several Worker slots is given a batch for every
+    // slot
+    const int max_outstanding = *std::max_element(m_manager_slots.begin(),
+            m_manager_slots.end()) * (1 + m_prefetch_depth);
+    for (int depth = 0; (depth < max_outstanding)
+            && !m_pending_tasks.empty(); depth++)
+    {
+        // Collect Managers with given number of outstanding batches.  A
+        // Manager is skipped if it already has a batch for every slot and
+        // prefetch, or if the previous message to it has not yet been sent,
+        // because its buffer cannot be reused
+        std::vector<int> manager_ranks;
+        for (int manager_rank = 0; manager_rank < m_comm_size;
+                manager_rank++)
+            if ((m_manager_batches[manager_rank].size()
+                        == static_cast<std::size_t>(depth))
+                    && (depth < m_manager_slots[manager_rank] *
+                        (1 + m_prefetch_depth))
+                    && messageSent(manager_rank))
+                manager_ranks.push_back(manager_rank);
+
+        // Send batches, taking into account the Managers that have not yet
+        // been given a batch
+        for (std::size_t i = 0; (i < manager_ranks.size())
+                && !m_pending_tasks.empty(); i++)
+            sendBatchToManager(manager_ranks[i],
+                    nextBatchSize(manager_ranks.size() - i));
+    }
 
     if (spdlog::get(g_program_name)->level() <= spdlog::level::debug)
     {
@@ -347,101 +357,181 @@ void MPIMaster::delegateToManagers()
     }
 }
 
-// Flush all task queues (finished, busy, pending)
-void MPIMaster::flushQueues()
+// Partition pending tasks over idle Managers
+void MPIMaster::partitionOverManagers()
 {
-    while (!m_finished_tasks.empty()) m_finished_tasks.pop();
-    while (!m_busy_tasks.empty()) m_busy_tasks.pop();
-    while (!m_pending_tasks.empty()) m_pending_tasks.pop();
+    std::vector<int> manager_ranks;
+    for (int manager_rank : m_idle_managers)
+        if (messageSent(manager_rank))
+            manager_ranks.push_back(manager_rank);
+
+    // Every Manager is given a consecutive share of the pending tasks, in
+    // proportion to its number of Worker slots
+    int num_slots = 0;
+    for (int manager_rank : manager_ranks)
+        num_slots += m_manager_slots[manager_rank];
+
+    for (int manager_rank : manager_ranks)
+    {
+        if (m_pending_tasks.empty())
+            break;
+
+        int share = (m_pending_tasks.size() * m_manager_slots[manager_rank]
+                + num_slots - 1) / num_slots;
+        num_slots -= m_manager_slots[manager_rank];
+
+        sendBatchToManager(manager_rank, share);
+    }
 }
 
-// Discard any messages and signals until all Managers are idle
-void MPIMaster::discardMessagesErrorCodesAndSignals()
+// Send batch of pending tasks to Manager
+void MPIMaster::sendBatchToManager(int manager_rank, int batch_size)
 {
-    // While there are any incoming messages
-    while (probeMessage())
+    spdlog::debug("MPIMaster::sendBatchToManager: "
+            "Moving TaskHandlers from pending to busy!");
+    spdlog::debug("finished, busy, pending: {}, {}, {}",
+            m_finished_tasks.size(), m_busy_tasks.size(),
+            m_pending_tasks.size());
+
+    // Assemble message in reusable buffer
+    std::string& message = m_batch_message;
+    message.clear();
+    message += std::to_string(m_epoch);
+    message += '\n';
+    Batch batch;
+    batch.epoch = m_epoch;
+
+    for (int i = 0; (i < batch_size) && !m_pending_tasks.empty(); i++)
     {
-        // Probe manager
-        int manager_rank = probeMessageManager();
+        // Append input string to batch
+        message += format_persistent_simulator_input(
+                m_pending_tasks.front().getInputString());
 
-        // Receive and discard message
-        receiveMessage(manager_rank);
+        // Move pending TaskHandler to busy queue
+        m_busy_tasks.push_back(std::move(m_pending_tasks.front()));
 
-        // Receive and discard error code
-        receiveErrorCode(manager_rank);
+        // Pop front TaskHandler from pending queue
+        m_pending_tasks.pop();
 
-        // Mark manager as idle
-        m_idle_managers.insert(manager_rank);
+        // Add TaskHandler to batch
+        batch.tasks.push_back(&m_busy_tasks.back());
     }
 
-    // While there are any incoming signals
-    while (probeSignal())
-    {
-        // Probe manager
-        int manager_rank = probeSignalManager();
+    // Record batch and mark Manager as busy
+    batch.dispatch_time = std::chrono::steady_clock::now();
+    m_manager_batches[manager_rank].push_back(std::move(batch));
+    m_idle_managers.erase(manager_rank);
 
-        // If it a cancellation signal, mark manager as idle
-        if (receiveSignal(manager_rank) == WORKER_FLUSHED_SIGNAL)
-            m_idle_managers.insert(manager_rank);
-    }
-}
+    // Send message to Manager
+    sendMessageToManager(manager_rank, message);
 
-// Probe for message
-bool MPIMaster::probeMessage() const
-{
-    return iprobe_wrapper(MPI_ANY_SOURCE, MANAGER_MSG_TAG, MPI_COMM_WORLD);
+    spdlog::debug("MPIMaster::sendBatchToManager: "
+            "Done moving TaskHandlers from pending to busy!");
+    spdlog::debug("finished, busy, pending: {}, {}, {}",
+            m_finished_tasks.size(), m_busy_tasks.size(),
+            m_pending_tasks.size());
 }
 
-// Probe for signal
-bool MPIMaster::probeSignal() const
+// Pop front outstanding batch of Manager
+void MPIMaster::popManagerBatch(int manager_rank)
 {
-    return iprobe_wrapper(MPI_ANY_SOURCE, MANAGER_SIGNAL_TAG, MPI_COMM_WORLD);
+    // Sanity check: Manager must have an outstanding batch
+    assert(!m_manager_batches[manager_rank].empty());
+
+    m_manager_batches[manager_rank].pop_front();
+    m_reply_times[manager_rank] = std::chrono::steady_clock::now();
+
+    // Mark Manager as idle if it has no more outstanding batches
+    if (m_manager_batches[manager_rank].empty())
+        m_idle_managers.insert(manager_rank);
 }
 
-// Probe for Manager rank of incoming message
-int MPIMaster::probeMessageManager() const
+// Compute batch size for next message to a Manager
+int MPIMaster::nextBatchSize(int num_idle_managers) const
 {
-    MPI_Status status;
-    MPI_Probe(MPI_ANY_SOURCE, MANAGER_MSG_TAG, MPI_COMM_WORLD, &status);
-    return static_cast<int>(status.MPI_SOURCE);
+    // Without an estimate of the task duration, send one task at a time
+    if ((m_max_batch_size == 1) || (m_task_duration.count() <= 0.0))
+        return 1;
+
+    // Aim for batches that take at least ten iterations of the event loop,
+    // so that the overhead of sending messages is small compared to the time
+    // spent on simulations
+    std::chrono::duration<double> target_duration = 10 * g_main_timeout;
+    int batch_size = static_cast<int>(
+            ceil(target_duration.count() / m_task_duration.count()));
+
+    // Distribute pending tasks evenly over idle Managers
+    int fair_share = (m_pending_tasks.size() + num_idle_managers - 1)
+        / num_idle_managers;
+
+    batch_size = std::min({batch_size, fair_share, m_max_batch_size});
+    return std::max(batch_size, 1);
 }
 
-// Probe for Manager rank of incoming signal
-int MPIMaster::probeSignalManager() const
+// Update estimate of task duration with finished batch
+void MPIMaster::updateTaskDuration(int manager_rank, const Batch& batch)
 {
-    MPI_Status status;
-    MPI_Probe(MPI_ANY_SOURCE, MANAGER_SIGNAL_TAG, MPI_COMM_WORLD, &status);
-    return static_cast<int>(status.MPI_SOURCE);
+    if (batch.tasks.empty())
+        return;
+
+    // If the batch was queued at the Manager, the Manager started working on
+    // it when it sent the reply to the previous batch.  With several Worker
+    // slots, the Manager may have started working on it right away
+    auto start_time = batch.dispatch_time;
+    if (m_manager_slots[manager_rank] == 1)
+        start_time = std::max(start_time, m_reply_times[manager_rank]);
+
+    std::chrono::duration<double> duration =
+        (std::chrono::steady_clock::now() - start_time) / batch.tasks.size();
+
+    // Exponential moving average with weight 1/4 for the latest batch
+    if (m_task_duration.count() <= 0.0)
+        m_task_duration = duration;
+    else
+        m_task_duration = 0.75 * m_task_duration + 0.25 * duration;
 }
 
-// Receive message from Manager
-std::string MPIMaster::receiveMessage(int manager_rank) const
+// Flush all task queues (finished, busy, pending)
+void MPIMaster::flushQueues()
 {
-    // Sanity check: probeMessage must return true
-    assert(probeMessage());
+    while (!m_finished_tasks.empty()) m_finished_tasks.pop();
+    m_busy_tasks.clear();
+    while (!m_pending_tasks.empty()) m_pending_tasks.pop();
 
-    return receive_string(MPI_COMM_WORLD, manager_rank, MANAGER_MSG_TAG);
+    // Outstanding batches no longer refer to any tasks
+    for (auto& batches : m_manager_batches)
+        for (Batch& batch : batches)
+            batch.tasks.clear();
 }
 
-// Receive signal from Manager
-int MPIMaster::receiveSignal(int manager_rank) const
+// Probe for message
+bool MPIMaster::probeMessage() const
 {
-    // Sanity check: probeSignal must return true
-    assert(probeSignal());
+    return iprobe_wrapper(MPI_ANY_SOURCE, MANAGER_MSG_TAG, m_comm);
+}
 
-    return receive_integer(MPI_COMM_WORLD, manager_rank, MANAGER_SIGNAL_TAG);
+// Probe for Manager rank of incoming message
+int MPIMaster::probeMessageManager() const
+{
+    MPI_Status status;
+    MPI_Probe(MPI_ANY_SOURCE, MANAGER_MSG_TAG, m_comm, &status);
+    return static_cast<int>(status.MPI_SOURCE);
 }
 
-// Receive error code from Manager
-int MPIMaster::receiveErrorCode(int manager_rank) const
+// Receive message from Manager
+std::string& MPIMaster::receiveMessage(int manager_rank)
 {
-    return receive_integer(MPI_COMM_WORLD, manager_rank,
-            MANAGER_ERROR_CODE_TAG);
+    // Sanity check: probeMessage must return true
+    assert(probeMessage());
+
+    receive_string(m_comm, manager_rank, MANAGER_MSG_TAG,
+            m_receive_buffer);
+    return m_receive_buffer;
 }
 
 // Send message to a Manager
 void MPIMaster::sendMessageToManager(int manager_rank,
-        const std::string& message_string)
+        std::string& message_string)
 {
     if (spdlog::get(g_program_name)->level() <= spdlog::level::debug)
     {
@@ -458,8 +548,10 @@ void MPIMaster::sendMessageToManager(int manager_rank,
     // Ensure previous message has finished sending
     MPI_Wait(&m_message_requests[manager_rank], MPI_STATUS_IGNORE);
 
-    // Store message string in buffer
-    m_message_buffers[manager_rank].assign(message_string);
+    // Swap message string into buffer instead of copying it.  The previous
+    // message is discarded, but its capacity is kept for the next message
+    m_message_buffers[manager_rank].swap(message_string);
+    message_string.clear();
 
     // Note: Isend is used here to avoid deadlock since the Master and the root
     // Manager are executed by the same process
@@ -467,10 +559,18 @@ void MPIMaster::sendMessageToManager(int manager_rank,
             m_message_buffers[manager_rank].c_str(),
             m_message_buffers[manager_rank].size() + 1,
             MPI_CHAR, manager_rank, MASTER_MSG_TAG,
-            MPI_COMM_WORLD,
+            m_comm,
             &m_message_requests[manager_rank]);
 }
 
+// Check whether previous message to a Manager has been sent
+bool MPIMaster::messageSent(int manager_rank)
+{
+    int flag = 0;
+    MPI_Test(&m_message_requests[manager_rank], &flag, MPI_STATUS_IGNORE);
+    return static_cast<bool>(flag);
+}
+
 // Send signal to all Managers
 void MPIMaster::sendSignalToAllManagers(int signal)
 {
@@ -485,6 +585,6 @@ void MPIMaster::sendSignalToAllManagers(int signal)
     // Manager are executed by the same process
     for (int manager_rank = 0; manager_rank < m_comm_size; manager_rank++)
         MPI_Isend(&m_signal_buffer, 1, MPI_INT, manager_rank,
-                MASTER_SIGNAL_TAG, MPI_COMM_WORLD,
+                MASTER_SIGNAL_TAG, m_comm,
                 &m_signal_requests[manager_rank]);
 }
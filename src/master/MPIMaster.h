@@ -2,9 +2,12 @@
 #define MPIMASTER_H
 
 #include <queue>
+#include <list>
+#include <deque>
 #include <vector>
 #include <set>
 #include <string>
+#include <chrono>
 
 #include <mpi.h>
 
@@ -20,7 +23,7 @@ class Arguments;
  * The MPIMaster class performs simulation tasks in parallel using MPI by
  * delegating simulation tasks to a pool of Managers (as implemented by the
  * Manager class).  These Managers then perform simulation tasks by spawning
- * child processes with `fork()`--`exec()` to run simulation.
+ * child processes with `posix_spawn()` to run simulation.
  *
  * @warning If your simulator uses MPI internally, this will likely clash with
  * Pakman when using MPIMaster.  In that case, you will need to build an MPI
@@ -33,18 +36,71 @@ class Arguments;
  * ```
  * $ pakman mpi --help
  * ```
+ *
+ * Tasks are sent to Managers in batches.  Every message from the MPIMaster to
+ * a Manager contains one or more input strings, and every reply contains the
+ * corresponding output strings and error codes.  The number of tasks per
+ * batch is chosen adaptively based on the observed duration of tasks, so
+ * that the message rate of the MPIMaster does not limit throughput when
+ * simulations are short.
+ *
+ * Optionally, the MPIMaster sends further batches to Managers that are still
+ * busy, up to a fixed prefetch depth.  The Managers keep these batches in a
+ * local queue, so that the next simulation can start as soon as the previous
+ * one has finished, without waiting for a round trip to the MPIMaster.
+ * Managers reply to batches in the order in which they were sent, so the
+ * MPIMaster keeps a queue of outstanding batches for every Manager.
+ *
+ * A Manager may run several Workers concurrently (see Manager).  The MPIMaster
+ * then keeps as many batches outstanding at the Manager as it has Worker
+ * slots, and as many additional batches per slot as the prefetch depth
+ * allows, so that every Worker slot is kept busy.
+ *
+ * With work stealing, the MPIMaster does not send batches of adaptive size,
+ * but partitions all pending tasks evenly over the idle Managers in a single
+ * round.  Managers that finish their share early steal tasks from other
+ * Managers, so that the load is balanced without involving the MPIMaster
+ * (see Manager).  This suits parameter sweeps, whose tasks are all known up
+ * front.
+ *
+ * When Pakman runs on many nodes, the rate at which a single MPIMaster can
+ * exchange messages with all Managers limits the throughput.  With
+ * sub-masters, the MPIMaster on rank 0 instead only exchanges messages with
+ * one SubMaster per node, which passes the tasks on to an MPIMaster of its
+ * own that delegates them to the Managers of its node (see SubMaster).
+ *
+ * Every batch is tagged with an epoch, which is incremented whenever the
+ * MPIMaster is flushed.  Rather than waiting for all Managers to cancel their
+ * simulations, the MPIMaster starts sending tasks of the new epoch right away
+ * and discards replies to batches of earlier epochs as they come in (see
+ * Manager for details).
  */
 
 class MPIMaster : public AbstractMaster
 {
     public:
 
-        /** Constructor saves program termination flag.
+        /** Constructor saves program termination flag, maximum batch size,
+         * prefetch depth, number of Workers per Manager, communicator and
+         * work stealing flag.
          *
          * @param p_program_terminated  pointer to boolean flag that is set
          * when the execution of Pakman is terminated by the user.
+         * @param max_batch_size  maximum number of tasks that are sent to a
+         * Manager in one message.
+         * @param prefetch_depth  maximum number of batches that are queued
+         * at a Manager in addition to the batch it is working on, per Worker
+         * slot.
+         * @param workers_per_manager  number of Workers that every Manager
+         * runs concurrently.
+         * @param comm  communicator on which the MPIMaster exchanges messages
+         * with the Managers.  Every rank of the communicator runs a Manager.
+         * @param work_stealing  whether the pending tasks are partitioned
+         * over the Managers, which steal tasks from each other.
          */
-        MPIMaster(bool *p_program_terminated);
+        MPIMaster(bool *p_program_terminated, int max_batch_size = 1,
+                int prefetch_depth = 0, int workers_per_manager = 1,
+                MPI_Comm comm = MPI_COMM_WORLD, bool work_stealing = false);
 
         /** Default destructor does nothing. */
         virtual ~MPIMaster() override;
@@ -55,11 +111,29 @@ class MPIMaster : public AbstractMaster
         /** @return whether more pending tasks are needed. */
         virtual bool needMorePendingTasks() const override;
 
+        /** @return whether any Manager has outstanding batches, whose
+         * results the MPIMaster is waiting for.
+         */
+        bool awaitsManagers() const;
+
+        /** Set number of Worker slots of every Manager.
+         *
+         * By default, every Manager has the number of Worker slots given to
+         * the constructor.  A Manager that is a SubMaster instead has as many
+         * slots as all Managers of its node together.
+         *
+         * @param manager_slots  number of Worker slots of every Manager,
+         * indexed by rank.
+         */
+        void setManagerSlots(const std::vector<int>& manager_slots);
+
         /** Push a new pending task.
          *
          * @param input_string  input string to simulation job.
+         * @param metadata  number attached to task by AbstractController.
          */
-        virtual void pushPendingTask(const std::string& input_string) override;
+        virtual void pushPendingTask(const std::string& input_string,
+                double metadata = 0.0) override;
 
         /** @return whether finished tasks queue is empty. */
         virtual bool finishedTasksEmpty() const override;
@@ -113,22 +187,30 @@ class MPIMaster : public AbstractMaster
 
         /** Enumerate type for MPIMaster states.
          *
-         * The MPIMaster can either in a `normal` state, a `flushing` state or
-         * in a `terminated` state.  When the MPIMaster is in a flushing state,
-         * it has flushed the task queues and is waiting for all Managers to
-         * finish ongoing simulations before accepting new tasks.  When the
-         * MPIMaster is in a `terminated` state, the member function isActive()
-         * will return false and the event loop should terminate.
+         * The MPIMaster can either in a `normal` state or in a `terminated`
+         * state.  When the MPIMaster is in a `terminated` state, the member
+         * function isActive() will return false and the event loop should
+         * terminate.
          */
-        enum state_t { normal, flushing, terminated };
+        enum state_t { normal, terminated };
+
+        /** Batch of tasks that has been sent to a Manager. */
+        struct Batch
+        {
+            /** Pointers to the TaskHandlers in the busy queue. */
+            std::vector<TaskHandler*> tasks;
+
+            /** Time at which the batch was sent. */
+            std::chrono::steady_clock::time_point dispatch_time;
+
+            /** Epoch in which the batch was sent. */
+            int epoch = 0;
+        };
 
         ///// Member functions /////
         // Do normal stuff
         void doNormalStuff();
 
-        // Do flushing stuff
-        void doFlushingStuff();
-
         // Listen to messages from Managers.
         void listenToManagers();
 
@@ -138,37 +220,40 @@ class MPIMaster : public AbstractMaster
         // Delegate to Managers
         void delegateToManagers();
 
+        // Partition pending tasks over idle Managers
+        void partitionOverManagers();
+
+        // Send batch of pending tasks to Manager
+        void sendBatchToManager(int manager_rank, int batch_size);
+
+        // Pop front outstanding batch of Manager
+        void popManagerBatch(int manager_rank);
+
+        // Compute batch size for next message to a Manager
+        int nextBatchSize(int num_idle_managers) const;
+
+        // Update estimate of task duration with finished batch
+        void updateTaskDuration(int manager_rank, const Batch& batch);
+
         // Flush all task queues (finished, busy, pending)
         void flushQueues();
 
-        // Discard any messages, error codes and signals until all Managers are
-        // idle
-        void discardMessagesErrorCodesAndSignals();
-
         // Probe for message
         bool probeMessage() const;
 
-        // Probe for signal
-        bool probeSignal() const;
-
         // Probe for Manager rank of incoming message
         int probeMessageManager() const;
 
-        // Probe for Manager rank of incoming signal
-        int probeSignalManager() const;
-
-        // Receive message from Manager
-        std::string receiveMessage(int manager_rank) const;
+        // Receive message from Manager into receive buffer
+        std::string& receiveMessage(int manager_rank);
 
-        // Receive signal from Manager
-        int receiveSignal(int manager_rank) const;
-
-        // Receive error cdoe from Manager
-        int receiveErrorCode(int manager_rank) const;
-
-        // Send message to a Manager
+        // Send message to a Manager.  The message string is swapped into the
+        // send buffer of the Manager and left empty
         void sendMessageToManager(int manager_rank,
-                const std::string& message_string);
+                std::string& message_string);
+
+        // Check whether previous message to a Manager has been sent
+        bool messageSent(int manager_rank);
 
         // Send signal to all Managers
         void sendSignalToAllManagers(int signal);
@@ -177,6 +262,9 @@ class MPIMaster : public AbstractMaster
         // Initial state is normal
         state_t m_state = normal;
 
+        // Communicator shared with Managers
+        const MPI_Comm m_comm;
+
         // Communicator size
         const int m_comm_size;
 
@@ -186,17 +274,43 @@ class MPIMaster : public AbstractMaster
         // Flag for flushing Workers
         bool m_worker_flushed = false;
 
-        // Set of idle managers
+        // Current epoch, incremented on every flush
+        int m_epoch = 0;
+
+        // Set of idle managers (Managers without outstanding batches)
         std::set<int> m_idle_managers;
 
-        // Mapping from Manager to corresponding task
-        std::vector<TaskHandler*> m_map_manager_to_task;
+        // Maximum number of tasks per batch
+        const int m_max_batch_size;
+
+        // Maximum number of batches queued at a Manager in addition to the
+        // batch it is working on, per Worker slot
+        const int m_prefetch_depth;
+
+        // Number of Worker slots of every Manager, and of all Managers
+        // together
+        std::vector<int> m_manager_slots;
+        int m_num_slots;
+
+        // Whether Managers steal tasks from each other
+        const bool m_work_stealing;
+
+        // Outstanding batches of every Manager, in the order they were sent
+        std::vector<std::deque<Batch>> m_manager_batches;
+
+        // Time at which last reply was received from every Manager
+        std::vector<std::chrono::steady_clock::time_point> m_reply_times;
+
+        // Exponential moving average of task duration (zero if no task has
+        // finished yet)
+        std::chrono::duration<double> m_task_duration =
+            std::chrono::duration<double>::zero();
 
         // Finished tasks
         std::queue<TaskHandler> m_finished_tasks;
 
-        // Busy tasks
-        std::queue<TaskHandler> m_busy_tasks;
+        // Busy tasks in the order they were pushed
+        std::list<TaskHandler> m_busy_tasks;
 
         // Pending tasks
         std::queue<TaskHandler> m_pending_tasks;
@@ -204,6 +318,13 @@ class MPIMaster : public AbstractMaster
         // Message buffers
         std::vector<std::string> m_message_buffers;
 
+        // Buffer in which the next message to a Manager is assembled, which
+        // keeps the capacity of earlier messages
+        std::string m_batch_message;
+
+        // Buffer for messages from Managers
+        std::string m_receive_buffer;
+
         // Message requests
         std::vector<MPI_Request> m_message_requests;
 
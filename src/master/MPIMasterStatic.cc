@@ -2,6 +2,9 @@
 #include <string>
 #include <iostream>
 #include <memory>
+#include <chrono>
+#include <algorithm>
+#include <vector>
 
 #include <mpi.h>
 
@@ -11,6 +14,8 @@
 #include "core/LongOptions.h"
 #include "core/Arguments.h"
 #include "system/signal_handler.h"
+#include "system/reaper.h"
+#include "system/fork_server.h"
 #include "mpi/mpi_utils.h"
 #include "mpi/mpi_common.h"
 #include "main/help.h"
@@ -18,6 +23,7 @@
 
 #include "Manager.h"
 #include "MPIWorkerHandler.h"
+#include "SubMaster.h"
 
 #include "MPIMaster.h"
 
@@ -30,9 +36,17 @@ R"(* Help message for 'mpi' master *
 Description:
   The MPI master parallelizes instances of the simulator, also called
   "workers", across all launched MPI processes.  This means that every MPI
-  process is responsible for spawning workers.  The correspondence between
-  workers and MPI processes is one-to-one; launching N MPI processes results in
-  N workers running in parallel.
+  process is responsible for spawning workers.  By default, the correspondence
+  between workers and MPI processes is one-to-one; launching N MPI processes
+  results in N workers running in parallel.
+
+  On nodes with many cores, running one MPI process per core means that many
+  MPI processes all exchange messages with the master.  The optional argument
+  --workers-per-manager instead lets every MPI process run K workers
+  concurrently, so that K times fewer MPI processes are needed.  The master
+  then keeps K batches outstanding at every MPI process, or K times the
+  number given by --prefetch-depth in addition.  This is not supported for
+  MPI simulators.
 
   If no optional arguments are given, the simulator is, by default, assumed to
   be a standard simulator, which means that it communicates with pakman
@@ -42,11 +56,82 @@ Description:
   to communicate with pakman through MPI.  The MPI simulator must then be
   written with the header pakman_mpi_worker.h or PakmanMPIWorker.hpp.
 
+  By default, every MPI process spawns its MPI simulator as a single process
+  when it receives its first simulation.  The optional argument
+  --worker-procs spawns every MPI simulator as a group of K processes that
+  work on every simulation together.  The flag --spawn-at-startup instead
+  spawns the MPI simulators of all MPI processes with a single collective
+  call when pakman starts.
+
+  An MPI simulator receives the input of its next simulation only after it has
+  sent the result of the previous one.  The optional argument --worker-prefetch
+  lets every MPI process send up to K additional simulations that it has
+  queued to its MPI simulator, so that short simulations run back to back.
+  This only has an effect if MPI processes queue several simulations, i.e. if
+  --max-batch-size or --prefetch-depth is also given.
+
+  If the optional argument --persistent-simulator is given, every MPI process
+  starts the simulator once and reuses it for all of its simulations.  The
+  persistent simulator must then read length-prefixed input frames from its
+  stdin and write output frames to its stdout in a loop.  It is only restarted
+  when a simulation fails or is interrupted.
+
+  If the first token of the simulator command ends in '.so', the simulator is
+  a plugin written with the header pakman_plugin.h.  Every MPI process then
+  loads the plugin once and calls it directly on separate threads instead of
+  starting a process, so the plugin must be thread-safe.
+
+  By default, the master on rank 0 exchanges messages with every MPI process.
+  When pakman runs on many nodes, the rate at which the master can send and
+  receive messages limits the throughput.  The flag --sub-masters instead
+  makes the MPI process with the lowest rank on every node a sub-master.  The
+  master then only sends batches to the sub-masters, which distribute the
+  simulations among the MPI processes of their node and send the results back
+  to the master.  The options --max-batch-size and --prefetch-depth apply to
+  the messages of the master as well as of every sub-master.
+
+  For a parameter sweep, all simulations are known from the start.  The flag
+  --work-stealing makes the master divide them evenly over the MPI processes
+  at once.  An MPI process that has started all of its simulations then asks
+  the other MPI processes in turn for half of the simulations they have not
+  yet started, and sends the results back to them.  The master only receives
+  the results of every MPI process at the end.  The options --max-batch-size
+  and --prefetch-depth have no effect in that case.
+
   In order to maximize the number of CPU cycles devoted to the workers, the MPI
   master is implemented using an event loop.  The time spent sleeping at each
   iteration of the event loop can be adjusted using the optional argument
   --main-timeout.
 
+  If the flag --blocking-wait is given, every MPI process instead waits at each
+  iteration of the event loop until a message has arrived or its worker has
+  produced output.  Output from standard simulators wakes the MPI process up
+  immediately.  MPI messages are probed for at short intervals while a master
+  waits for results or a manager waits for simulations.  Otherwise, the
+  intervals double up to the time given by --main-timeout.  The MPI process
+  with rank 0 waits at most the time given by --main-timeout.  This removes
+  the fixed latency of the event loop when simulations are short.
+
+  By default, the master sends one simulation at a time to every MPI process.
+  When simulations are short, the rate at which the master can send and
+  receive messages limits the throughput.  The optional argument
+  --max-batch-size allows the master to send up to K simulations in a single
+  message.  The number of simulations per message is chosen adaptively so
+  that every batch takes about ten times the time given by --main-timeout.
+
+  After an MPI process has sent the results of a batch, it stays idle until
+  the master has received the results and sent the next batch.  The optional
+  argument --prefetch-depth allows the master to queue up to D additional
+  batches at every MPI process, so that the next simulation can start as soon
+  as the previous one has finished.
+
+  By default, the master generates every parameter itself before sending it to
+  an MPI process, which involves calling the prior sampler, perturber and prior
+  pdf user executables.  The flag --distribute-proposals instead lets every MPI
+  process generate the parameters it simulates, so that the cost of calling
+  these user executables scales with the number of MPI processes.  This flag
+  is only supported by the rejection and smc controllers.
+
   When a worker needs to be shut down, for example when the algorithm has
   finished, pakman first sends SIGTERM to the worker.  If the worker has not
   exited after a fixed amount of time, it is killed by sending the SIGKILL
@@ -55,6 +140,12 @@ Description:
   for standard simulators because the MPI standard does not support signals for
   processes that are spawned using MPI functions.
 
+  By default, every MPI process launches its workers itself.  With some MPI
+  transports, creating child processes from an MPI process is slow or not
+  supported.  The flag --fork-server makes every MPI process start a small
+  helper process before MPI is initialized, which then launches all workers
+  and other user executables on its behalf.
+
   Some MPI implementations do not automatically spawn dynamic MPI processes on
   the same host as the spawning MPI process.  The flag --force-host-spawn tries
   to enforce spawning dynamic MPI processes on the same host by setting the
@@ -64,22 +155,105 @@ MPI master options:
   -m, --mpi-simulator          simulator is spawned using MPI
   -f, --force-host-spawn       force MPI simulator to spawn on same host
                                as manager (requires -m option)
+  -n, --worker-procs=K         spawn every MPI simulator with K processes
+                               (requires -m option, default 1)
+  -a, --spawn-at-startup       spawn all MPI simulators collectively at
+                               startup (requires -m option)
+  -x, --worker-prefetch=K      send up to K queued simulations to MPI
+                               simulator in advance (requires -m option,
+                               default 0)
+  -p, --persistent-simulator   simulator is started once and reused
+  -j, --workers-per-manager=K  run K workers concurrently in every MPI
+                               process (default 1, not with -m option)
   -t, --main-timeout=TIME      sleep for TIME ms in event loop (default 1)
+  -b, --max-batch-size=K       send at most K simulations per message to
+                               every MPI process (default 1)
+  -q, --prefetch-depth=D       queue up to D additional batches at every
+                               MPI process (default 0)
+  -s, --sub-masters            distribute simulations through a sub-master
+                               on every node
+  -e, --work-stealing          partition simulations over MPI processes,
+                               which steal from each other (sweep only)
+  -g, --distribute-proposals   generate parameters on every MPI process
+                               (rejection and smc only)
+  -w, --blocking-wait          wait for messages or worker output in event
+                               loop instead of sleeping for a fixed time
+  -z, --fork-server            launch workers from a helper process that is
+                               started before MPI is initialized
   -k, --kill-timeout=TIME      wait for TIME ms before sending SIGKILL
                                (default 100)
 )";
 }
 
-Manager::worker_t get_worker(bool mpi_simulator)
+Manager::worker_t get_worker(bool mpi_simulator, bool persistent_simulator)
 {
     if (mpi_simulator)
     {
         return Manager::mpi_worker;
     }
+    else if (persistent_simulator)
+        return Manager::persistent_worker;
     else
         return Manager::forked_worker;
 }
 
+// Shortest time to sleep between probes when waiting for events
+const std::chrono::microseconds s_min_wait_slice(10);
+
+// Wait until a message has arrived on any of the given communicators, the
+// Worker of the Manager may have made progress, the program has been
+// terminated, or (if bounded is true) g_main_timeout has elapsed.  MPI does
+// not offer a file descriptor that can be waited on together with the read
+// pipe of a forked Worker, so MPI messages are probed for between waits on the
+// Worker.  The time waited on the Worker doubles after every probe, up to
+// g_main_timeout, unless a message is expected (awaiting is true), in which
+// case it stays at its minimum so that the message is received promptly
+void wait_for_event(Manager& manager, const std::vector<MPI_Comm>& comms,
+        bool bounded, bool awaiting)
+{
+    auto deadline = std::chrono::steady_clock::now() + g_main_timeout;
+
+    std::chrono::microseconds slice =
+        std::min<std::chrono::microseconds>(s_min_wait_slice,
+                g_main_timeout);
+
+    while (!g_program_terminated)
+    {
+        // Check for messages from Masters or Managers
+        for (MPI_Comm comm : comms)
+            if (iprobe_wrapper(MPI_ANY_SOURCE, MPI_ANY_TAG, comm))
+                return;
+
+        // Wait on Worker
+        if (manager.waitForWorker(slice))
+            return;
+
+        // Check for deadline
+        if (bounded && (std::chrono::steady_clock::now() >= deadline))
+            return;
+
+        // Back off while no message is expected
+        if (!awaiting)
+            slice = std::min<std::chrono::microseconds>(2 * slice,
+                    g_main_timeout);
+    }
+}
+
+// Communicators of the node and of all SubMasters if sub-masters are used,
+// else MPI_COMM_NULL
+static MPI_Comm s_node_comm = MPI_COMM_NULL;
+static MPI_Comm s_sub_master_comm = MPI_COMM_NULL;
+
+// Send signal to all ranks of communicator except rank 0
+void send_signal_to_ranks(int signal, MPI_Comm comm)
+{
+    int comm_size = get_mpi_comm_size(comm);
+
+    for (int manager_rank = 1; manager_rank < comm_size; manager_rank++)
+        MPI_Send(&signal, 1, MPI_INT, manager_rank,
+                MASTER_SIGNAL_TAG, comm);
+}
+
 // Static addLongOptions function
 void MPIMaster::addLongOptions(LongOptions& lopts)
 {
@@ -87,6 +261,18 @@ void MPIMaster::addLongOptions(LongOptions& lopts)
     lopts.add({"kill-timeout", required_argument, nullptr, 'k'});
     lopts.add({"mpi-simulator", no_argument, nullptr, 'm'});
     lopts.add({"force-host-spawn", no_argument, nullptr, 'f'});
+    lopts.add({"persistent-simulator", no_argument, nullptr, 'p'});
+    lopts.add({"blocking-wait", no_argument, nullptr, 'w'});
+    lopts.add({"max-batch-size", required_argument, nullptr, 'b'});
+    lopts.add({"prefetch-depth", required_argument, nullptr, 'q'});
+    lopts.add({"distribute-proposals", no_argument, nullptr, 'g'});
+    lopts.add({"fork-server", no_argument, nullptr, 'z'});
+    lopts.add({"worker-procs", required_argument, nullptr, 'n'});
+    lopts.add({"spawn-at-startup", no_argument, nullptr, 'a'});
+    lopts.add({"worker-prefetch", required_argument, nullptr, 'x'});
+    lopts.add({"workers-per-manager", required_argument, nullptr, 'j'});
+    lopts.add({"sub-masters", no_argument, nullptr, 's'});
+    lopts.add({"work-stealing", no_argument, nullptr, 'e'});
 }
 
 // Static main function
@@ -94,6 +280,29 @@ void MPIMaster::run(controller_t controller, const Arguments& args)
 {
     // Initialize flags for mpi simulator and persistence
     bool mpi_simulator = false;
+    bool persistent_simulator = false;
+
+    // Initialize flag for blocking wait
+    bool blocking_wait = args.isOptionalArgumentSet("blocking-wait");
+
+    // Initialize flag for distributed proposals
+    bool distribute_proposals =
+        args.isOptionalArgumentSet("distribute-proposals");
+
+    // Initialize maximum batch size
+    int max_batch_size = 1;
+
+    // Initialize prefetch depth
+    int prefetch_depth = 0;
+
+    // Initialize number of Workers per Manager
+    int workers_per_manager = 1;
+
+    // Initialize flag for sub-masters
+    bool sub_masters = args.isOptionalArgumentSet("sub-masters");
+
+    // Initialize flag for work stealing
+    bool work_stealing = args.isOptionalArgumentSet("work-stealing");
 
     // Process optional arguments
     if (args.isOptionalArgumentSet("main-timeout"))
@@ -108,6 +317,32 @@ void MPIMaster::run(controller_t controller, const Arguments& args)
         g_kill_timeout = std::chrono::milliseconds(std::stoi(arg));
     }
 
+    if (args.isOptionalArgumentSet("max-batch-size"))
+    {
+        std::string&& arg = args.optionalArgument("max-batch-size");
+        max_batch_size = std::stoi(arg);
+
+        if (max_batch_size < 1)
+        {
+            std::cout << "Error: option --max-batch-size must be a positive "
+                "integer\n";
+            ::help(mpi, controller, EXIT_FAILURE);
+        }
+    }
+
+    if (args.isOptionalArgumentSet("prefetch-depth"))
+    {
+        std::string&& arg = args.optionalArgument("prefetch-depth");
+        prefetch_depth = std::stoi(arg);
+
+        if (prefetch_depth < 0)
+        {
+            std::cout << "Error: option --prefetch-depth must be a "
+                "non-negative integer\n";
+            ::help(mpi, controller, EXIT_FAILURE);
+        }
+    }
+
     if (args.isOptionalArgumentSet("mpi-simulator"))
     {
         mpi_simulator = true;
@@ -122,6 +357,127 @@ void MPIMaster::run(controller_t controller, const Arguments& args)
         ::help(mpi, controller, EXIT_FAILURE);
     }
 
+    if (args.isOptionalArgumentSet("worker-procs"))
+    {
+        std::string&& arg = args.optionalArgument("worker-procs");
+        int worker_procs = std::stoi(arg);
+
+        if (!mpi_simulator)
+        {
+            std::cout << "Error: option --mpi-simulator must be set "
+                "if --worker-procs is set\n";
+            ::help(mpi, controller, EXIT_FAILURE);
+        }
+
+        if (worker_procs < 1)
+        {
+            std::cout << "Error: option --worker-procs must be a positive "
+                "integer\n";
+            ::help(mpi, controller, EXIT_FAILURE);
+        }
+
+        MPIWorkerHandler::setWorkerProcs(worker_procs);
+    }
+
+    if (args.isOptionalArgumentSet("worker-prefetch"))
+    {
+        std::string&& arg = args.optionalArgument("worker-prefetch");
+        int worker_prefetch = std::stoi(arg);
+
+        if (!mpi_simulator)
+        {
+            std::cout << "Error: option --mpi-simulator must be set "
+                "if --worker-prefetch is set\n";
+            ::help(mpi, controller, EXIT_FAILURE);
+        }
+
+        if (worker_prefetch < 0)
+        {
+            std::cout << "Error: option --worker-prefetch must be a "
+                "non-negative integer\n";
+            ::help(mpi, controller, EXIT_FAILURE);
+        }
+
+        MPIWorkerHandler::setPrefetchWindow(worker_prefetch);
+    }
+
+    if (args.isOptionalArgumentSet("workers-per-manager"))
+    {
+        std::string&& arg = args.optionalArgument("workers-per-manager");
+        workers_per_manager = std::stoi(arg);
+
+        if (mpi_simulator)
+        {
+            std::cout << "Error: options --mpi-simulator and "
+                "--workers-per-manager cannot both be set\n";
+            ::help(mpi, controller, EXIT_FAILURE);
+        }
+
+        if (workers_per_manager < 1)
+        {
+            std::cout << "Error: option --workers-per-manager must be a "
+                "positive integer\n";
+            ::help(mpi, controller, EXIT_FAILURE);
+        }
+    }
+
+    // Initialize flag for spawning MPI Workers at startup
+    bool spawn_at_startup = args.isOptionalArgumentSet("spawn-at-startup");
+
+    if (spawn_at_startup && !mpi_simulator)
+    {
+        std::cout << "Error: option --mpi-simulator must be set "
+            "if --spawn-at-startup is set\n";
+        ::help(mpi, controller, EXIT_FAILURE);
+    }
+
+    if (args.isOptionalArgumentSet("persistent-simulator"))
+    {
+        persistent_simulator = true;
+
+        if (mpi_simulator)
+        {
+            std::cout << "Error: options --mpi-simulator and "
+                "--persistent-simulator cannot both be set\n";
+            ::help(mpi, controller, EXIT_FAILURE);
+        }
+    }
+
+    if (distribute_proposals && (controller == sweep))
+    {
+        std::cout << "Error: option --distribute-proposals is not supported "
+            "by the sweep controller\n";
+        ::help(mpi, controller, EXIT_FAILURE);
+    }
+
+    if (work_stealing && (controller != sweep))
+    {
+        std::cout << "Error: option --work-stealing is only supported by the "
+            "sweep controller\n";
+        ::help(mpi, controller, EXIT_FAILURE);
+    }
+
+    if (work_stealing && sub_masters)
+    {
+        std::cout << "Error: options --work-stealing and --sub-masters "
+            "cannot both be set\n";
+        ::help(mpi, controller, EXIT_FAILURE);
+    }
+
+    // Start fork server before the MPI environment is initialized, so that
+    // it does not inherit any MPI state
+    if (args.isOptionalArgumentSet("fork-server"))
+    {
+        if (mpi_simulator)
+        {
+            std::cout << "Error: options --mpi-simulator and --fork-server "
+                "cannot both be set\n";
+            ::help(mpi, controller, EXIT_FAILURE);
+        }
+
+        start_fork_server();
+    }
+
     // Initialize the MPI environment
     MPI_Init(nullptr, nullptr);
 
@@ -134,69 +490,186 @@ void MPIMaster::run(controller_t controller, const Arguments& args)
 
     // Determine Worker type
     Manager::worker_t worker_type =
-        get_worker(mpi_simulator);
+        get_worker(mpi_simulator, persistent_simulator);
 
     // Create controller
     std::shared_ptr<AbstractController>
         p_controller(AbstractController::makeController(controller, args));
 
+    // Reject binary output of MPI Workers unless the controller accepts it
+    MPIWorkerHandler::setBinaryOutputAccepted(
+            p_controller->acceptsBinaryOutput());
+
+    // Switch controller to distributed proposals if requested
+    std::shared_ptr<ProposalGenerator> p_proposal_generator;
+    if (distribute_proposals)
+        p_proposal_generator = p_controller->distributeProposals();
+
+    // Split MPI processes into nodes if sub-masters are requested.  The MPI
+    // process with the lowest rank on every node runs a SubMaster, whose
+    // Managers exchange messages with it on the communicator of the node,
+    // while it exchanges messages with the MPIMaster on rank 0 on the
+    // communicator of all SubMasters
+    MPI_Comm manager_comm = MPI_COMM_WORLD;
+    bool sub_master = false;
+    std::vector<int> sub_master_slots;
+
+    if (sub_masters)
+    {
+        MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, rank,
+                MPI_INFO_NULL, &s_node_comm);
+        manager_comm = s_node_comm;
+
+        sub_master = (get_mpi_comm_rank(s_node_comm) == 0);
+        MPI_Comm_split(MPI_COMM_WORLD, sub_master ? 0 : MPI_UNDEFINED, rank,
+                &s_sub_master_comm);
+
+        // The MPIMaster keeps as many batches outstanding at every SubMaster
+        // as all Managers of its node have Worker slots
+        if (sub_master)
+        {
+            int slots = get_mpi_comm_size(s_node_comm) * workers_per_manager;
+
+            if (rank == 0)
+                sub_master_slots.resize(get_mpi_comm_size(s_sub_master_comm));
+
+            MPI_Gather(&slots, 1, MPI_INT, sub_master_slots.data(), 1,
+                    MPI_INT, MASTER_RANK, s_sub_master_comm);
+        }
+    }
+
     // Create Manager object
     auto p_manager = std::make_shared<Manager>(p_controller->getSimulator(),
-            worker_type, &g_program_terminated);
+            worker_type, &g_program_terminated, p_proposal_generator,
+            workers_per_manager, manager_comm, work_stealing);
+
+    // Spawn MPI Workers of all Managers at once if requested
+    if (spawn_at_startup)
+        MPIWorkerHandler::spawnCollectively(p_controller->getSimulator());
+
+    // Create SubMaster and the MPIMaster of its node, and associate them with
+    // each other
+    std::shared_ptr<SubMaster> p_sub_master;
+    std::shared_ptr<MPIMaster> p_node_master;
+
+    if (sub_master)
+    {
+        p_sub_master = std::make_shared<SubMaster>(
+                p_controller->getSimulator(), s_sub_master_comm);
+        p_node_master = std::make_shared<MPIMaster>(&g_program_terminated,
+                max_batch_size, prefetch_depth, workers_per_manager,
+                s_node_comm);
+
+        p_node_master->assignController(p_sub_master);
+        p_sub_master->assignMaster(p_node_master);
+    }
+
+    // Create MPI master on rank 0 and associate it with controller
+    std::shared_ptr<MPIMaster> p_master;
 
     if (rank == 0)
     {
-        // Create MPI master
-        auto p_master = std::make_shared<MPIMaster>(&g_program_terminated);
+        p_master = std::make_shared<MPIMaster>(&g_program_terminated,
+                max_batch_size, prefetch_depth, workers_per_manager,
+                sub_masters ? s_sub_master_comm : MPI_COMM_WORLD,
+                work_stealing);
+
+        if (sub_masters)
+            p_master->setManagerSlots(sub_master_slots);
 
-        // Associate with each other
         p_master->assignController(p_controller);
         p_controller->assignMaster(p_master);
+    }
 
-        // Master & Manager event loop
-        while (p_master->isActive() || p_manager->isActive())
-        {
-            if (p_master->isActive())
-                p_master->iterate();
+    // Communicators on which messages for this MPI process arrive
+    std::vector<MPI_Comm> comms = { manager_comm };
+    if (sub_master)
+        comms.push_back(s_sub_master_comm);
 
-            if (p_manager->isActive())
-                p_manager->iterate();
+    auto is_active = [&]() {
+        return (p_master && p_master->isActive())
+            || (p_node_master && p_node_master->isActive())
+            || p_manager->isActive();
+    };
 
-            std::this_thread::sleep_for(g_main_timeout);
-        }
-    }
-    else
+    // Event loop of Master, SubMaster and Manager, as far as they are run by
+    // this MPI process
+    while (is_active())
     {
-        // Manager event loop
-        while (p_manager->isActive())
-        {
+        if (p_master && p_master->isActive())
+            p_master->iterate();
+
+        if (p_node_master && p_node_master->isActive())
+            p_node_master->iterate();
+
+        if (p_manager->isActive())
             p_manager->iterate();
 
+        // Advance termination of Workers that are shutting down
+        int num_terminating = reap_children();
+
+        if (!is_active())
+            break;
+
+        // A Master may need to iterate without receiving any message, for
+        // example when a previous message to a Manager was still being sent,
+        // so the time spent waiting by a Master is limited to g_main_timeout.
+        // Managers only change state when a message arrives or their Worker
+        // makes progress, so they can wait indefinitely unless Workers that
+        // are shutting down need to be escalated or reaped.  Messages are
+        // probed for as often as possible while Masters wait for results or
+        // the Manager waits for tasks
+        if (blocking_wait)
+            wait_for_event(*p_manager, comms,
+                    p_master || p_node_master || (num_terminating > 0),
+                    (p_master && p_master->awaitsManagers())
+                    || (p_node_master && p_node_master->awaitsManagers())
+                    || p_manager->awaitsMessages());
+        else
             std::this_thread::sleep_for(g_main_timeout);
-        }
     }
 
-    // Destroy Manager and Controller
+    // Destroy Manager, Masters and Controllers
     p_manager.reset();
+    p_master.reset();
+    p_node_master.reset();
+    p_sub_master.reset();
     p_controller.reset();
 
+    // Wait for Workers that are shutting down
+    reap_children_blocking();
+
     // Terminate any remaining Workers
     MPIWorkerHandler::terminateStatic();
 
+    // Free communicators of sub-masters
+    if (s_node_comm != MPI_COMM_NULL)
+        MPI_Comm_free(&s_node_comm);
+
+    if (s_sub_master_comm != MPI_COMM_NULL)
+        MPI_Comm_free(&s_sub_master_comm);
+
     // Finalize
     MPI_Finalize();
+
+    // Stop fork server
+    stop_fork_server();
 }
 
 // Static cleanup function
 void MPIMaster::cleanup()
 {
-    // Terminate all managers
-    int comm_size = get_mpi_comm_world_size();
+    // Terminate all managers.  With sub-masters, Managers only listen to the
+    // SubMaster of their node, and SubMasters to the MPIMaster on rank 0
     int signal = TERMINATE_MANAGER_SIGNAL;
 
-    for (int manager_rank = 1; manager_rank < comm_size; manager_rank++)
-        MPI_Send(&signal, 1, MPI_INT, manager_rank,
-                MASTER_SIGNAL_TAG, MPI_COMM_WORLD);
+    if (s_node_comm == MPI_COMM_NULL)
+        send_signal_to_ranks(signal, MPI_COMM_WORLD);
+    else
+        send_signal_to_ranks(signal, s_node_comm);
+
+    if (s_sub_master_comm != MPI_COMM_NULL)
+        send_signal_to_ranks(signal, s_sub_master_comm);
 
     // Terminate Worker associated with MPI process with rank 0
     MPIWorkerHandler::terminateStatic();
@@ -207,4 +680,7 @@ void MPIMaster::cleanup()
 
     if (!is_finalized)
         MPI_Finalize();
+
+    // Stop fork server
+    stop_fork_server();
 }
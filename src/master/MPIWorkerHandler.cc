@@ -1,5 +1,9 @@
 #include <string>
+#include <vector>
 #include <thread>
+#include <stdexcept>
+
+#include <assert.h>
 
 #include "core/common.h"
 #include "mpi/mpi_utils.h"
@@ -12,17 +16,34 @@
 // null communicators (MPI_COMM_NULL)
 MPI_Comm MPIWorkerHandler::s_child_comm = MPI_COMM_NULL;
 
+// Initialize rank of Worker leader and number of processes per Worker
+int MPIWorkerHandler::s_worker_rank = WORKER_RANK;
+int MPIWorkerHandler::s_worker_procs = 1;
+
+// Initialize prefetch window and number of prefetched input strings
+int MPIWorkerHandler::s_prefetch_window = 0;
+int MPIWorkerHandler::s_num_prefetched = 0;
+
+// Accept binary output unless the Controller interprets output as text
+bool MPIWorkerHandler::s_binary_output_accepted = true;
+
+// Initialize buffer for packed results
+std::vector<char> MPIWorkerHandler::s_result_buffer;
+
 MPIWorkerHandler::MPIWorkerHandler(const Command& simulator,
         const std::string& input_string) :
     AbstractWorkerHandler(simulator, input_string)
 {
     // Spawn  MPI child process if it has not yet been spawned
     if (s_child_comm == MPI_COMM_NULL)
-        s_child_comm = spawn_worker(m_simulator);
-
-    // Write input string to spawned MPI process
-    MPI_Send(input_string.c_str(), input_string.size() + 1, MPI_CHAR,
-            WORKER_RANK, MANAGER_MSG_TAG, s_child_comm);
+        s_child_comm = spawn_worker(m_simulator, s_worker_procs);
+
+    // Claim prefetched input string, or else write input string to spawned
+    // MPI process
+    if (s_num_prefetched > 0)
+        s_num_prefetched--;
+    else
+        sendInput(input_string);
 }
 
 MPIWorkerHandler::~MPIWorkerHandler()
@@ -35,49 +56,114 @@ bool MPIWorkerHandler::isDone()
 {
     // Probe for result if result has not yet been received
     if (    !m_result_received &&
-            iprobe_wrapper(WORKER_RANK, WORKER_MSG_TAG, s_child_comm))
+            iprobe_wrapper(s_worker_rank, WORKER_RESULT_TAG, s_child_comm))
     {
-        // Receive message
-        m_output_buffer.assign(receiveMessage());
-
-        // Receive error code
-        m_error_code = receiveErrorCode();
+        // Receive output string and error code
+        int payload_type = receiveResult(m_output_buffer, m_error_code);
 
         // Set flag
         m_result_received = true;
+
+        // Binary output cannot be interpreted as text.  The result has been
+        // received, so the Worker is idle when this handler is destroyed
+        if ((payload_type == DOUBLE_PAYLOAD) && !s_binary_output_accepted)
+        {
+            std::runtime_error e("binary output of MPI simulator is only "
+                    "supported by the sweep controller");
+            throw e;
+        }
     }
 
     return m_result_received;
 }
 
-std::string MPIWorkerHandler::receiveMessage() const
+void MPIWorkerHandler::sendInput(const std::string& input_string)
 {
-    return receive_string(s_child_comm, WORKER_RANK, WORKER_MSG_TAG);
+    MPI_Send(input_string.c_str(), input_string.size() + 1, MPI_CHAR,
+            s_worker_rank, MANAGER_MSG_TAG, s_child_comm);
 }
 
-int MPIWorkerHandler::receiveErrorCode() const
+int MPIWorkerHandler::receiveResult(std::string& output_string,
+        int& error_code)
 {
-    return receive_integer(s_child_comm, WORKER_RANK, WORKER_ERROR_CODE_TAG);
+    // Probe to get size of packed result
+    MPI_Status status;
+    MPI_Probe(s_worker_rank, WORKER_RESULT_TAG, s_child_comm, &status);
+
+    int count = 0;
+    MPI_Get_count(&status, MPI_PACKED, &count);
+    if (s_result_buffer.size() < static_cast<size_t>(count))
+        s_result_buffer.resize(count);
+
+    char *buffer = s_result_buffer.data();
+    MPI_Recv(buffer, count, MPI_PACKED, s_worker_rank, WORKER_RESULT_TAG,
+            s_child_comm, MPI_STATUS_IGNORE);
+
+    // Unpack error code, payload type and number of elements of payload
+    int position = 0;
+    int payload_type = TEXT_PAYLOAD;
+    int length = 0;
+    MPI_Unpack(buffer, count, &position, &error_code, 1, MPI_INT,
+            s_child_comm);
+    MPI_Unpack(buffer, count, &position, &payload_type, 1, MPI_INT,
+            s_child_comm);
+    MPI_Unpack(buffer, count, &position, &length, 1, MPI_INT, s_child_comm);
+
+    // Unpack payload into output string.  An array of doubles is stored as
+    // its raw bytes, so that it is never converted to text
+    MPI_Datatype datatype = MPI_CHAR;
+    size_t element_size = sizeof(char);
+    switch (payload_type)
+    {
+        case TEXT_PAYLOAD:
+            break;
+
+        case DOUBLE_PAYLOAD:
+            datatype = MPI_DOUBLE;
+            element_size = sizeof(double);
+            break;
+
+        default:
+            throw std::runtime_error("payload type of MPI Worker result "
+                    "not recognised");
+    }
+
+    output_string.resize(length * element_size);
+    if (length > 0)
+        MPI_Unpack(buffer, count, &position, &output_string[0], length,
+                datatype, s_child_comm);
+
+    return payload_type;
 }
 
 void MPIWorkerHandler::discardResults()
 {
-    // MPI does not provide process control, so
-    // we can only wait for the simulation to finish
-    // if it has not finished yet
+    // MPI does not provide process control, so the Worker is asked to
+    // cancel the simulation, and we wait for it to send its results.  A
+    // Worker that does not check for cancellation sends its results when the
+    // simulation has finished, and ignores the cancel signal.  Prefetched
+    // input strings belong to the same batch, so the cancel signal also
+    // makes the Worker drop them, replying to each with an empty result
     if (!m_result_received)
     {
-        // Timeout if message is not ready yet
-        while (!iprobe_wrapper(WORKER_RANK, WORKER_MSG_TAG, s_child_comm))
-            std::this_thread::sleep_for(g_main_timeout);
-
-        // Receive message
-        receiveMessage();
-
-        // Receive error code
-        receiveErrorCode();
+        int signal = CANCEL_WORKER_SIGNAL;
+        MPI_Send(&signal, 1, MPI_INT, s_worker_rank, MANAGER_SIGNAL_TAG,
+                s_child_comm);
+
+        std::string output_string;
+        int error_code = 0;
+        for (int i = 0; i <= s_num_prefetched; i++)
+        {
+            // Timeout if result is not ready yet
+            while (!iprobe_wrapper(s_worker_rank, WORKER_RESULT_TAG,
+                        s_child_comm))
+                std::this_thread::sleep_for(g_main_timeout);
+
+            receiveResult(output_string, error_code);
+        }
 
         // Set flag
+        s_num_prefetched = 0;
         m_result_received = true;
     }
 }
@@ -94,9 +180,54 @@ void MPIWorkerHandler::terminateStatic()
 
     // Else, send termination signal to Worker
     int signal = TERMINATE_WORKER_SIGNAL;
-    MPI_Send(&signal, 1, MPI_INT, WORKER_RANK, MANAGER_SIGNAL_TAG,
+    MPI_Send(&signal, 1, MPI_INT, s_worker_rank, MANAGER_SIGNAL_TAG,
             s_child_comm);
 
     // Free communicator
     MPI_Comm_disconnect(&s_child_comm);
 }
+
+void MPIWorkerHandler::setWorkerProcs(int procs)
+{
+    s_worker_procs = procs;
+}
+
+void MPIWorkerHandler::setBinaryOutputAccepted(bool accepted)
+{
+    s_binary_output_accepted = accepted;
+}
+
+void MPIWorkerHandler::spawnCollectively(const Command& simulator)
+{
+    s_child_comm = spawn_workers_collectively(simulator, s_worker_procs);
+
+    // Worker groups are ordered by the rank of their Manager
+    int rank = 0;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    s_worker_rank = rank * s_worker_procs;
+}
+
+void MPIWorkerHandler::setPrefetchWindow(int window)
+{
+    s_prefetch_window = window;
+}
+
+bool MPIWorkerHandler::canPrefetch()
+{
+    return s_num_prefetched < s_prefetch_window;
+}
+
+int MPIWorkerHandler::numPrefetched()
+{
+    return s_num_prefetched;
+}
+
+void MPIWorkerHandler::prefetch(const std::string& input_string)
+{
+    // Sanity check: the MPI Worker has been spawned by the running
+    // MPIWorkerHandler
+    assert(s_child_comm != MPI_COMM_NULL);
+
+    sendInput(input_string);
+    s_num_prefetched++;
+}
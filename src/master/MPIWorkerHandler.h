@@ -2,6 +2,7 @@
 #define MPIWORKERHANDLER_H
 
 #include <string>
+#include <vector>
 
 #include <mpi.h>
 
@@ -18,6 +19,25 @@
  * accept more simulation tasks.  Each simulation task is represented by a new
  * instance of MPIWorkerHandler.  Only when terminateStatic() is called will
  * the MPI Worker process be terminated.
+ *
+ * An MPI Worker may consist of a group of several MPI processes (see
+ * setWorkerProcs()).  The MPIWorkerHandler then only communicates with the
+ * leader of the group, which distributes every simulation task to the rest of
+ * the group.  By default, every Manager spawns its MPI Worker when it receives
+ * its first simulation task.  Alternatively, the MPI Workers of all Managers
+ * can be spawned together at startup with spawnCollectively().
+ *
+ * To avoid leaving the MPI Worker idle between short simulations, the input
+ * strings of subsequent simulation tasks may be sent to the MPI Worker with
+ * prefetch() while the current simulation is running (see
+ * setPrefetchWindow()).  The MPI Worker queues these input strings and starts
+ * the next simulation as soon as it has sent the result of the previous one.
+ * Every result consists of a single message that contains both the output
+ * string and the error code.  The output of an MPI Worker may also be a
+ * binary array of doubles, in which case the output string holds the raw
+ * bytes of the array.  Binary output is rejected with an error if the
+ * Controller interprets output strings as text (see
+ * setBinaryOutputAccepted()).
  */
 
 class MPIWorkerHandler : public AbstractWorkerHandler
@@ -37,7 +57,9 @@ class MPIWorkerHandler : public AbstractWorkerHandler
          * child process.
          *
          * In both cases, the input string is then sent to the MPI Worker via
-         * standard MPI functions on the intercommunicator.
+         * standard MPI functions on the intercommunicator, unless it has
+         * already been sent with prefetch().  In that case, the input string
+         * must be the earliest input string that was prefetched.
          *
          * @param simulator  command to run simulation.
          * @param input_string  input string to simulator.
@@ -47,9 +69,13 @@ class MPIWorkerHandler : public AbstractWorkerHandler
 
         /** Destructor.
          *
-         * The destructor waits for the MPI Worker to finish its simulation
-         * task and send its output string and error code if it has not yet
-         * done so.
+         * If the MPI Worker has not yet sent its output string and error
+         * code, the destructor asks it to cancel its simulation task and
+         * waits for it to send them.  The MPI Worker cancels the simulation
+         * only if the simulator checks for cancellation (see
+         * pakman_should_cancel() and PakmanMPIWorker::shouldCancel()).  Any
+         * prefetched simulation tasks are cancelled as well, since they
+         * belong to the same batch of tasks.
          *
          * We assume that the MPI child process does not exit after sending its
          * results, but rather stays alive to accept further simulation tasks.
@@ -71,13 +97,69 @@ class MPIWorkerHandler : public AbstractWorkerHandler
          */
         static void terminateStatic();
 
+        /** Set number of MPI processes in every MPI Worker.
+         *
+         * This function must be called before any MPI Worker is spawned.
+         *
+         * @param procs  number of MPI processes per MPI Worker.
+         */
+        static void setWorkerProcs(int procs);
+
+        /** Set whether binary output of MPI Workers is accepted.
+         *
+         * Binary output is accepted by default.  If it is not, receiving an
+         * array of doubles from an MPI Worker throws an error.
+         *
+         * @param accepted  whether binary output is accepted.
+         */
+        static void setBinaryOutputAccepted(bool accepted);
+
+        /** Spawn MPI Workers of all Managers.
+         *
+         * This function is collective over `MPI_COMM_WORLD` and spawns one MPI
+         * Worker for every MPI process with a single call to
+         * `MPI_Comm_spawn_multiple`.  The MPI Workers share one
+         * intercommunicator, in which every Manager communicates with the
+         * leader of its own MPI Worker.
+         *
+         * @param simulator  command to run MPI Worker.
+         */
+        static void spawnCollectively(const Command& simulator);
+
+        /** Set maximum number of prefetched input strings.
+         *
+         * @param window  maximum number of input strings that are sent to
+         * the MPI Worker in addition to the input string of the running
+         * simulation task.
+         */
+        static void setPrefetchWindow(int window);
+
+        /** @return whether another input string can be prefetched. */
+        static bool canPrefetch();
+
+        /** @return number of prefetched input strings that have not yet
+         * been claimed by an MPIWorkerHandler. */
+        static int numPrefetched();
+
+        /** Send input string of a future simulation task to the MPI Worker.
+         *
+         * This function must only be called while an MPIWorkerHandler
+         * exists, and the input strings must be prefetched in the order in
+         * which the corresponding MPIWorkerHandlers are constructed.
+         *
+         * @param input_string  input string to simulator.
+         */
+        static void prefetch(const std::string& input_string);
+
     private:
 
-        // Receive message from Worker
-        std::string receiveMessage() const;
+        // Send input string to MPI Worker
+        static void sendInput(const std::string& input_string);
 
-        // Receive error code from Worker
-        int receiveErrorCode() const;
+        // Receive combined output string and error code from Worker and
+        // return payload type
+        static int receiveResult(std::string& output_string,
+                int& error_code);
 
         // Discard results from MPI process
         void discardResults();
@@ -87,6 +169,24 @@ class MPIWorkerHandler : public AbstractWorkerHandler
         // instances of MPIWorkerHandler
         static MPI_Comm s_child_comm;
 
+        // Rank of leader of MPI Worker in remote group of s_child_comm
+        static int s_worker_rank;
+
+        // Number of MPI processes per MPI Worker
+        static int s_worker_procs;
+
+        // Maximum number of prefetched input strings
+        static int s_prefetch_window;
+
+        // Number of prefetched input strings that have not yet been claimed
+        static int s_num_prefetched;
+
+        // Whether binary output is accepted
+        static bool s_binary_output_accepted;
+
+        // Buffer for packed results, which is reused across results
+        static std::vector<char> s_result_buffer;
+
         // Flag for receiving result
         bool m_result_received = false;
 };
@@ -1,5 +1,10 @@
 #include <string>
 #include <memory>
+#include <thread>
+#include <chrono>
+#include <stdexcept>
+#include <sstream>
+#include <algorithm>
 
 #include <assert.h>
 
@@ -10,40 +15,56 @@
 #include "core/common.h"
 #include "mpi/mpi_common.h"
 #include "mpi/mpi_utils.h"
+#include "system/plugin.h"
+#include "interface/protocols.h"
+#include "controller/ProposalGenerator.h"
 
 #include "ForkedWorkerHandler.h"
 #include "MPIWorkerHandler.h"
+#include "PersistentWorker.h"
+#include "PersistentWorkerHandler.h"
+#include "ProposalWorkerHandler.h"
+#include "PluginWorkerHandler.h"
 
 #include "Manager.h"
 
-// Construct from simulator, pointer to program terminated flag, and
-// Worker type (forked vs MPI)
+// Construct from simulator, pointer to program terminated flag, Worker type
+// (forked, MPI or persistent), pointer to ProposalGenerator, number of Worker
+// slots, communicator shared with master and work stealing flag
 Manager::Manager(const Command &simulator, worker_t worker_type,
-        bool *p_program_terminated) :
+        bool *p_program_terminated,
+        std::shared_ptr<ProposalGenerator> p_proposal_generator,
+        int num_workers, MPI_Comm comm, bool work_stealing) :
     m_simulator(simulator),
+    m_plugin_simulator(is_plugin(simulator)),
     m_worker_type(worker_type),
-    m_p_program_terminated(p_program_terminated)
+    m_p_program_terminated(p_program_terminated),
+    m_p_proposal_generator(p_proposal_generator),
+    m_num_workers(num_workers),
+    m_comm(comm),
+    m_persistent_workers(num_workers),
+    m_worker_handlers(num_workers),
+    m_slot_batches(num_workers, 0),
+    m_slot_tasks(num_workers, 0),
+    m_master_messages(comm),
+    m_work_stealing(work_stealing),
+    m_slot_stolen_tasks(num_workers),
+    m_steal_victim(get_mpi_comm_rank(comm)),
+    m_failed_steals(get_mpi_comm_size(comm) - 1),
+    m_manager_messages(comm)
 {
+    // Sanity check: an MPI Worker is managed through static state, so there
+    // can only be one per Manager
+    if (m_num_workers < 1 || (m_worker_type == mpi_worker &&
+                m_num_workers > 1))
+    {
+        std::runtime_error e("invalid number of Workers per Manager");
+        throw e;
+    }
 }
 
-// Destroy MPI_Request objects
-Manager::~Manager()
-{
-    // If MPI_Finalize has been called, nothing needs to be done
-    int finalized = 0;
-    MPI_Finalized(&finalized);
-
-    if (finalized)
-        return;
-
-    // Else free any non-null requests
-    if (m_message_request != MPI_REQUEST_NULL)
-        MPI_Request_free(&m_message_request);
-    if (m_signal_request != MPI_REQUEST_NULL)
-        MPI_Request_free(&m_signal_request);
-    if (m_error_code_request != MPI_REQUEST_NULL)
-        MPI_Request_free(&m_error_code_request);
-}
+// Destroy Manager where AbstractWorkerHandler is a complete type
+Manager::~Manager() = default;
 
 // Probe whether Manager is active
 bool Manager::isActive() const
@@ -51,6 +72,12 @@ bool Manager::isActive() const
     return m_state != terminated;
 }
 
+// Probe whether Manager is waiting for a message
+bool Manager::awaitsMessages() const
+{
+    return m_state == idle || m_steal_pending;
+}
+
 // Iterate
 void Manager::iterate()
 {
@@ -58,6 +85,8 @@ void Manager::iterate()
     // terminated
     assert(m_state != terminated);
 
+    m_master_messages.complete();
+
     // Switch based on state
     switch (m_state)
     {
@@ -74,11 +103,45 @@ void Manager::iterate()
     }
 }
 
+// Wait for Workers
+bool Manager::waitForWorker(std::chrono::microseconds timeout)
+{
+    // If there is no Worker, there is nothing to wait for
+    if (m_num_busy == 0)
+    {
+        std::this_thread::sleep_for(timeout);
+        return false;
+    }
+
+    // A single Worker waits on its own pipes
+    if (m_num_workers == 1)
+        return m_worker_handlers[0]->waitForOutput(timeout);
+
+    // Workers without a read pipe are checked directly
+    for (int slot : m_unwatched_slots)
+        if (m_worker_handlers[slot]->isDone())
+            return true;
+
+    // epoll_wait() has a resolution of milliseconds, so sleep for shorter
+    // timeouts after checking the Workers once
+    int timeout_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+            timeout).count();
+
+    m_ready_slots.clear();
+    if (m_supervisor.wait(timeout_ms, m_ready_slots) > 0)
+        return true;
+
+    if (timeout_ms == 0)
+        std::this_thread::sleep_for(timeout);
+
+    return false;
+}
+
 // Do idle stuff
 void Manager::doIdleStuff()
 {
-    // Sanity check: m_p_worker_handler should be the null pointer
-    assert(!m_p_worker_handler);
+    // Sanity check: no Worker should be busy
+    assert(m_num_busy == 0);
 
     // Check for program termination interrupt
     if (*m_p_program_terminated)
@@ -103,15 +166,15 @@ void Manager::doIdleStuff()
                 m_state = terminated;
                 return;
 
-            // An idle Manager can receive FLUSH_WORKER_SIGNAL when the Master
-            // has not yet checked for the Manager's message.  In this case,
-            // nothing needs to be done
+            // An idle Manager has no batches to discard, so it only needs
+            // to enter the new epoch
             case FLUSH_WORKER_SIGNAL:
 
                 spdlog::debug("Idle manager {}/{}: received "
                         "FLUSH_WORKER_SIGNAL!",
                         get_mpi_comm_world_rank(), get_mpi_comm_world_size());
 
+                advanceEpoch(++m_flush_signal_count);
                 return;
 
             // TERMINATE_MANAGER_SIGNAL and FLUSH_WORKER_SIGNAL are the
@@ -127,27 +190,32 @@ void Manager::doIdleStuff()
         spdlog::debug("Idle manager {}/{}: received message!",
                 get_mpi_comm_world_rank(), get_mpi_comm_world_size());
 
-        // Receive input string and create new Worker
-        std::string input_string = receiveMessage();
-        createWorker(input_string);
-
-        // Switch to busy state
-        m_state = busy;
+        // Receive batch of input strings and create Workers for them
+        receiveBatch();
+        startNextTasks();
         return;
     }
+
+    // An idle Manager may still be waiting for the results of stolen tasks,
+    // and may steal tasks itself
+    if (m_work_stealing)
+    {
+        stealTasks();
+        startNextTasks();
+    }
 }
 
 // Do busy stuff
 void Manager::doBusyStuff()
 {
-    // Sanity check: m_p_worker_handler should not be the null pointer
-    assert(m_p_worker_handler);
+    // Sanity check: at least one Worker should be busy
+    assert(m_num_busy > 0);
 
     // Check for program termination interrupt
     if (*m_p_program_terminated)
     {
-        // Terminate Worker
-        terminateWorker();
+        // Terminate Workers
+        terminateWorkers();
 
         // Terminate Manager
         m_state = terminated;
@@ -165,8 +233,9 @@ void Manager::doBusyStuff()
                         "TERMINATE_MANAGER_SIGNAL!",
                         get_mpi_comm_world_rank(), get_mpi_comm_world_size());
 
-                // Terminate Worker
-                terminateWorker();
+                // Terminate Workers and discard rest of batches
+                terminateWorkers();
+                discardBatch();
 
                 // Terminate Manager
                 m_state = terminated;
@@ -178,14 +247,12 @@ void Manager::doBusyStuff()
                         "FLUSH_WORKER_SIGNAL!",
                         get_mpi_comm_world_rank(), get_mpi_comm_world_size());
 
-                // Flush Worker
-                flushWorker();
-
-                // Send WORKER_FLUSHED_SIGNAL result
-                sendSignalToMaster(WORKER_FLUSHED_SIGNAL);
+                // Discard batches of earlier epochs.  Batches of the new
+                // epoch may already have been received, since signals and
+                // messages can overtake each other
+                advanceEpoch(++m_flush_signal_count);
 
-                // Switch to idle state
-                m_state = idle;
+                startNextTasks();
                 return;
 
             // TERMINATE_MANAGER_SIGNAL and FLUSH_WORKER_SIGNAL are the
@@ -195,164 +262,608 @@ void Manager::doBusyStuff()
         }
     }
 
-    // Check if Worker has finished
-    if (m_p_worker_handler->isDone())
+    // Queue any batches prefetched by the Master.  A batch of a later epoch
+    // terminates the Workers
+    while (probeMessage())
+        receiveBatch();
+
+    if (m_work_stealing)
+        stealTasks();
+
+    // Fill slots that are idle
+    startNextTasks();
+    if (m_num_busy == 0)
+        return;
+
+    prefetchInputs();
+
+    // Check if Workers have finished
+    collectReadySlots();
+
+    // Skip slots that have been flushed since they were reported
+    bool worker_done = false;
+    for (int slot : m_ready_slots)
     {
-        spdlog::debug("Busy manager {}/{}: Worker is done!",
-                get_mpi_comm_world_rank(), get_mpi_comm_world_size());
+        if (!m_worker_handlers[slot])
+            continue;
+
+        if (!m_worker_handlers[slot]->isDone())
+            continue;
+
+        spdlog::debug("Busy manager {}/{}: Worker in slot {} is done!",
+                get_mpi_comm_world_rank(), get_mpi_comm_world_size(), slot);
+
+        recordResult(slot);
+        worker_done = true;
+    }
+
+    if (!worker_done)
+        return;
+
+    // Send results of completed batches to master
+    sendCompletedBatches();
+
+    // If there are more tasks, create Workers for them
+    startNextTasks();
+}
+
+// Collect busy slots whose Workers may have finished
+void Manager::collectReadySlots()
+{
+    m_ready_slots.clear();
+
+    // A single Worker is always checked
+    if (m_num_workers == 1)
+    {
+        m_ready_slots.push_back(0);
+        return;
+    }
+
+    m_ready_slots.assign(m_unwatched_slots.begin(), m_unwatched_slots.end());
+    m_supervisor.wait(0, m_ready_slots);
+}
+
+// Record result of finished Worker in slot and flush it
+void Manager::recordResult(int slot)
+{
+    // Send result of stolen task to the Manager it was stolen from
+    if (m_slot_batches[slot] < 0)
+    {
+        const StolenTask& task = m_slot_stolen_tasks[slot];
+
+        std::string message = std::to_string(task.batch) + ' ' +
+            std::to_string(task.task) + '\n';
+        message += format_persistent_simulator_output(
+                m_worker_handlers[slot]->getOutput(),
+                m_worker_handlers[slot]->getErrorCode());
+
+        m_manager_messages.send(task.owner_rank, STOLEN_RESULT_TAG, message);
+
+        flushWorker(slot);
+        return;
+    }
+
+    Batch& batch = m_batches[m_slot_batches[slot] - m_front_batch];
+
+    batch.outputs[m_slot_tasks[slot]] = format_persistent_simulator_output(
+            m_worker_handlers[slot]->getOutput(),
+            m_worker_handlers[slot]->getErrorCode());
+    batch.num_finished++;
+
+    flushWorker(slot);
+}
+
+// Send results of completed batches at the front of the queue to Master
+void Manager::sendCompletedBatches()
+{
+    while (!m_batches.empty() &&
+            (m_batches.front().num_finished == m_batches.front().size))
+    {
+        m_batch_outputs.clear();
+        for (const std::string& output : m_batches.front().outputs)
+            m_batch_outputs += output;
+
+        m_master_messages.send(MASTER_RANK, MANAGER_MSG_TAG, m_batch_outputs);
+
+        m_batches.pop_front();
+        m_front_batch++;
+    }
+}
+
+// Enter epoch, discarding batches of earlier epochs
+void Manager::advanceEpoch(int epoch)
+{
+    if (epoch <= m_epoch)
+        return;
+
+    spdlog::debug("Manager {}/{}: entering epoch {}",
+            get_mpi_comm_world_rank(), get_mpi_comm_world_size(), epoch);
+
+    m_epoch = epoch;
+    discardStaleBatches();
+    discardStolenTasks();
+}
+
+// Reply to batches of earlier epochs with empty messages and discard them
+void Manager::discardStaleBatches()
+{
+    // Batches are received in order of epoch, so stale batches are at the
+    // front of the queue
+    while (!m_batches.empty() && (m_batches.front().epoch < m_epoch))
+    {
+        // Flush Workers of front batch
+        for (int slot = 0; slot < m_num_workers; slot++)
+            if (m_worker_handlers[slot] &&
+                    (m_slot_batches[slot] == m_front_batch))
+                flushWorker(slot);
+
+        // Discard input strings of batch that have not been started.  Tasks
+        // are started in order, so these are at the front of the queue
+        if (m_next_batch == m_front_batch)
+        {
+            for (int i = m_next_task; i < m_batches.front().num_local; i++)
+                m_batch_inputs.pop_front();
+
+            m_next_batch++;
+            m_next_task = 0;
+        }
+
+        // Reply with empty message so that the Master can account for batch
+        m_batch_outputs.clear();
+        m_master_messages.send(MASTER_RANK, MANAGER_MSG_TAG, m_batch_outputs);
+
+        m_batches.pop_front();
+        m_front_batch++;
+    }
+}
+
+// Create Workers for queued tasks in idle slots, or switch to idle state if
+// no Worker is busy
+void Manager::startNextTasks()
+{
+    for (int slot = 0; (slot < m_num_workers) &&
+            !(m_batch_inputs.empty() && m_stolen_tasks.empty()); slot++)
+    {
+        if (m_worker_handlers[slot])
+            continue;
+
+        // Stolen tasks are only started when the Manager has no tasks of its
+        // own, and are marked with a negative batch number
+        if (m_batch_inputs.empty())
+        {
+            m_slot_batches[slot] = -1;
+            m_slot_stolen_tasks[slot] = std::move(m_stolen_tasks.front());
+            m_stolen_tasks.pop_front();
+
+            createWorker(slot, m_slot_stolen_tasks[slot].input);
+            continue;
+        }
+
+        // Record which task the slot works on
+        m_slot_batches[slot] = m_next_batch;
+        m_slot_tasks[slot] = m_next_task;
+
+        if (++m_next_task ==
+                m_batches[m_next_batch - m_front_batch].num_local)
+        {
+            m_next_batch++;
+            m_next_task = 0;
+        }
+
+        createWorker(slot, m_batch_inputs.front());
+        m_batch_inputs.pop_front();
+    }
+
+    m_state = (m_num_busy > 0) ? busy : idle;
+
+    if (m_state == busy)
+        prefetchInputs();
+}
+
+// Send input strings of queued tasks to MPI Worker ahead of time.  All queued
+// batches belong to the current epoch, so the prefetched tasks are discarded
+// together with the running task when the Manager enters a new epoch
+void Manager::prefetchInputs()
+{
+    // Prefetching is only supported when the input strings are the simulator
+    // input of an MPI Worker
+    if (    m_worker_type != mpi_worker || m_p_proposal_generator
+            || m_plugin_simulator || !m_worker_handlers[0])
+        return;
+
+    for (size_t i = MPIWorkerHandler::numPrefetched();
+            i < m_batch_inputs.size() && MPIWorkerHandler::canPrefetch();
+            i++)
+        MPIWorkerHandler::prefetch(m_batch_inputs[i]);
+}
+
+// Serve steal requests, receive stolen tasks and their results, and send a
+// steal request if there are no tasks left to start
+void Manager::stealTasks()
+{
+    m_manager_messages.complete();
+
+    // Serve steal requests of other Managers
+    MPI_Status status;
+    while (iprobe_wrapper(MPI_ANY_SOURCE, STEAL_REQUEST_TAG, m_comm, &status))
+        serveStealRequest(status.MPI_SOURCE);
+
+    // Record results of tasks that other Managers have stolen
+    bool result_received = false;
+    while (iprobe_wrapper(MPI_ANY_SOURCE, STOLEN_RESULT_TAG, m_comm, &status))
+    {
+        receiveStolenResult(status.MPI_SOURCE);
+        result_received = true;
+    }
+
+    if (result_received)
+        sendCompletedBatches();
+
+    // Receive reply to steal request
+    if (m_steal_pending &&
+            iprobe_wrapper(m_steal_victim, STEAL_REPLY_TAG, m_comm))
+        receiveStealReply();
+
+    // Steal as soon as the last task has been started rather than when a
+    // slot becomes idle, so that the stolen tasks arrive in time
+    const int comm_size = get_mpi_comm_size(m_comm);
+    if (m_steal_pending || !m_batch_inputs.empty() || !m_stolen_tasks.empty()
+            || (m_failed_steals >= comm_size - 1))
+        return;
+
+    // Ask the other Managers in turn, starting with the Manager after this
+    // one.  A Manager that had tasks to give away is asked again
+    const int rank = get_mpi_comm_rank(m_comm);
+    if ((m_failed_steals > 0) || (m_steal_victim == rank))
+        m_steal_victim = (m_steal_victim + 1) % comm_size;
+    if (m_steal_victim == rank)
+        m_steal_victim = (m_steal_victim + 1) % comm_size;
+
+    spdlog::debug("Manager {}/{}: stealing from manager {}",
+            get_mpi_comm_world_rank(), get_mpi_comm_world_size(),
+            m_steal_victim);
+
+    // The steal request carries the epoch of the thief, since tasks of
+    // another epoch would be discarded by either the thief or the victim
+    std::string request = std::to_string(m_epoch);
+    m_manager_messages.send(m_steal_victim, STEAL_REQUEST_TAG, request);
+    m_steal_pending = true;
+}
+
+// Give away tasks to Manager that sent steal request
+void Manager::serveStealRequest(int thief_rank)
+{
+    receive_string(m_comm, thief_rank, STEAL_REQUEST_TAG, m_receive_buffer);
+    int thief_epoch = std::stoi(m_receive_buffer);
+
+    // Only tasks at the end of the last batch that have not been started are
+    // given away, so that the remaining tasks of every batch are still
+    // consecutive.  Tasks that have been sent to an MPI Worker ahead of time
+    // cannot be given away
+    int num_stealable = 0;
+    long last_batch = m_front_batch +
+        static_cast<long>(m_batches.size()) - 1;
+
+    if (!m_batches.empty() && (thief_epoch == m_epoch) &&
+            (m_batches.back().epoch == m_epoch) &&
+            (m_next_batch <= last_batch))
+    {
+        int num_prefetched = (m_worker_type == mpi_worker) ?
+            MPIWorkerHandler::numPrefetched() : 0;
+
+        num_stealable = m_batches.back().num_local -
+            ((m_next_batch == last_batch) ? m_next_task : 0);
+        num_stealable = std::min<int>(num_stealable,
+                m_batch_inputs.size() - num_prefetched);
+    }
+
+    // Give away half of the tasks, keeping at least one
+    int num_stolen = num_stealable / 2;
+
+    std::string reply = std::to_string(m_epoch) + ' ' +
+        std::to_string(last_batch) + ' ';
+
+    if (num_stolen > 0)
+    {
+        Batch& batch = m_batches.back();
+        batch.num_local -= num_stolen;
+        reply += std::to_string(batch.num_local);
+    }
+    else
+        reply += '0';
+
+    reply += '\n';
+
+    for (size_t i = m_batch_inputs.size() - num_stolen;
+            i < m_batch_inputs.size(); i++)
+        reply += format_persistent_simulator_input(m_batch_inputs[i]);
+
+    m_batch_inputs.resize(m_batch_inputs.size() - num_stolen);
+
+    spdlog::debug("Manager {}/{}: giving {} tasks to manager {}",
+            get_mpi_comm_world_rank(), get_mpi_comm_world_size(),
+            num_stolen, thief_rank);
+
+    m_manager_messages.send(thief_rank, STEAL_REPLY_TAG, reply);
+}
+
+// Receive reply to steal request
+void Manager::receiveStealReply()
+{
+    receive_string(m_comm, m_steal_victim, STEAL_REPLY_TAG,
+            m_receive_buffer);
+    m_steal_pending = false;
+
+    // Parse header with epoch, batch number and index of first task
+    std::string& message = m_receive_buffer;
+    std::string::size_type newline = message.find('\n');
+    if (newline == std::string::npos)
+    {
+        std::runtime_error e("cannot parse reply to steal request");
+        throw e;
+    }
+
+    int epoch = 0;
+    long batch = 0;
+    int first_task = 0;
+    std::istringstream header(message.substr(0, newline));
+    header >> epoch >> batch >> first_task;
+    message.erase(0, newline + 1);
+
+    // A reply of a later epoch means that the Master has been flushed
+    advanceEpoch(epoch);
+
+    // Queue stolen tasks unless they belong to an earlier epoch
+    int num_stolen = 0;
+    std::string input_string;
+    while (parse_persistent_simulator_input(message, input_string))
+    {
+        if (epoch == m_epoch)
+            m_stolen_tasks.push_back({m_steal_victim, batch,
+                    first_task + num_stolen, input_string});
+        num_stolen++;
+    }
 
-        // Get output string
-        std::string output_string = m_p_worker_handler->getOutput();
+    // Sanity check: reply should be completely parsed
+    if (!message.empty())
+    {
+        std::runtime_error e("cannot parse tasks in reply to steal request");
+        throw e;
+    }
 
-        // Get error code
-        int error_code = m_p_worker_handler->getErrorCode();
+    if (num_stolen > 0)
+        m_failed_steals = 0;
+    else
+        m_failed_steals++;
+}
 
-        // Send output string to master
-        sendMessageToMaster(output_string);
+// Receive result of task that was stolen from this Manager
+void Manager::receiveStolenResult(int thief_rank)
+{
+    receive_string(m_comm, thief_rank, STOLEN_RESULT_TAG, m_receive_buffer);
 
-        // Send error code to master
-        sendErrorCodeToMaster(error_code);
+    // Parse header with batch number and index of task
+    std::string& message = m_receive_buffer;
+    std::string::size_type newline = message.find('\n');
+    if (newline == std::string::npos)
+    {
+        std::runtime_error e("cannot parse result of stolen task");
+        throw e;
+    }
 
-        // Flush Worker
-        flushWorker();
+    long batch_number = 0;
+    int task = 0;
+    std::istringstream header(message.substr(0, newline));
+    header >> batch_number >> task;
 
-        // Switch to idle state
-        m_state = idle;
+    // Results of batches that have been discarded are ignored
+    if ((batch_number < m_front_batch) ||
+            (batch_number >= m_front_batch +
+             static_cast<long>(m_batches.size())))
         return;
+
+    // The result is an output frame already
+    Batch& batch = m_batches[batch_number - m_front_batch];
+    batch.outputs[task] = message.substr(newline + 1);
+    batch.num_finished++;
+}
+
+// Discard stolen tasks, which belong to batches of earlier epochs
+void Manager::discardStolenTasks()
+{
+    m_stolen_tasks.clear();
+
+    for (int slot = 0; slot < m_num_workers; slot++)
+        if (m_worker_handlers[slot] && (m_slot_batches[slot] < 0))
+            flushWorker(slot);
+}
+
+// Create Worker in slot
+void Manager::createWorker(int slot, const std::string& input_string)
+{
+    // Sanity check: slot should be idle
+    assert(!m_worker_handlers[slot]);
+
+    // If proposals are not distributed, the input string is the simulator
+    // input
+    if (!m_p_proposal_generator)
+        m_worker_handlers[slot] = makeWorkerHandler(slot, input_string);
+
+    // Else generate parameter, and simulate it if it lies in the support of
+    // the prior
+    else
+    {
+        Parameter parameter;
+        double prior_pdf = 0.0;
+        std::string simulator_input;
+        std::unique_ptr<AbstractWorkerHandler> p_worker_handler;
+
+        if (m_p_proposal_generator->generate(input_string, parameter,
+                    prior_pdf, simulator_input))
+            p_worker_handler = makeWorkerHandler(slot, simulator_input);
+
+        m_worker_handlers[slot] =
+            std::unique_ptr<ProposalWorkerHandler>(
+                    new ProposalWorkerHandler(m_simulator, input_string,
+                        parameter, prior_pdf, std::move(p_worker_handler)));
     }
 
-    // Sanity check: No message should be received in the busy state
-    assert(probeMessage() == false);
+    m_num_busy++;
+
+    // Watch pipes of Worker if there are several slots
+    if (m_num_workers == 1)
+        return;
+
+    if (!m_worker_handlers[slot]->watch(m_supervisor, slot))
+        m_unwatched_slots.insert(slot);
 }
 
-// Create Worker
-void Manager::createWorker(const std::string& input_string)
+// Make Worker handler of configured Worker type for slot
+std::unique_ptr<AbstractWorkerHandler> Manager::makeWorkerHandler(int slot,
+        const std::string& input_string)
 {
-    // Sanity check: m_p_worker_handler should be the null pointer
-    assert(!m_p_worker_handler);
+    // Plugin simulators are called directly, whatever the Worker type
+    if (m_plugin_simulator)
+        return std::unique_ptr<PluginWorkerHandler>(
+                new PluginWorkerHandler(m_simulator, input_string));
 
     // Switch on Worker type
     switch (m_worker_type)
     {
         // Fork Worker
         case forked_worker:
-            m_p_worker_handler =
-                std::unique_ptr<ForkedWorkerHandler>(
-                        new ForkedWorkerHandler(m_simulator, input_string));
-            break;
+            return std::unique_ptr<ForkedWorkerHandler>(
+                    new ForkedWorkerHandler(m_simulator, input_string));
 
         // Spawn MPI Worker
         case mpi_worker:
-            m_p_worker_handler =
-                std::unique_ptr<MPIWorkerHandler>(
-                        new MPIWorkerHandler(m_simulator, input_string));
-            break;
+            return std::unique_ptr<MPIWorkerHandler>(
+                    new MPIWorkerHandler(m_simulator, input_string));
+
+        // Reuse persistent Worker
+        case persistent_worker:
+            return std::unique_ptr<PersistentWorkerHandler>(
+                    new PersistentWorkerHandler(m_simulator, input_string,
+                        m_persistent_workers[slot]));
 
         default:
             throw std::runtime_error("Worker type not recognised");
     }
 }
 
-// Flush Worker
-void Manager::flushWorker()
+// Flush Worker in slot
+void Manager::flushWorker(int slot)
 {
-    // Sanity check: This function should not be called when
-    // m_p_worker_handler is the null pointer
-    assert(m_p_worker_handler);
+    // Sanity check: This function should not be called when the slot is
+    // idle
+    assert(m_worker_handlers[slot]);
+
+    m_unwatched_slots.erase(slot);
 
-    // Reset m_p_worker_handler to null pointer,
-    // this flushes the worker
-    m_p_worker_handler.reset();
+    // Reset Worker handler to null pointer, this flushes the Worker and
+    // stops watching its pipes
+    m_worker_handlers[slot].reset();
+    m_num_busy--;
 }
 
-// Terminate Worker
-void Manager::terminateWorker()
+// Terminate all Workers
+void Manager::terminateWorkers()
 {
-    // Sanity check: This function should not be called when
-    // m_p_worker_handler is the null pointer
-    assert(m_p_worker_handler);
-
-    // Reset m_p_worker_handler to null pointer
-    m_p_worker_handler.reset();
+    for (int slot = 0; slot < m_num_workers; slot++)
+        if (m_worker_handlers[slot])
+            flushWorker(slot);
 }
 
 // Probe for message
 bool Manager::probeMessage() const
 {
-    return iprobe_wrapper(MASTER_RANK, MASTER_MSG_TAG, MPI_COMM_WORLD);
+    return iprobe_wrapper(MASTER_RANK, MASTER_MSG_TAG, m_comm);
 }
 
 // Probe for signal
 bool Manager::probeSignal() const
 {
-    return iprobe_wrapper(MASTER_RANK, MASTER_SIGNAL_TAG, MPI_COMM_WORLD);
+    return iprobe_wrapper(MASTER_RANK, MASTER_SIGNAL_TAG, m_comm);
 }
 
-// Receive message
-std::string Manager::receiveMessage() const
+// Receive message into receive buffer
+std::string& Manager::receiveMessage()
 {
     // Sanity check: probeMessage must return true
     assert(probeMessage());
 
-    return receive_string(MPI_COMM_WORLD, MASTER_RANK, MASTER_MSG_TAG);
+    receive_string(m_comm, MASTER_RANK, MASTER_MSG_TAG,
+            m_receive_buffer);
+    return m_receive_buffer;
 }
 
-// Receive signal
-int Manager::receiveSignal() const
+// Receive batch of input strings and append to queue of input strings
+void Manager::receiveBatch()
 {
-    // Sanity check: probeSignal must return true
-    assert(probeSignal());
+    std::string& message = receiveMessage();
 
-    return receive_integer(MPI_COMM_WORLD, MASTER_RANK, MASTER_SIGNAL_TAG);
-}
+    // Parse epoch header
+    std::string::size_type newline = message.find('\n');
+    if (newline == std::string::npos)
+    {
+        std::runtime_error e("cannot parse epoch of batch from Master");
+        throw e;
+    }
 
-// Send message to Master
-void Manager::sendMessageToMaster(const std::string& message_string)
-{
-    // Ensure previous message has finished sending
-    MPI_Wait(&m_message_request, MPI_STATUS_IGNORE);
-
-    // Store message string in buffer
-    m_message_buffer.assign(message_string);
-
-    // Note: Isend is used here to avoid deadlock since the Master and the root
-    // Manager are executed by the same process
-    MPI_Isend(
-            m_message_buffer.c_str(),
-            m_message_buffer.size() + 1,
-            MPI_CHAR, MASTER_RANK, MANAGER_MSG_TAG,
-            MPI_COMM_WORLD,
-            &m_message_request);
-}
+    int epoch = std::stoi(message.substr(0, newline));
+    message.erase(0, newline + 1);
 
-// Send signal to Master
-void Manager::sendSignalToMaster(int signal)
-{
-    // Ensure previous signal has finished sending
-    MPI_Wait(&m_signal_request, MPI_STATUS_IGNORE);
+    // A batch of a later epoch means that the Master has been flushed
+    advanceEpoch(epoch);
+
+    int batch_size = 0;
+    std::string input_string;
+    while (parse_persistent_simulator_input(message, input_string))
+    {
+        m_batch_inputs.push_back(input_string);
+        batch_size++;
+    }
+
+    // Sanity check: batch should be nonempty and completely parsed
+    if (batch_size == 0 || !message.empty())
+    {
+        std::runtime_error e("cannot parse batch of tasks from Master");
+        throw e;
+    }
+
+    Batch batch;
+    batch.epoch = epoch;
+    batch.size = batch_size;
+    batch.num_local = batch_size;
+    batch.num_finished = 0;
+    batch.outputs.resize(batch_size);
+    m_batches.push_back(std::move(batch));
 
-    // Store signal in buffer
-    m_signal_buffer = signal;
+    // Other Managers may have work to steal again
+    m_failed_steals = 0;
 
-    // Note: Isend is used here to avoid deadlock since the Master and the root
-    // Manager are executed by the same process
-    MPI_Isend(&m_signal_buffer, 1, MPI_INT, MASTER_RANK,
-            MANAGER_SIGNAL_TAG, MPI_COMM_WORLD,
-            &m_signal_request);
+    // A batch sent before the last FLUSH_WORKER_SIGNAL may arrive after it,
+    // in which case it is stale already
+    discardStaleBatches();
 }
 
-// Send error code to Master
-void Manager::sendErrorCodeToMaster(int error_code)
+// Discard remaining tasks and results of all received batches
+void Manager::discardBatch()
 {
-    // Ensure previous error code has finished sending
-    MPI_Wait(&m_error_code_request, MPI_STATUS_IGNORE);
+    m_batch_inputs.clear();
+    m_front_batch += m_batches.size();
+    m_next_batch = m_front_batch;
+    m_next_task = 0;
+    m_batches.clear();
+    m_batch_outputs.clear();
+    m_stolen_tasks.clear();
+}
 
-    // Store error_code in buffer
-    m_error_code_buffer = error_code;
+// Receive signal
+int Manager::receiveSignal() const
+{
+    // Sanity check: probeSignal must return true
+    assert(probeSignal());
 
-    // Note: Isend is used here to avoid deadlock since the Master and the root
-    // Manager are executed by the same process
-    MPI_Isend(&m_error_code_buffer, 1, MPI_INT, MASTER_RANK,
-            MANAGER_ERROR_CODE_TAG, MPI_COMM_WORLD,
-            &m_error_code_request);
+    return receive_integer(m_comm, MASTER_RANK, MASTER_SIGNAL_TAG);
 }
@@ -3,14 +3,22 @@
 
 #include <string>
 #include <memory>
+#include <chrono>
+#include <deque>
+#include <vector>
+#include <set>
 
 #include <assert.h>
 
 #include <mpi.h>
 
 #include "core/Command.h"
+#include "system/ChildSupervisor.h"
+#include "mpi/SendQueue.h"
 
 class AbstractWorkerHandler;
+class PersistentWorker;
+class ProposalGenerator;
 
 /** A helper class for performing simulation tasks in parallel using MPI.
  *
@@ -24,6 +32,62 @@ class AbstractWorkerHandler;
  * MPI Worker is necessary when the simulator uses MPI.  See MPIMaster for more
  * details.
  *
+ * Alternatively, the Worker can be a persistent Worker, which is represented
+ * by the PersistentWorkerHandler class.  In this case, the Manager owns a
+ * PersistentWorker that is reused across simulation tasks and is only
+ * restarted on error or when a simulation is flushed.
+ *
+ * A Manager can run several forked or persistent Workers concurrently, one in
+ * each of a fixed number of Worker slots, so that a single MPI process can
+ * keep all cores of a node busy.  The pipes of the busy Workers are then
+ * watched by a ChildSupervisor, so that only Workers that are ready are
+ * checked.  Tasks are started in the order in which they were received, but
+ * may finish in any order.  The results of every batch are collected in task
+ * order and a batch is only replied to once all earlier batches have been
+ * replied to, so the MPIMaster still receives replies in the order in which it
+ * sent the batches.
+ *
+ * Tasks are received from the MPIMaster in batches.  The Manager performs the
+ * tasks of a batch one after the other and sends all results back to the
+ * MPIMaster in a single message.  The MPIMaster may send further batches
+ * while the Manager is busy (see MPIMaster for details on prefetching).  These
+ * are queued and started as soon as the previous task finishes, so that the
+ * Worker does not stay idle while the results travel to the MPIMaster and the
+ * next batch travels back.  MPI Workers may additionally be sent the input
+ * strings of queued tasks ahead of time (see MPIWorkerHandler::prefetch()),
+ * so that they do not stay idle while the Manager receives their results.
+ *
+ * Every batch is tagged with the epoch of the MPIMaster in which it was sent.
+ * The MPIMaster starts a new epoch whenever it is flushed, and signals this
+ * to all Managers with FLUSH_WORKER_SIGNAL.  A Manager enters a new epoch
+ * either when it receives that signal or when it receives a batch of a later
+ * epoch, whichever comes first.  It then terminates its Workers and replies to
+ * every batch of an earlier epoch with an empty message, so that the MPIMaster
+ * receives exactly one reply for every batch, in order, and does not have to
+ * wait for the Managers before sending tasks of the new epoch.
+ *
+ * If the Manager is given a ProposalGenerator, the input strings it receives
+ * are proposal requests rather than simulator input.  The Manager then
+ * generates the parameter of every task itself and simulates it using a
+ * ProposalWorkerHandler, so that the cost of generating parameters is spread
+ * over all Managers.
+ *
+ * With work stealing, the MPIMaster partitions the tasks over the Managers
+ * up front, and Managers that run out of tasks steal tasks from other
+ * Managers instead of waiting for the MPIMaster.  A Manager that has started
+ * all of its tasks sends a steal request to another Manager, which gives
+ * away half of the tasks of its last batch that have not yet been started.
+ * If it has none, the thief asks the next Manager, until every other Manager
+ * has been asked in vain.  The thief performs the stolen tasks in its free
+ * slots and sends every result back to the Manager it stole the task from,
+ * which replies to the MPIMaster as usual once all tasks of the batch have
+ * finished.  This way, the MPIMaster is only involved at the start and at
+ * the end of a parameter sweep.
+ *
+ * The Manager exchanges messages with its MPIMaster on a given communicator.
+ * This is MPI_COMM_WORLD by default, or the communicator of the node if the
+ * MPIMaster is run with sub-masters (see SubMaster).
+ *
  * As with the MPIMaster, Managers are meant to be run in an event loop.
  * Therefore, the event loop in MPIMaster::run() will call Manager::iterate().
  */
@@ -36,7 +100,8 @@ class Manager
         enum worker_t
         {
             forked_worker,
-            mpi_worker
+            mpi_worker,
+            persistent_worker
         };
 
         /** Constructor.
@@ -45,19 +110,47 @@ class Manager
          * @param worker_type  type of Worker
          * @param p_program_terminated  pointer to boolean flag that is set
          * when the execution of Pakman is terminated by the user.
+         * @param p_proposal_generator  pointer to ProposalGenerator if the
+         * Manager receives proposal requests, null pointer otherwise.
+         * @param num_workers  number of Workers that run concurrently.  MPI
+         * Workers only support one.
+         * @param comm  communicator on which the Manager exchanges messages
+         * with its master, which has rank MASTER_RANK in it.
+         * @param work_stealing  whether the Manager steals tasks from the
+         * other Managers of the communicator when it runs out of tasks.
          */
         Manager(const Command &simulator, worker_t worker_type,
-                bool *p_program_terminated);
+                bool *p_program_terminated,
+                std::shared_ptr<ProposalGenerator> p_proposal_generator =
+                nullptr, int num_workers = 1,
+                MPI_Comm comm = MPI_COMM_WORLD, bool work_stealing = false);
 
-        /** Default destructor destroys MPI_Request objects. */
+        /** Default destructor. */
         ~Manager();
 
         /** @return whether the Manager is active. */
         bool isActive() const;
 
+        /** @return whether the Manager is waiting for a message, that is,
+         * whether it is idle or awaits the reply to a steal request.
+         */
+        bool awaitsMessages() const;
+
         /** Iterates the Manager in an event loop. */
         void iterate();
 
+        /** Wait until any Worker may have made progress or the timeout has
+         * elapsed, whichever comes first.
+         *
+         * If the Manager is not busy, this function simply sleeps for the
+         * given timeout.
+         *
+         * @param timeout  maximum time to wait.
+         *
+         * @return whether the Worker may have made progress.
+         */
+        bool waitForWorker(std::chrono::microseconds timeout);
+
     private:
 
         /** Enumerate type for Manager states.
@@ -76,14 +169,28 @@ class Manager
         // Do busy stuff
         void doBusyStuff();
 
-        // Create Worker
-        void createWorker(const std::string& input_string);
+        // Create Worker in slot
+        void createWorker(int slot, const std::string& input_string);
+
+        // Make Worker handler of configured Worker type for slot
+        std::unique_ptr<AbstractWorkerHandler> makeWorkerHandler(int slot,
+                const std::string& input_string);
+
+        // Terminate all Workers
+        void terminateWorkers();
 
-        // Terminate Worker
-        void terminateWorker();
+        // Flush Worker in slot
+        void flushWorker(int slot);
 
-        // Flush Worker
-        void flushWorker();
+        // Collect busy slots whose Workers may have finished
+        void collectReadySlots();
+
+        // Record result of finished Worker in slot and flush it
+        void recordResult(int slot);
+
+        // Send results of completed batches at the front of the queue to
+        // Master
+        void sendCompletedBatches();
 
         // Probe for message
         bool probeMessage() const;
@@ -91,20 +198,50 @@ class Manager
         // Probe for signal
         bool probeSignal() const;
 
-        // Receive message
-        std::string receiveMessage() const;
+        // Receive message into receive buffer
+        std::string& receiveMessage();
+
+        // Receive batch of input strings and append to queue of input strings
+        void receiveBatch();
+
+        // Discard remaining tasks and results of all received batches
+        void discardBatch();
+
+        // Enter epoch, discarding batches of earlier epochs
+        void advanceEpoch(int epoch);
+
+        // Reply to batches of earlier epochs with empty messages and discard
+        // them
+        void discardStaleBatches();
+
+        // Create Workers for queued tasks in idle slots, or switch to idle
+        // state if no Worker is busy
+        void startNextTasks();
+
+        // Send input strings of queued tasks to MPI Worker ahead of time
+        void prefetchInputs();
+
+        // Serve steal requests, receive stolen tasks and their results, and
+        // send a steal request if there are no tasks left to start
+        void stealTasks();
+
+        // Give away tasks to Manager that sent steal request
+        void serveStealRequest(int thief_rank);
+
+        // Receive reply to steal request
+        void receiveStealReply();
+
+        // Receive result of task that was stolen from this Manager
+        void receiveStolenResult(int thief_rank);
+
+        // Discard stolen tasks, which belong to batches of earlier epochs
+        void discardStolenTasks();
 
         // Receive signal
         int receiveSignal() const;
 
-        // Send message to Master
-        void sendMessageToMaster(const std::string& message_string);
 
-        // Send signal to Master
-        void sendSignalToMaster(int signal);
 
-        // Send error code to Master
-        void sendErrorCodeToMaster(int error_code);
 
         ///// Member variables /////
         // Initial state is idle
@@ -113,32 +250,140 @@ class Manager
         // Command for Worker
         const Command m_simulator;
 
-        // Worker type (forked Worker vs MPI Worker)
+        // Whether simulator is a plugin
+        const bool m_plugin_simulator;
+
+        // Worker type (forked Worker, MPI Worker or persistent Worker)
         const worker_t m_worker_type;
 
         // Pointer to program terminated flag
         bool *m_p_program_terminated;
 
-        // Pointer to Worker handler
-        std::unique_ptr<AbstractWorkerHandler> m_p_worker_handler;
+        // Pointer to ProposalGenerator (only used if proposals are
+        // distributed)
+        std::shared_ptr<ProposalGenerator> m_p_proposal_generator;
+
+        // Batch of tasks received from the Master
+        struct Batch
+        {
+            // Epoch in which the batch was sent
+            int epoch;
+
+            // Number of tasks
+            int size;
+
+            // Number of tasks that are performed by this Manager, which are
+            // all tasks except those at the end that have been stolen
+            int num_local;
+
+            // Number of finished tasks
+            int num_finished;
+
+            // Formatted output strings and error codes of finished tasks, in
+            // task order
+            std::vector<std::string> outputs;
+        };
+
+        // Number of Worker slots
+        const int m_num_workers;
+
+        // Communicator shared with master
+        const MPI_Comm m_comm;
+
+        // Persistent Worker of every slot (only used for persistent Workers)
+        std::vector<std::unique_ptr<PersistentWorker>> m_persistent_workers;
+
+        // Supervisor watching the pipes of busy Workers, keyed by slot (only
+        // used with more than one slot).  It must outlive the Worker handlers
+        ChildSupervisor m_supervisor;
+
+        // Worker handler of every slot (null pointer if slot is idle)
+        std::vector<std::unique_ptr<AbstractWorkerHandler>> m_worker_handlers;
+
+        // Number of busy slots
+        int m_num_busy = 0;
+
+        // Batch number and index within batch of the task of every busy slot
+        std::vector<long> m_slot_batches;
+        std::vector<int> m_slot_tasks;
+
+        // Busy slots whose Workers have no read pipe, such as plugin
+        // simulators, and are therefore checked directly
+        std::set<int> m_unwatched_slots;
+
+        // Busy slots whose Workers may have finished
+        std::vector<int> m_ready_slots;
+
+        // Messages to Master that are being sent
+        SendQueue m_master_messages;
+
+        // Buffer for messages from Master
+        std::string m_receive_buffer;
+
+        // Input strings of all received batches that have not been started.
+        // With MPI Workers, the first MPIWorkerHandler::numPrefetched() of
+        // them have already been sent to the Worker
+        std::deque<std::string> m_batch_inputs;
+
+        // Batches that have been received but not yet replied to, in order of
+        // reception.  Batches are numbered consecutively in order of
+        // reception
+        std::deque<Batch> m_batches;
+
+        // Number of front batch
+        long m_front_batch = 0;
+
+        // Batch number and index within batch of the front input string
+        long m_next_batch = 0;
+        int m_next_task = 0;
+
+        // Current epoch
+        int m_epoch = 0;
+
+        // Number of FLUSH_WORKER_SIGNALs received, which is the epoch of the
+        // MPIMaster at the time of the last signal
+        int m_flush_signal_count = 0;
+
+        // Output strings and error codes of batch that is sent to Master
+        std::string m_batch_outputs;
+
+        // Task stolen from another Manager
+        struct StolenTask
+        {
+            // Rank of Manager the task was stolen from
+            int owner_rank;
+
+            // Batch number at owner and index within batch
+            long batch;
+            int task;
+
+            // Input string
+            std::string input;
+        };
+
+        // Whether work stealing is enabled
+        const bool m_work_stealing;
 
-        // Message buffer
-        std::string m_message_buffer;
+        // Stolen tasks that have not been started
+        std::deque<StolenTask> m_stolen_tasks;
 
-        // Message request
-        MPI_Request m_message_request = MPI_REQUEST_NULL;
+        // Stolen task of every busy slot whose batch number is negative
+        std::vector<StolenTask> m_slot_stolen_tasks;
 
-        // Signal buffer
-        int m_signal_buffer;
+        // Rank of Manager to which the last steal request was sent
+        int m_steal_victim;
 
-        // Signal request
-        MPI_Request m_signal_request = MPI_REQUEST_NULL;
+        // Whether a steal request awaits its reply
+        bool m_steal_pending = false;
 
-        // Error code buffer
-        int m_error_code_buffer;
+        // Number of consecutive steal requests that were replied to without
+        // tasks.  Stealing stops when every other Manager has been asked in
+        // vain and resumes when a batch arrives from the Master, so it is
+        // also off until the first batch arrives
+        int m_failed_steals;
 
-        // Error code request
-        MPI_Request m_error_code_request = MPI_REQUEST_NULL;
+        // Messages to other Managers that are being sent
+        SendQueue m_manager_messages;
 };
 
 #endif // MANAGER_H
@@ -0,0 +1,154 @@
+#include <string>
+#include <stdexcept>
+#include <signal.h>
+#include <sys/wait.h>
+#include <sys/types.h>
+
+#include "core/common.h"
+#include "system/system_call.h"
+#include "system/pipe_io.h"
+#include "system/reaper.h"
+#include "interface/protocols.h"
+
+#include "PersistentWorker.h"
+
+PersistentWorker::PersistentWorker(const Command& simulator) :
+    m_simulator(simulator)
+{
+    // Start process
+    std::tie(m_child_pid, m_pipe_write_fd, m_pipe_read_fd) =
+        system_call_non_blocking_read_write(m_simulator);
+
+    // Make read pipe non-blocking so that receiveOutput() never stalls on a
+    // simulator that has written only part of its output, and write pipe
+    // non-blocking so that sendInput() never stalls on a simulator that has
+    // not read all of its input
+    set_non_blocking(m_pipe_read_fd);
+    set_non_blocking(m_pipe_write_fd);
+}
+
+PersistentWorker::~PersistentWorker()
+{
+    // Close write pipe, this signals end of input to the simulator
+    close_check(m_pipe_write_fd);
+
+    // Wait on child process if it has not yet been waited for
+    if (m_child_pid) terminate();
+
+    // Close read pipe if not already closed
+    if (!m_read_done) close_check(m_pipe_read_fd);
+}
+
+bool PersistentWorker::isAlive()
+{
+    // If already waited for, process is not running
+    if (!m_child_pid) return false;
+
+    // If process has exited, mark by setting m_child_pid to zero
+    if ( waitpid_success(m_child_pid, WNOHANG, m_simulator, ignore_error) )
+    {
+        m_child_pid = 0;
+        return false;
+    }
+
+    return !m_read_done;
+}
+
+void PersistentWorker::sendInput(const std::string& input_string)
+{
+    m_write_buffer = format_persistent_simulator_input(input_string);
+    m_write_offset = 0;
+    m_task_pending = true;
+
+    writeInput();
+}
+
+void PersistentWorker::writeInput()
+{
+    if (poll_write_to_pipe(m_pipe_write_fd, m_write_buffer, m_write_offset))
+    {
+        m_write_buffer.clear();
+        m_write_offset = 0;
+    }
+}
+
+bool PersistentWorker::receiveOutput(std::string& output_string,
+        int& error_code)
+{
+    // Continue writing input frame if it did not fit into the pipe
+    if (!m_write_buffer.empty() && !m_read_done)
+        writeInput();
+
+    // Poll pipe if m_read_done flag is false. If pipe is finished reading,
+    // close pipe and set m_read_done flag to true
+    if (    !m_read_done &&
+            poll_read_from_pipe(m_pipe_read_fd, m_read_buffer) )
+    {
+        close_check(m_pipe_read_fd);
+        m_read_done = true;
+    }
+
+    // Return output if a complete frame has been received
+    if (parse_persistent_simulator_output(m_read_buffer, output_string,
+                error_code))
+    {
+        m_task_pending = false;
+        return true;
+    }
+
+    // If simulator is still running, the simulation is not finished
+    if (!m_read_done)
+        return false;
+
+    // Else simulator has exited in the middle of the simulation, so return
+    // partial output and exit status
+    output_string = m_read_buffer;
+    m_read_buffer.clear();
+    m_write_buffer.clear();
+    m_write_offset = 0;
+
+    waitpid_success(m_child_pid, error_code, 0, m_simulator);
+    m_child_pid = 0;
+
+    if (error_code == 0)
+        error_code = 1;
+
+    m_task_pending = false;
+    return true;
+}
+
+int PersistentWorker::getReadFileDescriptor() const
+{
+    return m_pipe_read_fd;
+}
+
+int PersistentWorker::getWriteFileDescriptor() const
+{
+    return m_write_buffer.empty() ? -1 : m_pipe_write_fd;
+}
+
+void PersistentWorker::terminate()
+{
+    // If already terminated, return immediately
+    if (!m_child_pid) return;
+
+    // If simulator has exited, mark by setting m_child_pid to zero
+    if ( waitpid_success(m_child_pid, WNOHANG, m_simulator, ignore_error) )
+    {
+        m_child_pid = 0;
+        return;
+    }
+
+    // An idle simulator should exit by itself now that its standard input
+    // has been closed, but a busy simulator needs to be interrupted.  The
+    // escalation to SIGKILL and reaping are left to the event loop
+    if (m_task_pending && kill(m_child_pid, SIGTERM))
+    {
+        std::runtime_error e("an error occurred while trying to terminate "
+                             "child process");
+        throw e;
+    }
+
+    terminate_child_async(m_child_pid, m_simulator, m_task_pending);
+    m_child_pid = 0;
+}
@@ -0,0 +1,126 @@
+#ifndef PERSISTENTWORKER_H
+#define PERSISTENTWORKER_H
+
+#include <string>
+#include <cstddef>
+
+#include <unistd.h>
+
+#include "core/Command.h"
+
+/** A class for representing persistent simulator processes.
+ *
+ * A persistent simulator is started once as a child process using
+ * `posix_spawn()` and then performs any number of simulation tasks.  Input
+ * and output are exchanged in frames through the standard input and output of
+ * the simulator, as implemented by format_persistent_simulator_input() and
+ * parse_persistent_simulator_output().  This avoids the cost of starting a
+ * new process for every simulation, which can dominate the runtime of short
+ * simulations written in interpreted languages.
+ *
+ * A PersistentWorker is owned by the Manager or Master that uses it and
+ * outlives the PersistentWorkerHandler objects that represent individual
+ * simulation tasks.
+ */
+
+class PersistentWorker
+{
+
+    public:
+
+        /** Construct from simulator string.
+         *
+         * The constructor will fork a process whose standard input and output
+         * is redirected to a write and a read pipe, respectively.
+         *
+         * @param simulator  command to run persistent simulator.
+         */
+        PersistentWorker(const Command& simulator);
+
+        /** Destructor terminates the simulator process.
+         *
+         * The write pipe is closed first, so that an idle simulator can exit
+         * of its own accord when it reaches the end of its standard input.
+         * If the simulator does not exit within the kill timeout, or if it is
+         * in the middle of a simulation, it is sent `SIGTERM` followed by
+         * `SIGKILL`.  The destructor does not wait for this to happen; the
+         * simulator process is handed over to terminate_child_async()
+         * instead.
+         */
+        ~PersistentWorker();
+
+        /** @return whether the simulator process is still running. */
+        bool isAlive();
+
+        /** Send input string to simulator.
+         *
+         * The write pipe is non-blocking.  If the input frame does not fit
+         * into the pipe, the remainder is written by receiveOutput().
+         *
+         * @param input_string  input string to simulator.
+         */
+        void sendInput(const std::string& input_string);
+
+        /** Receive output of simulator if it is available.
+         *
+         * If the simulator exits before it has written a complete output
+         * frame, the output received so far and the exit status of the
+         * simulator are returned.  If the exit status is zero in that case,
+         * the error code is set to one, since the task was not completed.
+         *
+         * @param output_string  output string of simulator, set if this
+         * function returns true.
+         * @param error_code  error code of simulator, set if this function
+         * returns true.
+         *
+         * @return whether the simulation has finished.
+         */
+        bool receiveOutput(std::string& output_string, int& error_code);
+
+        /** @return file descriptor of read pipe.
+         *
+         * The read pipe is non-blocking, so it can be multiplexed with other
+         * file descriptors using `poll()`.
+         */
+        int getReadFileDescriptor() const;
+
+        /** @return file descriptor of write pipe while an input frame is
+         * being written, else -1.
+         */
+        int getWriteFileDescriptor() const;
+
+    private:
+
+        // Write as much of the pending input frame as the write pipe accepts
+        void writeInput();
+
+        // Terminate simulator process, using system signals if it does not
+        // exit by itself
+        void terminate();
+
+        // Command to run persistent simulator
+        const Command m_simulator;
+
+        // Process id of simulator
+        pid_t m_child_pid;
+
+        // File descriptors for pipes
+        int m_pipe_write_fd;
+        int m_pipe_read_fd;
+
+        // Whether a task has been sent whose output has not been received
+        bool m_task_pending = false;
+
+        // Read pipe status flag
+        bool m_read_done = false;
+
+        // Buffer for output that has not yet been parsed
+        std::string m_read_buffer;
+
+        // Input frame that is being written, and number of bytes of it
+        // written so far
+        std::string m_write_buffer;
+        std::size_t m_write_offset = 0;
+};
+
+#endif // PERSISTENTWORKER_H
@@ -0,0 +1,67 @@
+#include <string>
+#include <memory>
+
+#include "PersistentWorker.h"
+
+#include "PersistentWorkerHandler.h"
+
+PersistentWorkerHandler::PersistentWorkerHandler(
+        const Command& simulator,
+        const std::string& input_string,
+        std::unique_ptr<PersistentWorker>& p_worker) :
+    AbstractWorkerHandler(simulator, input_string),
+    m_p_worker(p_worker)
+{
+    // Start persistent Worker if necessary
+    if (!m_p_worker || !m_p_worker->isAlive())
+        m_p_worker.reset(new PersistentWorker(m_simulator));
+
+    // Send input string to persistent Worker
+    m_p_worker->sendInput(input_string);
+}
+
+PersistentWorkerHandler::~PersistentWorkerHandler()
+{
+    unwatch();
+
+    // Terminate persistent Worker if simulation was interrupted
+    if (!m_result_received)
+        m_p_worker.reset();
+}
+
+bool PersistentWorkerHandler::isDone()
+{
+    // If result has already been received, return true
+    if (m_result_received)
+        return true;
+
+    // Check for output frame
+    if (!m_p_worker->receiveOutput(m_output_buffer, m_error_code))
+    {
+        // Pending input may have been written
+        updateWatch();
+        return false;
+    }
+
+    // The pipes of the persistent Worker are kept for the next task.  If the
+    // simulator has exited, the read pipe has just been closed, so it is
+    // unwatched right away
+    unwatch();
+    m_result_received = true;
+
+    // Restart persistent Worker on next task if an error occurred
+    if (m_error_code != 0)
+        m_p_worker.reset();
+
+    return true;
+}
+
+int PersistentWorkerHandler::getReadFileDescriptor() const
+{
+    return m_p_worker->getReadFileDescriptor();
+}
+
+int PersistentWorkerHandler::getWriteFileDescriptor() const
+{
+    return m_p_worker->getWriteFileDescriptor();
+}
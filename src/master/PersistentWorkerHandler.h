@@ -0,0 +1,75 @@
+#ifndef PERSISTENTWORKERHANDLER_H
+#define PERSISTENTWORKERHANDLER_H
+
+#include <string>
+#include <memory>
+
+#include "AbstractWorkerHandler.h"
+
+class PersistentWorker;
+
+/** A class for representing simulation tasks on persistent Workers.
+ *
+ * As opposed to the ForkedWorkerHandler, the simulator process is not started
+ * for every simulation task.  Rather, the simulator process is represented by
+ * a PersistentWorker object that is owned by the Manager or Master and stays
+ * alive to accept more simulation tasks.  Each simulation task is represented
+ * by a new instance of PersistentWorkerHandler.
+ *
+ * The PersistentWorker is restarted if the simulator exits, if a simulation
+ * finishes with an error, or if a simulation is interrupted because the
+ * PersistentWorkerHandler is destroyed before the simulation has finished.
+ */
+
+class PersistentWorkerHandler : public AbstractWorkerHandler
+{
+
+    public:
+
+        /** Construct from simulator string, input string and persistent
+         * Worker.
+         *
+         * If the persistent Worker is the null pointer or its simulator
+         * process has exited, a new PersistentWorker is started.  The input
+         * string is then sent to the persistent Worker.
+         *
+         * @param simulator  command to run persistent simulator.
+         * @param input_string  input string to simulator.
+         * @param p_worker  reference to pointer to persistent Worker, which
+         * must outlive this object.
+         */
+        PersistentWorkerHandler(const Command& simulator,
+                const std::string& input_string,
+                std::unique_ptr<PersistentWorker>& p_worker);
+
+        /** Destructor.
+         *
+         * If the simulation has not finished, the persistent Worker is
+         * terminated, since its output would otherwise be mistaken for the
+         * output of the next simulation task.
+         */
+        virtual ~PersistentWorkerHandler() override;
+
+        /** @return whether Worker has finished.
+         *
+         * Poll read pipe for any outstanding output and check whether a
+         * complete output frame has been received.
+         */
+        virtual bool isDone() override;
+
+        /** @return file descriptor of read pipe. */
+        virtual int getReadFileDescriptor() const override;
+
+        /** @return file descriptor of write pipe of Worker. */
+        virtual int getWriteFileDescriptor() const override;
+
+    private:
+
+        // Reference to pointer to persistent Worker
+        std::unique_ptr<PersistentWorker>& m_p_worker;
+
+        // Flag for receiving result
+        bool m_result_received = false;
+};
+
+#endif // PERSISTENTWORKERHANDLER_H
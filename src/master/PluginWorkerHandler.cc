@@ -0,0 +1,44 @@
+#include <string>
+#include <tuple>
+#include <utility>
+#include <future>
+#include <chrono>
+
+#include "system/plugin.h"
+
+#include "PluginWorkerHandler.h"
+
+PluginWorkerHandler::PluginWorkerHandler(
+        const Command& simulator,
+        const std::string& input_string) :
+    AbstractWorkerHandler(simulator, input_string),
+    m_result(plugin_call_async(m_simulator, m_input_string))
+{
+}
+
+PluginWorkerHandler::~PluginWorkerHandler()
+{
+    abandon_plugin_call(std::move(m_result));
+}
+
+bool PluginWorkerHandler::isDone()
+{
+    // Result has already been received
+    if (!m_result.valid())
+        return true;
+
+    if (m_result.wait_for(std::chrono::seconds(0))
+            != std::future_status::ready)
+        return false;
+
+    std::tie(m_output_buffer, m_error_code) = m_result.get();
+    return true;
+}
+
+bool PluginWorkerHandler::waitForOutput(std::chrono::microseconds timeout)
+{
+    if (m_result.valid())
+        m_result.wait_for(timeout);
+
+    return isDone();
+}
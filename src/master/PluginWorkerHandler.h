@@ -0,0 +1,65 @@
+#ifndef PLUGINWORKERHANDLER_H
+#define PLUGINWORKERHANDLER_H
+
+#include <string>
+#include <utility>
+#include <future>
+#include <chrono>
+
+#include "AbstractWorkerHandler.h"
+
+/** A class for representing simulation tasks on plugin simulators.
+ *
+ * A plugin simulator is a shared library that is called directly from the
+ * process of the Manager or Master (see pakman_plugin.h), so no process is
+ * started for the simulation.  Instead, the constructor calls the plugin on
+ * a separate thread, and isDone() returns true once the call has returned.
+ *
+ * Hence, the event loop goes on while a plugin simulation runs, and a
+ * LocalMaster with several jobs or a Manager with several Worker slots runs
+ * plugin simulations concurrently.
+ */
+
+class PluginWorkerHandler : public AbstractWorkerHandler
+{
+
+    public:
+
+        /** Construct from simulator string and input string.
+         *
+         * The constructor starts the plugin simulator on a separate thread.
+         *
+         * @param simulator  command to run plugin simulator.
+         * @param input_string  input string to simulator.
+         */
+        PluginWorkerHandler(const Command& simulator,
+                const std::string& input_string);
+
+        /** Destructor leaves an unfinished plugin call to finish in the
+         * background, since it cannot be interrupted.
+         */
+        virtual ~PluginWorkerHandler() override;
+
+        /** Check whether plugin call has returned.  If so, store its output
+         * and error code.
+         *
+         * @return true if plugin call has returned, false otherwise.
+         */
+        virtual bool isDone() override;
+
+        /** Wait for plugin call to return.
+         *
+         * @param timeout  maximum time to wait.
+         *
+         * @return true if plugin call has returned, false otherwise.
+         */
+        virtual bool waitForOutput(std::chrono::microseconds timeout)
+            override;
+
+    private:
+
+        // Result of plugin call, invalid once it has been received
+        std::future<std::pair<std::string, int>> m_result;
+};
+
+#endif // PLUGINWORKERHANDLER_H
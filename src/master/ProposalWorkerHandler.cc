@@ -0,0 +1,79 @@
+#include <string>
+#include <memory>
+#include <chrono>
+
+#include "interface/protocols.h"
+
+#include "ProposalWorkerHandler.h"
+
+ProposalWorkerHandler::ProposalWorkerHandler(
+        const Command& simulator,
+        const std::string& proposal_request,
+        const Parameter& parameter, double prior_pdf,
+        std::unique_ptr<AbstractWorkerHandler> p_worker_handler) :
+    AbstractWorkerHandler(simulator, proposal_request),
+    m_parameter(parameter),
+    m_prior_pdf(prior_pdf),
+    m_p_worker_handler(std::move(p_worker_handler))
+{
+}
+
+bool ProposalWorkerHandler::isDone()
+{
+    // If result has already been received, return true
+    if (m_result_received)
+        return true;
+
+    // If parameter is not simulated, there is no simulator output
+    if (!m_p_worker_handler)
+    {
+        m_output_buffer = format_proposal_output(m_parameter, m_prior_pdf,
+                "");
+        m_error_code = 0;
+        m_result_received = true;
+        return true;
+    }
+
+    // Check wrapped Worker handler
+    if (!m_p_worker_handler->isDone())
+        return false;
+
+    m_output_buffer = format_proposal_output(m_parameter, m_prior_pdf,
+            m_p_worker_handler->getOutput());
+    m_error_code = m_p_worker_handler->getErrorCode();
+    m_result_received = true;
+
+    return true;
+}
+
+bool ProposalWorkerHandler::waitForOutput(std::chrono::microseconds timeout)
+{
+    if (isDone())
+        return true;
+
+    return m_p_worker_handler->waitForOutput(timeout);
+}
+
+bool ProposalWorkerHandler::watch(ChildSupervisor& supervisor, int key)
+{
+    if (!m_p_worker_handler)
+        return false;
+
+    return m_p_worker_handler->watch(supervisor, key);
+}
+
+int ProposalWorkerHandler::getReadFileDescriptor() const
+{
+    if (!m_p_worker_handler)
+        return -1;
+
+    return m_p_worker_handler->getReadFileDescriptor();
+}
+
+int ProposalWorkerHandler::getWriteFileDescriptor() const
+{
+    if (!m_p_worker_handler)
+        return -1;
+
+    return m_p_worker_handler->getWriteFileDescriptor();
+}
@@ -0,0 +1,90 @@
+#ifndef PROPOSALWORKERHANDLER_H
+#define PROPOSALWORKERHANDLER_H
+
+#include <string>
+#include <memory>
+#include <chrono>
+
+#include "interface/types.h"
+
+#include "AbstractWorkerHandler.h"
+
+/** A class for representing proposal tasks on Workers.
+ *
+ * When proposals are distributed, the Manager generates the parameter of a
+ * task itself using a ProposalGenerator and then starts a Worker to simulate
+ * it.  The ProposalWorkerHandler wraps the AbstractWorkerHandler of that
+ * Worker and prepends the generated parameter and its prior pdf to the output
+ * of the simulator, as implemented by format_proposal_output().
+ *
+ * If the generated parameter lies outside the support of the prior, no Worker
+ * is started and the task finishes immediately with empty simulator output.
+ */
+
+class ProposalWorkerHandler : public AbstractWorkerHandler
+{
+
+    public:
+
+        /** Construct from simulator string, proposal request, generated
+         * parameter and Worker handler.
+         *
+         * @param simulator  command to run simulation.
+         * @param proposal_request  proposal request string.
+         * @param parameter  generated parameter.
+         * @param prior_pdf  prior probability density of generated parameter.
+         * @param p_worker_handler  Worker handler that simulates the
+         * generated parameter, or the null pointer if the parameter is not
+         * simulated.
+         */
+        ProposalWorkerHandler(const Command& simulator,
+                const std::string& proposal_request,
+                const Parameter& parameter, double prior_pdf,
+                std::unique_ptr<AbstractWorkerHandler> p_worker_handler);
+
+        /** Default destructor destroys wrapped Worker handler. */
+        virtual ~ProposalWorkerHandler() override = default;
+
+        /** @return whether Worker has finished. */
+        virtual bool isDone() override;
+
+        /** Wait on wrapped Worker handler.
+         *
+         * @param timeout  maximum time to wait.
+         *
+         * @return whether the Worker may have made progress.
+         */
+        virtual bool waitForOutput(std::chrono::microseconds timeout)
+            override;
+
+        /** Watch pipes of wrapped Worker handler.
+         *
+         * @param supervisor  supervisor to register the pipes with.
+         * @param key  key of the Worker in the supervisor.
+         *
+         * @return whether the pipes are watched.
+         */
+        virtual bool watch(ChildSupervisor& supervisor, int key) override;
+
+        /** @return file descriptor of wrapped Worker handler. */
+        virtual int getReadFileDescriptor() const override;
+
+        /** @return write file descriptor of wrapped Worker handler. */
+        virtual int getWriteFileDescriptor() const override;
+
+    private:
+
+        // Generated parameter
+        const Parameter m_parameter;
+
+        // Prior pdf of generated parameter
+        const double m_prior_pdf;
+
+        // Wrapped Worker handler
+        std::unique_ptr<AbstractWorkerHandler> m_p_worker_handler;
+
+        // Flag for receiving result
+        bool m_result_received = false;
+};
+
+#endif // PROPOSALWORKERHANDLER_H
@@ -4,18 +4,29 @@
 
 #include <assert.h>
 
+#include "core/common.h"
 #include "system/system_call.h"
+#include "system/plugin.h"
 #include "controller/AbstractController.h"
 
+#include "PersistentWorker.h"
+#include "PersistentWorkerHandler.h"
+
 #include "SerialMaster.h"
 
-// Construct from pointer to program terminated flag
+// Construct from simulator, simulator persistence and pointer to program
+// terminated flag
 SerialMaster::SerialMaster(const Command& simulator,
-        bool *p_program_terminated) : AbstractMaster(p_program_terminated),
-    m_simulator(simulator)
+        bool persistent_simulator, bool *p_program_terminated) :
+    AbstractMaster(p_program_terminated),
+    m_simulator(simulator),
+    m_persistent_simulator(persistent_simulator)
 {
 }
 
+// Terminate persistent Worker
+SerialMaster::~SerialMaster() = default;
+
 // Probe whether Master is active
 bool SerialMaster::isActive() const
 {
@@ -58,9 +69,10 @@ bool SerialMaster::needMorePendingTasks() const
 }
 
 // Push pending task
-void SerialMaster::pushPendingTask(const std::string& input_string)
+void SerialMaster::pushPendingTask(const std::string& input_string,
+        double metadata)
 {
-    m_pending_tasks.push(input_string);
+    m_pending_tasks.emplace(input_string, metadata);
 }
 
 // Returns whether finished tasks queue is empty
@@ -109,8 +121,24 @@ void SerialMaster::processTask()
     // Process current task and get output string and error code
     std::string output_string;
     int error_code;
-    std::tie(output_string, error_code) =
-        system_call_error_code(m_simulator, current_task.getInputString());
+    // Plugin simulators are called directly by system_call_error_code(),
+    // so they are never started as persistent Workers
+    if (m_persistent_simulator && !is_plugin(m_simulator))
+    {
+        PersistentWorkerHandler worker_handler(m_simulator,
+                current_task.getInputString(), m_p_persistent_worker);
+
+        // Wait for persistent Worker to finish
+        while (!worker_handler.isDone())
+            worker_handler.waitForOutput(g_main_timeout);
+
+        output_string = worker_handler.getOutput();
+        error_code = worker_handler.getErrorCode();
+    }
+    else
+        std::tie(output_string, error_code) =
+            system_call_error_code(m_simulator,
+                    current_task.getInputString());
 
     // Record output string and error code
     current_task.recordOutputAndErrorCode(output_string, error_code);
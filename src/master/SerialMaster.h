@@ -3,6 +3,7 @@
 
 #include <string>
 #include <queue>
+#include <memory>
 
 #include "core/common.h"
 
@@ -10,11 +11,13 @@
 
 class LongOptions;
 class Arguments;
+class PersistentWorker;
 
 /** A Master class for performing simulation tasks serially.
  *
  * The SerialMaster class performs simulation tasks serially by spawning child
- * processes with `fork()`--`exec()` to run simulations.
+ * processes with `posix_spawn()` to run simulations.  If the simulator is
+ * persistent, a single PersistentWorker is reused for all simulations.
  *
  * For instructions on how to use Pakman with the serial master, execute the
  * following command
@@ -27,16 +30,19 @@ class SerialMaster : public AbstractMaster
 {
     public:
 
-        /** Constructor saves simulator command and program termination flag.
+        /** Constructor saves simulator command, simulator persistence and
+         * program termination flag.
          *
          * @param simulator  command to run simulation.
+         * @param persistent_simulator  whether simulator is persistent.
          * @param p_program_terminated  pointer to boolean flag that is set
          * when the execution of Pakman is terminated by the user.
          */
-        SerialMaster(const Command& simulator, bool *p_program_terminated);
+        SerialMaster(const Command& simulator, bool persistent_simulator,
+                bool *p_program_terminated);
 
-        /** Default destructor does nothing. */
-        virtual ~SerialMaster() override = default;
+        /** Destructor terminates the persistent Worker if there is one. */
+        virtual ~SerialMaster() override;
 
         /** @return whether the AbstractMaster is active. */
         virtual bool isActive() const override;
@@ -47,8 +53,10 @@ class SerialMaster : public AbstractMaster
         /** Push a new pending task.
          *
          * @param input_string  input string to simulation job.
+         * @param metadata  number attached to task by AbstractController.
          */
-        virtual void pushPendingTask(const std::string& input_string) override;
+        virtual void pushPendingTask(const std::string& input_string,
+                double metadata = 0.0) override;
 
         /** @return whether finished tasks queue is empty. */
         virtual bool finishedTasksEmpty() const override;
@@ -115,6 +123,12 @@ class SerialMaster : public AbstractMaster
         // Simulator command
         const Command m_simulator;
 
+        // Whether simulator is persistent
+        const bool m_persistent_simulator;
+
+        // Persistent Worker (only used for persistent simulators)
+        std::unique_ptr<PersistentWorker> m_p_persistent_worker;
+
         // Finished tasks
         std::queue<TaskHandler> m_finished_tasks;
 
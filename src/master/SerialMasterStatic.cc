@@ -9,6 +9,7 @@
 #include "core/Command.h"
 #include "system/signal_handler.h"
 #include "system/debug.h"
+#include "system/reaper.h"
 #include "controller/AbstractController.h"
 
 #include "SerialMaster.h"
@@ -23,17 +24,35 @@ Description:
   When using a serial master, pakman executes simulations sequentially.  It is
   assumed that the simulator is a standard simulator, which means that it
   communicates with pakman through its stdin and stdout.
+
+  If the optional argument --persistent-simulator is given, the simulator is
+  started once and reused for all simulations.  The persistent simulator must
+  then read length-prefixed input frames from its stdin and write output
+  frames to its stdout in a loop.  It is only restarted when a simulation
+  fails.
+
+  If the first token of the simulator command ends in '.so', the simulator is
+  a plugin written with the header pakman_plugin.h, which pakman loads and
+  calls directly.  The same holds for the other user programs of the
+  controller.
+
+Serial master options:
+  -p, --persistent-simulator   simulator is started once and reused
 )";
 }
 
 void SerialMaster::addLongOptions(LongOptions& lopts)
 {
-    // No SerialMaster-specific options to add
+    lopts.add({"persistent-simulator", no_argument, nullptr, 'p'});
 }
 
 // Static run function
 void SerialMaster::run(controller_t controller, const Arguments& args)
 {
+    // Process optional arguments
+    bool persistent_simulator =
+        args.isOptionalArgumentSet("persistent-simulator");
+
     // Set signal handlers
     set_handlers();
     set_signal_handler();
@@ -44,7 +63,7 @@ void SerialMaster::run(controller_t controller, const Arguments& args)
 
     auto p_master =
         std::make_shared<SerialMaster>(p_controller->getSimulator(),
-                &g_program_terminated);
+                persistent_simulator, &g_program_terminated);
 
     // Associate with each other
     p_master->assignController(p_controller);
@@ -54,11 +73,17 @@ void SerialMaster::run(controller_t controller, const Arguments& args)
     while (p_master->isActive())
     {
         p_master->iterate();
+
+        // Advance termination of Workers that are shutting down
+        reap_children();
     }
 
     // Destroy Master and Controller
     p_master.reset();
     p_controller.reset();
+
+    // Wait for Workers that are shutting down
+    reap_children_blocking();
 }
 
 // Static cleanup function
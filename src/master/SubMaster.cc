@@ -0,0 +1,228 @@
+#include <string>
+#include <stdexcept>
+
+#include <assert.h>
+
+#include <mpi.h>
+
+#include "spdlog/spdlog.h"
+
+#include "mpi/mpi_common.h"
+#include "mpi/mpi_utils.h"
+#include "interface/protocols.h"
+
+#include "AbstractMaster.h"
+
+#include "SubMaster.h"
+
+// Construct from simulator command and communicator shared with MPIMaster
+SubMaster::SubMaster(const Command& simulator, MPI_Comm comm) :
+    m_simulator(simulator),
+    m_comm(comm),
+    m_messages(comm)
+{
+}
+
+// Iterate
+void SubMaster::iterate()
+{
+    // Once terminated, the assigned Master only needs to terminate the
+    // Managers of the node
+    if (m_terminated)
+        return;
+
+    m_messages.complete();
+
+    // Reply to batches whose tasks have all finished
+    collectFinishedTasks();
+
+    // Check for signals
+    if (probeSignal())
+    {
+        switch (receiveSignal())
+        {
+            case TERMINATE_MANAGER_SIGNAL:
+
+                spdlog::debug("SubMaster {}/{}: received "
+                        "TERMINATE_MANAGER_SIGNAL!",
+                        get_mpi_comm_world_rank(), get_mpi_comm_world_size());
+
+                // Terminate assigned Master and thereby the Managers of the
+                // node
+                m_terminated = true;
+                m_p_master->terminate();
+                return;
+
+            case FLUSH_WORKER_SIGNAL:
+
+                spdlog::debug("SubMaster {}/{}: received "
+                        "FLUSH_WORKER_SIGNAL!",
+                        get_mpi_comm_world_rank(), get_mpi_comm_world_size());
+
+                advanceEpoch(++m_flush_signal_count);
+                break;
+
+            // TERMINATE_MANAGER_SIGNAL and FLUSH_WORKER_SIGNAL are the
+            // only valid Master signals
+            default:
+                throw;
+        }
+    }
+
+    // Receive all batches that have arrived, so that the assigned Master can
+    // delegate their tasks in this iteration
+    while (probeMessage())
+        receiveBatch();
+}
+
+// Return simulator command
+Command SubMaster::getSimulator() const
+{
+    return m_simulator;
+}
+
+// Move finished tasks into replies and send completed replies
+void SubMaster::collectFinishedTasks()
+{
+    // The assigned Master delivers finished tasks in the order in which they
+    // were pushed, so they belong to the front batch
+    while (!m_p_master->finishedTasksEmpty())
+    {
+        // Sanity check: every task belongs to a batch
+        if (m_batches.empty())
+        {
+            std::runtime_error e("SubMaster has a finished task that does "
+                    "not belong to any batch");
+            throw e;
+        }
+
+        AbstractMaster::TaskHandler& task = m_p_master->frontFinishedTask();
+        m_batch_outputs += format_persistent_simulator_output(
+                task.getOutputString(), task.getErrorCode());
+        m_p_master->popFinishedTask();
+
+        // Send reply once all tasks of the front batch have finished
+        Batch& batch = m_batches.front();
+        if (++batch.num_finished == batch.size)
+        {
+            sendMessageToMaster(m_batch_outputs);
+            m_batches.pop_front();
+        }
+    }
+}
+
+// Receive batch of input strings and push them as pending tasks
+void SubMaster::receiveBatch()
+{
+    // Sanity check: probeMessage must return true
+    assert(probeMessage());
+
+    receive_string(m_comm, MASTER_RANK, MASTER_MSG_TAG, m_receive_buffer);
+    std::string& message = m_receive_buffer;
+
+    // Parse epoch header
+    std::string::size_type newline = message.find('\n');
+    if (newline == std::string::npos)
+    {
+        std::runtime_error e("cannot parse epoch of batch from Master");
+        throw e;
+    }
+
+    int epoch = std::stoi(message.substr(0, newline));
+    message.erase(0, newline + 1);
+
+    // A batch of a later epoch means that the Master has been flushed
+    advanceEpoch(epoch);
+
+    // A batch sent before the last FLUSH_WORKER_SIGNAL may arrive after it,
+    // in which case it is stale already.  All batches of earlier epochs have
+    // been replied to, so it can be replied to right away
+    if (epoch < m_epoch)
+    {
+        std::string empty_message;
+        sendMessageToMaster(empty_message);
+        return;
+    }
+
+    int batch_size = 0;
+    std::string input_string;
+    while (parse_persistent_simulator_input(message, input_string))
+    {
+        m_p_master->pushPendingTask(input_string);
+        batch_size++;
+    }
+
+    // Sanity check: batch should be nonempty and completely parsed
+    if (batch_size == 0 || !message.empty())
+    {
+        std::runtime_error e("cannot parse batch of tasks from Master");
+        throw e;
+    }
+
+    spdlog::debug("SubMaster {}/{}: received batch of {} tasks",
+            get_mpi_comm_world_rank(), get_mpi_comm_world_size(),
+            batch_size);
+
+    Batch batch;
+    batch.epoch = epoch;
+    batch.size = batch_size;
+    batch.num_finished = 0;
+    m_batches.push_back(batch);
+}
+
+// Enter epoch, discarding batches of earlier epochs
+void SubMaster::advanceEpoch(int epoch)
+{
+    if (epoch <= m_epoch)
+        return;
+
+    spdlog::debug("SubMaster {}/{}: entering epoch {}",
+            get_mpi_comm_world_rank(), get_mpi_comm_world_size(), epoch);
+
+    m_epoch = epoch;
+
+    // All batches that have been received are of earlier epochs now
+    if (m_batches.empty())
+        return;
+
+    // Reply with empty messages so that the Master can account for batches
+    while (!m_batches.empty())
+    {
+        m_batch_outputs.clear();
+        sendMessageToMaster(m_batch_outputs);
+        m_batches.pop_front();
+    }
+
+    // Flush the tasks of these batches, which also flushes the Workers of
+    // the Managers of the node
+    m_p_master->flush();
+}
+
+// Probe for message
+bool SubMaster::probeMessage() const
+{
+    return iprobe_wrapper(MASTER_RANK, MASTER_MSG_TAG, m_comm);
+}
+
+// Probe for signal
+bool SubMaster::probeSignal() const
+{
+    return iprobe_wrapper(MASTER_RANK, MASTER_SIGNAL_TAG, m_comm);
+}
+
+// Receive signal
+int SubMaster::receiveSignal() const
+{
+    // Sanity check: probeSignal must return true
+    assert(probeSignal());
+
+    return receive_integer(m_comm, MASTER_RANK, MASTER_SIGNAL_TAG);
+}
+
+// Send message to Master
+void SubMaster::sendMessageToMaster(std::string& message_string)
+{
+    // Several batches may be replied to at once, and on rank 0 the Master
+    // only receives them once the SubMaster returns, so sends must not wait
+    m_messages.send(MASTER_RANK, MANAGER_MSG_TAG, message_string);
+}
@@ -0,0 +1,131 @@
+#ifndef SUBMASTER_H
+#define SUBMASTER_H
+
+#include <string>
+#include <deque>
+
+#include <mpi.h>
+
+#include "core/Command.h"
+#include "mpi/SendQueue.h"
+#include "controller/AbstractController.h"
+
+/** A helper class for relaying simulation tasks from the MPIMaster to the
+ * Managers of a node.
+ *
+ * With sub-masters, the MPI processes are divided into nodes using
+ * `MPI_Comm_split_type()`.  The process with the lowest rank on every node
+ * runs a SubMaster, and the MPIMaster on rank 0 only exchanges messages with
+ * the SubMasters, which act as its Managers.  Every SubMaster in turn drives
+ * an MPIMaster of its own, which delegates tasks to the Managers of its node
+ * on the communicator of the node.  This way, the MPIMaster on rank 0 handles
+ * one peer per node instead of one peer per MPI process, and messages between
+ * nodes are only exchanged between rank 0 and the SubMasters.
+ *
+ * Towards the MPIMaster on rank 0, a SubMaster speaks the same protocol as a
+ * Manager.  It receives batches of input strings tagged with an epoch, pushes
+ * every input string as a pending task to its own MPIMaster, and replies to
+ * every batch with the output strings and error codes of its tasks once all
+ * of them have finished.  Batches are replied to in the order in which they
+ * were received.  When the MPIMaster on rank 0 starts a new epoch, the
+ * SubMaster replies to all batches of earlier epochs with empty messages and
+ * flushes its own MPIMaster, which passes the flush on to the Managers of the
+ * node.  Likewise, the SubMaster terminates its own MPIMaster, and thereby the
+ * Managers of the node, when it receives TERMINATE_MANAGER_SIGNAL.
+ *
+ * Towards its own MPIMaster, the SubMaster is a Controller, so it is called
+ * from MPIMaster::iterate() and is not iterated separately.
+ */
+
+class SubMaster : public AbstractController
+{
+    public:
+
+        /** Constructor saves simulator command and communicator.
+         *
+         * @param simulator  command to run simulation.
+         * @param comm  communicator on which the SubMaster exchanges
+         * messages with the MPIMaster, which has rank MASTER_RANK in it.
+         */
+        SubMaster(const Command& simulator, MPI_Comm comm);
+
+        /** Default destructor. */
+        virtual ~SubMaster() override = default;
+
+        /** Relay batches and signals from the MPIMaster to the assigned
+         * AbstractMaster, and replies from the assigned AbstractMaster back
+         * to the MPIMaster.
+         */
+        virtual void iterate() override;
+
+        /** @return simulator command. */
+        virtual Command getSimulator() const override;
+
+    private:
+
+        // Batch of tasks received from the MPIMaster
+        struct Batch
+        {
+            // Epoch in which the batch was sent
+            int epoch;
+
+            // Number of tasks
+            int size;
+
+            // Number of finished tasks
+            int num_finished;
+        };
+
+        // Move finished tasks into replies and send completed replies
+        void collectFinishedTasks();
+
+        // Receive batch of input strings and push them as pending tasks
+        void receiveBatch();
+
+        // Enter epoch, discarding batches of earlier epochs
+        void advanceEpoch(int epoch);
+
+        // Probe for message
+        bool probeMessage() const;
+
+        // Probe for signal
+        bool probeSignal() const;
+
+        // Receive signal
+        int receiveSignal() const;
+
+        // Send message to MPIMaster.  The message string is swapped into a
+        // new send buffer and left empty
+        void sendMessageToMaster(std::string& message_string);
+
+        // Command to run simulation
+        const Command m_simulator;
+
+        // Communicator shared with MPIMaster
+        const MPI_Comm m_comm;
+
+        // Batches that have been received but not yet replied to, in order of
+        // reception
+        std::deque<Batch> m_batches;
+
+        // Current epoch
+        int m_epoch = 0;
+
+        // Number of FLUSH_WORKER_SIGNALs received, which is the epoch of the
+        // MPIMaster at the time of the last signal
+        int m_flush_signal_count = 0;
+
+        // Whether TERMINATE_MANAGER_SIGNAL has been received
+        bool m_terminated = false;
+
+        // Output strings and error codes of front batch
+        std::string m_batch_outputs;
+
+        // Messages to MPIMaster that are being sent
+        SendQueue m_messages;
+
+        // Buffer for messages from MPIMaster
+        std::string m_receive_buffer;
+};
+
+#endif // SUBMASTER_H
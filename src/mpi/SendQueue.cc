@@ -0,0 +1,55 @@
+#include <string>
+
+#include <mpi.h>
+
+#include "SendQueue.h"
+
+// Construct from communicator
+SendQueue::SendQueue(MPI_Comm comm) :
+    m_comm(comm)
+{
+}
+
+// Destroy MPI_Request objects
+SendQueue::~SendQueue()
+{
+    // If MPI_Finalize has been called, nothing needs to be done
+    int finalized = 0;
+    MPI_Finalized(&finalized);
+
+    if (finalized)
+        return;
+
+    // Else free requests if they are non-null
+    for (Message& message : m_messages)
+        if (message.request != MPI_REQUEST_NULL)
+            MPI_Request_free(&message.request);
+}
+
+// Send message
+void SendQueue::send(int dest, int tag, std::string& message_string)
+{
+    m_messages.emplace_back();
+    Message& message = m_messages.back();
+    message.buffer.swap(message_string);
+    message_string.clear();
+
+    MPI_Isend(message.buffer.c_str(), message.buffer.size() + 1, MPI_CHAR,
+            dest, tag, m_comm, &message.request);
+}
+
+// Free send buffers of messages that have been sent
+void SendQueue::complete()
+{
+    while (!m_messages.empty())
+    {
+        int flag = 0;
+        MPI_Test(&m_messages.front().request, &flag, MPI_STATUS_IGNORE);
+
+        if (!flag)
+            return;
+
+        m_messages.pop_front();
+    }
+}
+
@@ -0,0 +1,78 @@
+#ifndef SENDQUEUE_H
+#define SENDQUEUE_H
+
+#include <string>
+#include <deque>
+
+#include <mpi.h>
+
+/** A class for sending strings with nonblocking sends.
+ *
+ * A SendQueue gives every message its own send buffer and request, so that
+ * any number of messages can be in flight at once and the sender never
+ * waits for a previous message to be received.  This matters on rank 0,
+ * where the receiving MPIMaster and the sending Manager or SubMaster share a
+ * single thread: waiting for a message to rank 0 to be sent would deadlock,
+ * since it is only received once the sender returns.
+ *
+ * Send buffers are freed by complete(), which should be called regularly,
+ * for example at the start of every iteration of the sender.
+ */
+
+class SendQueue
+{
+    public:
+
+        /** Constructor saves communicator.
+         *
+         * @param comm  communicator on which messages are sent.
+         */
+        SendQueue(MPI_Comm comm);
+
+        /** Destructor frees requests of messages that have not been sent,
+         * unless MPI_Finalize has been called.
+         */
+        ~SendQueue();
+
+        SendQueue(const SendQueue&) = delete;
+        SendQueue& operator=(const SendQueue&) = delete;
+
+        /** Send message.
+         *
+         * The message string is swapped into a new send buffer and left
+         * empty, so that the caller can reuse its capacity.  The message is
+         * sent with its terminating null character as MPI_CHAR.
+         *
+         * @param dest  rank of destination.
+         * @param tag  message tag.
+         * @param message_string  message to send.
+         */
+        void send(int dest, int tag, std::string& message_string);
+
+        /** Free send buffers of messages that have been sent, in order of
+         * sending.
+         */
+        void complete();
+
+    private:
+
+        // Message that is being sent
+        struct Message
+        {
+            // Send buffer
+            std::string buffer;
+
+            // Send request
+            MPI_Request request = MPI_REQUEST_NULL;
+        };
+
+        // Communicator on which messages are sent
+        const MPI_Comm m_comm;
+
+        // Messages that are being sent, in order of sending.  Elements of a
+        // deque are not moved when elements are added at the end, so send
+        // buffers stay in place
+        std::deque<Message> m_messages;
+};
+
+#endif // SENDQUEUE_H
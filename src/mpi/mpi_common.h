@@ -9,9 +9,10 @@ const int MASTER_MSG_TAG = 0;
 const int MASTER_SIGNAL_TAG = 1;
 const int MANAGER_MSG_TAG = 2;
 const int MANAGER_SIGNAL_TAG = 3;
-const int MANAGER_ERROR_CODE_TAG = 4;
-const int WORKER_MSG_TAG = 5;
-const int WORKER_ERROR_CODE_TAG = 6;
+const int STEAL_REQUEST_TAG = 4;
+const int STEAL_REPLY_TAG = 5;
+const int STOLEN_RESULT_TAG = 6;
+const int WORKER_RESULT_TAG = 7;
 
 ///// Master signals /////
 // Terminate Manager
@@ -19,12 +20,16 @@ const int TERMINATE_MANAGER_SIGNAL = 0;
 // Flush Worker
 const int FLUSH_WORKER_SIGNAL = 1;
 
-///// Manager signals /////
-// Worker is cancelled
-const int WORKER_FLUSHED_SIGNAL = 0;
-
 ///// Manager to Worker signals /////
 // Terminate worker
 const int TERMINATE_WORKER_SIGNAL = 0;
+// Cancel simulation of worker
+const int CANCEL_WORKER_SIGNAL = 1;
+
+///// Worker result payload types /////
+// Output string
+const int TEXT_PAYLOAD = 0;
+// Array of doubles
+const int DOUBLE_PAYLOAD = 1;
 
 #endif // MPI_COMMON_H
@@ -22,6 +22,20 @@ int get_mpi_comm_world_rank()
     return rank;
 }
 
+int get_mpi_comm_size(MPI_Comm comm)
+{
+    int size = 0;
+    MPI_Comm_size(comm, &size);
+    return size;
+}
+
+int get_mpi_comm_rank(MPI_Comm comm)
+{
+    int rank = 0;
+    MPI_Comm_rank(comm, &rank);
+    return rank;
+}
+
 bool iprobe_wrapper(int source, int tag, MPI_Comm comm, MPI_Status *p_status)
 {
     int flag = 0;
@@ -30,21 +44,29 @@ bool iprobe_wrapper(int source, int tag, MPI_Comm comm, MPI_Status *p_status)
 }
 
 std::string receive_string(MPI_Comm comm, int source, int tag)
+{
+    std::string message;
+    receive_string(comm, source, tag, message);
+    return message;
+}
+
+void receive_string(MPI_Comm comm, int source, int tag, std::string& buffer)
 {
     // Probe to get status
     MPI_Status status;
     MPI_Probe(source, tag, comm, &status);
 
-    // Receive string
+    // Receive string directly into buffer, which only reallocates if its
+    // capacity is too small
     int count = 0;
     MPI_Get_count(&status, MPI_CHAR, &count);
-    char *buffer = new char[count];
-    MPI_Recv(buffer, count, MPI_CHAR, source, tag, comm, MPI_STATUS_IGNORE);
+    buffer.resize(count);
+    MPI_Recv(&buffer[0], count, MPI_CHAR, source, tag, comm,
+            MPI_STATUS_IGNORE);
 
-    // Return string
-    std::string message(buffer);
-    delete[] buffer;
-    return message;
+    // Strip null-terminating character
+    if (count > 0)
+        buffer.resize(count - 1);
 }
 
 int receive_integer(MPI_Comm comm, int source, int tag)
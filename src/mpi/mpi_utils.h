@@ -6,11 +6,14 @@
 
 int get_mpi_comm_world_size();
 int get_mpi_comm_world_rank();
+int get_mpi_comm_size(MPI_Comm comm);
+int get_mpi_comm_rank(MPI_Comm comm);
 
 bool iprobe_wrapper(int source, int tag, MPI_Comm comm,
         MPI_Status *status = MPI_STATUS_IGNORE);
 
 std::string receive_string(MPI_Comm comm, int source, int tag);
+void receive_string(MPI_Comm comm, int source, int tag, std::string& buffer);
 int receive_integer(MPI_Comm comm, int source, int tag);
 
 #endif // MPI_UTILS_H
@@ -12,15 +12,14 @@
 #include "mpi_common.h"
 #include "spawn.h"
 
-MPI_Comm spawn(const Command& cmd, MPI_Info info)
+MPI_Comm spawn(const Command& cmd, int maxprocs, MPI_Info info)
 {
     // Get argv from command
     char **argv = cmd.argv();
 
-    // Spawn single process and return intercomm
+    // Spawn maxprocs processes and return intercomm
     // The argument list to Spawn is shifted by one
     // compared to the exec argument list
-    const int maxprocs = 1;
     const int root = 0;
 
     spdlog::debug("Spawning {}...", argv[0]);
@@ -35,7 +34,7 @@ MPI_Comm spawn(const Command& cmd, MPI_Info info)
     return spawn_intercomm;
 }
 
-MPI_Comm spawn_worker(const Command& cmd)
+MPI_Comm spawn_worker(const Command& cmd, int procs)
 {
     // Create MPI_Info object
     MPI_Info info;
@@ -50,10 +49,67 @@ MPI_Comm spawn_worker(const Command& cmd)
     }
 
     // Spawn Worker
-    MPI_Comm child_comm = spawn(cmd, info);
+    MPI_Comm child_comm = spawn(cmd, procs, info);
 
     // Free MPI_Info object
     MPI_Info_free(&info);
 
     return child_comm;
 }
+
+MPI_Comm spawn_workers_collectively(const Command& cmd, int procs)
+{
+    // Get argv from command
+    char **argv = cmd.argv();
+
+    int comm_size = 0, rank = 0;
+    MPI_Comm_size(MPI_COMM_WORLD, &comm_size);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    // Gather host names of all MPI processes if every Worker group needs to
+    // be spawned on the same host as its Manager
+    struct utsname buf;
+    std::vector<char> nodenames;
+    if (g_force_host_spawn)
+    {
+        uname(&buf);
+        nodenames.resize(comm_size * sizeof(buf.nodename));
+        MPI_Gather(buf.nodename, sizeof(buf.nodename), MPI_CHAR,
+                nodenames.data(), sizeof(buf.nodename), MPI_CHAR, 0,
+                MPI_COMM_WORLD);
+    }
+
+    // Spawn one Worker group of procs processes per MPI process.  Only the
+    // arguments at the root are significant.  The application number of
+    // every Worker group is the rank of its Manager
+    std::vector<char*> commands(comm_size, argv[0]);
+    std::vector<char**> argvs(comm_size, argv + 1);
+    std::vector<int> maxprocs(comm_size, procs);
+    std::vector<MPI_Info> infos(comm_size, MPI_INFO_NULL);
+
+    if (g_force_host_spawn && (rank == 0))
+    {
+        for (int i = 0; i < comm_size; i++)
+        {
+            MPI_Info_create(&infos[i]);
+            MPI_Info_set(infos[i], "host",
+                    &nodenames[i * sizeof(buf.nodename)]);
+        }
+    }
+
+    spdlog::debug("Spawning {} groups of {}...", comm_size, argv[0]);
+
+    MPI_Comm spawn_intercomm;
+    MPI_Comm_spawn_multiple(comm_size, commands.data(), argvs.data(),
+            maxprocs.data(), infos.data(), 0, MPI_COMM_WORLD,
+            &spawn_intercomm, MPI_ERRCODES_IGNORE);
+
+    spdlog::debug("Spawn of {} groups complete", argv[0]);
+
+    // Free MPI_Info objects
+    for (MPI_Info& info : infos)
+        if (info != MPI_INFO_NULL)
+            MPI_Info_free(&info);
+
+    return spawn_intercomm;
+}
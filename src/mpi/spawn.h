@@ -5,7 +5,9 @@
 
 class Command;
 
-MPI_Comm spawn(const Command& cmd, MPI_Info info = MPI_INFO_NULL);
-MPI_Comm spawn_worker(const Command& cmd);
+MPI_Comm spawn(const Command& cmd, int maxprocs = 1,
+        MPI_Info info = MPI_INFO_NULL);
+MPI_Comm spawn_worker(const Command& cmd, int procs = 1);
+MPI_Comm spawn_workers_collectively(const Command& cmd, int procs);
 
 #endif // SPAWN_H
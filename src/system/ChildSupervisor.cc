@@ -0,0 +1,192 @@
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdint>
+
+#include <unistd.h>
+#include <poll.h>
+#include <errno.h>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/syscall.h>
+#endif
+
+#include "ChildSupervisor.h"
+
+// Maximum number of events returned by a single call to epoll_wait().  Any
+// further events are returned by the next call
+const int MAX_EVENTS = 64;
+
+ChildSupervisor::ChildSupervisor()
+{
+#ifdef __linux__
+    m_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+
+    if (m_epoll_fd == -1)
+    {
+        std::runtime_error e("epoll_create1 failed");
+        throw e;
+    }
+#endif
+}
+
+ChildSupervisor::~ChildSupervisor()
+{
+    for (auto& item : m_entries)
+        if (item.second.pid_fd != -1)
+            close(item.second.pid_fd);
+
+    if (m_epoll_fd != -1)
+        close(m_epoll_fd);
+}
+
+void ChildSupervisor::watch(int key, int read_fd, int write_fd)
+{
+    Entry& entry = m_entries[key];
+    update(key, entry.read_fd, read_fd, POLLIN);
+    update(key, entry.write_fd, write_fd, POLLOUT);
+}
+
+bool ChildSupervisor::watchExit(int key, pid_t pid)
+{
+#if defined(__linux__) && defined(SYS_pidfd_open)
+    // A pidfd becomes readable when the process exits.  Kernels older than
+    // Linux 5.3 do not support pidfds
+    int pid_fd = syscall(SYS_pidfd_open, pid, 0);
+    if (pid_fd == -1)
+        return false;
+
+    Entry& entry = m_entries[key];
+    int old_pid_fd = entry.pid_fd;
+    update(key, entry.pid_fd, pid_fd, POLLIN);
+    if (old_pid_fd != -1)
+        close(old_pid_fd);
+
+    return true;
+#else
+    (void) key;
+    (void) pid;
+    return false;
+#endif
+}
+
+void ChildSupervisor::unwatch(int key)
+{
+    auto it = m_entries.find(key);
+    if (it == m_entries.end())
+        return;
+
+    Entry& entry = it->second;
+    int pid_fd = entry.pid_fd;
+
+    update(key, entry.read_fd, -1, POLLIN);
+    update(key, entry.write_fd, -1, POLLOUT);
+    update(key, entry.pid_fd, -1, POLLIN);
+
+    // Pidfds are owned by the supervisor, unlike pipes
+    if (pid_fd != -1)
+        close(pid_fd);
+
+    m_entries.erase(it);
+}
+
+int ChildSupervisor::wait(int timeout_ms, std::vector<int>& ready_keys)
+{
+    const std::size_t first = ready_keys.size();
+
+#ifdef __linux__
+    struct epoll_event events[MAX_EVENTS];
+    int count = epoll_wait(m_epoll_fd, events, MAX_EVENTS, timeout_ms);
+
+    if (count == -1)
+    {
+        // Allow interrupts
+        if (errno == EINTR) return 0;
+
+        std::runtime_error e("epoll_wait failed");
+        throw e;
+    }
+
+    for (int i = 0; i < count; i++)
+        ready_keys.push_back(static_cast<int>(
+                    static_cast<uint32_t>(events[i].data.u64)));
+#else
+    std::vector<struct pollfd> fds;
+    std::vector<int> keys;
+    for (const auto& item : m_entries)
+    {
+        for (int fd : {item.second.read_fd, item.second.write_fd})
+        {
+            if (fd == -1)
+                continue;
+
+            struct pollfd pfd;
+            pfd.fd = fd;
+            pfd.events = (fd == item.second.read_fd) ? POLLIN : POLLOUT;
+            pfd.revents = 0;
+            fds.push_back(pfd);
+            keys.push_back(item.first);
+        }
+    }
+
+    if (poll(fds.data(), fds.size(), timeout_ms) == -1)
+    {
+        // Allow interrupts
+        if (errno == EINTR) return 0;
+
+        std::runtime_error e("poll failed");
+        throw e;
+    }
+
+    for (std::size_t i = 0; i < fds.size(); i++)
+        if (fds[i].revents)
+            ready_keys.push_back(keys[i]);
+#endif
+
+    // A child process whose pipes are both ready is reported only once
+    std::sort(ready_keys.begin() + first, ready_keys.end());
+    ready_keys.erase(std::unique(ready_keys.begin() + first,
+                ready_keys.end()), ready_keys.end());
+
+    return ready_keys.size() - first;
+}
+
+int ChildSupervisor::size() const
+{
+    return m_entries.size();
+}
+
+void ChildSupervisor::update(int key, int& current_fd, int new_fd,
+        int events)
+{
+    if (new_fd == current_fd)
+        return;
+
+#ifdef __linux__
+    // If the current file descriptor has been closed, the kernel has already
+    // deregistered it, so errors are ignored
+    if (current_fd != -1)
+        epoll_ctl(m_epoll_fd, EPOLL_CTL_DEL, current_fd, nullptr);
+
+    if (new_fd != -1)
+    {
+        // The key is stored as an unsigned number, so that negative keys
+        // round-trip
+        struct epoll_event event;
+        event.events = events;
+        event.data.u64 = static_cast<uint32_t>(key);
+
+        if (epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, new_fd, &event) == -1)
+        {
+            std::runtime_error e("epoll_ctl failed");
+            throw e;
+        }
+    }
+#else
+    (void) key;
+    (void) events;
+#endif
+
+    current_fd = new_fd;
+}
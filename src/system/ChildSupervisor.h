@@ -0,0 +1,106 @@
+#ifndef CHILDSUPERVISOR_H
+#define CHILDSUPERVISOR_H
+
+#include <vector>
+#include <unordered_map>
+
+#include <unistd.h>
+
+/** A class for waiting on many child processes at once.
+ *
+ * A ChildSupervisor keeps a set of child processes, each identified by an
+ * integer key chosen by the caller, such as a Worker slot or a process id.
+ * For every child process, the supervisor can watch a read pipe, a write pipe
+ * and the exit of the process itself.  A single call to wait() then reports
+ * the keys of all child processes that are ready, so that an event loop only
+ * needs to look at those.
+ *
+ * On Linux, the file descriptors are registered once with an `epoll`
+ * instance, so that the cost of waiting does not grow with the number of
+ * child processes.  Process exits are watched with pidfds.  On other
+ * systems, or if the kernel does not support pidfds, the supervisor falls
+ * back to `poll()` and does not watch process exits, respectively.
+ *
+ * File descriptors are registered and deregistered only when they change.
+ * Since `epoll_ctl()` cannot deregister a file descriptor once it has been
+ * closed, unwatch() must be called for a key before its file descriptors are
+ * closed.  If a file descriptor is closed by other means, watch() must be
+ * called for the key right afterwards, before new file descriptors are
+ * opened that may reuse its number.
+ */
+
+class ChildSupervisor
+{
+    public:
+
+        /** Default constructor creates an empty set of child processes. */
+        ChildSupervisor();
+
+        /** Destructor closes all pidfds. */
+        ~ChildSupervisor();
+
+        ChildSupervisor(const ChildSupervisor&) = delete;
+        ChildSupervisor& operator=(const ChildSupervisor&) = delete;
+
+        /** Watch pipes of child process.
+         *
+         * @param key  key of child process.
+         * @param read_fd  read pipe to watch for input, or -1.
+         * @param write_fd  write pipe to watch for space to write to, or -1.
+         */
+        void watch(int key, int read_fd, int write_fd);
+
+        /** Watch exit of child process.
+         *
+         * @param key  key of child process.
+         * @param pid  process id of child process.
+         *
+         * @return whether the exit can be watched.  If not, the caller has
+         * to check for the exit itself, for example with `waitpid()` and
+         * `WNOHANG`.
+         */
+        bool watchExit(int key, pid_t pid);
+
+        /** Stop watching child process.
+         *
+         * @param key  key of child process.
+         */
+        void unwatch(int key);
+
+        /** Wait until any watched child process is ready or the timeout has
+         * elapsed, whichever comes first.
+         *
+         * @param timeout_ms  timeout in milliseconds, -1 to wait
+         * indefinitely, or 0 to return immediately.
+         * @param ready_keys  vector to which the keys of ready child
+         * processes are appended, each key once.
+         *
+         * @return number of keys appended.
+         */
+        int wait(int timeout_ms, std::vector<int>& ready_keys);
+
+        /** @return number of watched child processes. */
+        int size() const;
+
+    private:
+
+        // File descriptors of child process, -1 if not watched
+        struct Entry
+        {
+            int read_fd = -1;
+            int write_fd = -1;
+            int pid_fd = -1;
+        };
+
+        // Replace registered file descriptor of child process with new one,
+        // watching the new one for the given poll() events
+        void update(int key, int& current_fd, int new_fd, int events);
+
+        // Watched child processes
+        std::unordered_map<int, Entry> m_entries;
+
+        // File descriptor of epoll instance, -1 if poll() is used
+        int m_epoll_fd = -1;
+};
+
+#endif // CHILDSUPERVISOR_H
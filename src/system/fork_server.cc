@@ -0,0 +1,327 @@
+#include <string>
+#include <map>
+#include <vector>
+#include <tuple>
+#include <utility>
+#include <exception>
+#include <stdexcept>
+
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+
+#include "system_call.h"
+
+#include "fork_server.h"
+
+namespace
+{
+
+// Request types
+const char SPAWN_REQUEST = 's';
+const char WAIT_REQUEST = 'w';
+
+// Maximum size of a request, which limits the length of commands
+const size_t MAX_REQUEST_SIZE = 1 << 16;
+
+struct WaitRequest
+{
+    pid_t pid;
+    int options;
+};
+
+struct WaitReply
+{
+    pid_t retval;
+    int status;
+    int error;
+};
+
+// Socket connected to fork server, or -1 if fork server is not running
+int s_socket_fd = -1;
+
+// Process id of fork server
+pid_t s_server_pid = 0;
+
+// Send message, throw error on failure
+void send_message(int socket_fd, const void *data, size_t size)
+{
+    if (send(socket_fd, data, size, MSG_NOSIGNAL) !=
+            static_cast<ssize_t>(size))
+    {
+        std::runtime_error e("send to fork server socket failed");
+        throw e;
+    }
+}
+
+// Send spawn reply with pipe file descriptors attached
+void send_spawn_reply(int socket_fd, pid_t pid, const int pipe_fds[2])
+{
+    struct iovec iov;
+    iov.iov_base = &pid;
+    iov.iov_len = sizeof(pid);
+
+    union
+    {
+        char buffer[CMSG_SPACE(2 * sizeof(int))];
+        struct cmsghdr align;
+    } control;
+    memset(&control, 0, sizeof(control));
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+
+    // Attach file descriptors only if spawn was successful
+    if (pid > 0)
+    {
+        msg.msg_control = control.buffer;
+        msg.msg_controllen = sizeof(control.buffer);
+
+        struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(2 * sizeof(int));
+        memcpy(CMSG_DATA(cmsg), pipe_fds, 2 * sizeof(int));
+    }
+
+    if (sendmsg(socket_fd, &msg, MSG_NOSIGNAL) !=
+            static_cast<ssize_t>(sizeof(pid)))
+    {
+        std::runtime_error e("sendmsg to fork server socket failed");
+        throw e;
+    }
+}
+
+// Receive spawn reply and attached pipe file descriptors
+pid_t receive_spawn_reply(int socket_fd, int pipe_fds[2])
+{
+    pid_t pid;
+    struct iovec iov;
+    iov.iov_base = &pid;
+    iov.iov_len = sizeof(pid);
+
+    union
+    {
+        char buffer[CMSG_SPACE(2 * sizeof(int))];
+        struct cmsghdr align;
+    } control;
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buffer;
+    msg.msg_controllen = sizeof(control.buffer);
+
+    // Received file descriptors are closed on exec, like all pipes
+    if (recvmsg(socket_fd, &msg, MSG_CMSG_CLOEXEC) !=
+            static_cast<ssize_t>(sizeof(pid)))
+    {
+        std::runtime_error e("recvmsg from fork server socket failed");
+        throw e;
+    }
+
+    if (pid <= 0)
+        return pid;
+
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    if (    (cmsg == nullptr) ||
+            (cmsg->cmsg_type != SCM_RIGHTS) ||
+            (cmsg->cmsg_len != CMSG_LEN(2 * sizeof(int))) )
+    {
+        std::runtime_error e("fork server did not send pipes");
+        throw e;
+    }
+
+    memcpy(pipe_fds, CMSG_DATA(cmsg), 2 * sizeof(int));
+
+    return pid;
+}
+
+// Serve requests until the client closes its end of the socket
+void serve(int socket_fd)
+{
+    // Termination signals are meant for the MPI process, which closes the
+    // socket when it exits
+    signal(SIGINT, SIG_IGN);
+    signal(SIGTERM, SIG_IGN);
+
+    // Commands by raw command string, so that executable paths are only
+    // resolved once
+    std::map<std::string, Command> commands;
+
+    std::vector<char> buffer(MAX_REQUEST_SIZE);
+
+    while (true)
+    {
+        ssize_t size = recv(socket_fd, buffer.data(), buffer.size(), 0);
+
+        // Client has exited
+        if (size <= 0)
+            return;
+
+        if (buffer[0] == SPAWN_REQUEST)
+        {
+            std::string raw_command(buffer.data() + 1, size - 1);
+
+            auto it = commands.find(raw_command);
+            if (it == commands.end())
+                it = commands.emplace(raw_command,
+                        Command(raw_command)).first;
+
+            // Launch child process.  On failure, the client is sent a
+            // nonpositive process id
+            pid_t pid = -1;
+            int pipe_fds[2] = {-1, -1};
+            try
+            {
+                std::tie(pid, pipe_fds[0], pipe_fds[1]) =
+                    system_call_non_blocking_read_write(it->second);
+            }
+            catch (const std::exception&)
+            {
+                pid = -1;
+            }
+
+            send_spawn_reply(socket_fd, pid, pipe_fds);
+
+            // The pipes now belong to the client
+            if (pid > 0)
+            {
+                close_check(pipe_fds[0]);
+                close_check(pipe_fds[1]);
+            }
+        }
+        else if ((buffer[0] == WAIT_REQUEST) &&
+                (size == static_cast<ssize_t>(1 + sizeof(WaitRequest))))
+        {
+            WaitRequest request;
+            memcpy(&request, buffer.data() + 1, sizeof(request));
+
+            WaitReply reply;
+            reply.retval = waitpid(request.pid, &reply.status,
+                    request.options);
+            reply.error = errno;
+
+            send_message(socket_fd, &reply, sizeof(reply));
+        }
+    }
+}
+
+}
+
+void start_fork_server()
+{
+    // Socket ends are closed on exec, so that they are not inherited by
+    // child processes
+    int socket_fds[2];
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, socket_fds)
+            == -1)
+    {
+        std::runtime_error e("socketpair for fork server failed");
+        throw e;
+    }
+
+    pid_t pid = fork();
+
+    if (pid == -1)
+    {
+        std::runtime_error e("fork of fork server failed");
+        throw e;
+    }
+
+    if (pid == 0) // I am the fork server
+    {
+        close_check(socket_fds[0]);
+
+        try
+        {
+            serve(socket_fds[1]);
+        }
+        catch (const std::exception&)
+        {
+            _exit(EXIT_FAILURE);
+        }
+
+        _exit(EXIT_SUCCESS);
+    }
+
+    close_check(socket_fds[1]);
+    s_socket_fd = socket_fds[0];
+    s_server_pid = pid;
+}
+
+void stop_fork_server()
+{
+    if (!fork_server_running())
+        return;
+
+    close_check(s_socket_fd);
+    s_socket_fd = -1;
+
+    waitpid(s_server_pid, nullptr, 0);
+    s_server_pid = 0;
+}
+
+bool fork_server_running()
+{
+    return s_socket_fd != -1;
+}
+
+std::tuple<pid_t, int, int> fork_server_spawn(const Command& cmd)
+{
+    std::string request(1, SPAWN_REQUEST);
+    request += cmd.str();
+
+    if (request.size() > MAX_REQUEST_SIZE)
+    {
+        std::runtime_error e("command is too long for fork server");
+        throw e;
+    }
+
+    send_message(s_socket_fd, request.data(), request.size());
+
+    // Pipe file descriptors are sent in the order write end, read end
+    int pipe_fds[2];
+    pid_t pid = receive_spawn_reply(s_socket_fd, pipe_fds);
+
+    if (pid <= 0)
+    {
+        std::string error_msg("exec of ");
+        error_msg += cmd.str();
+        error_msg += " failed";
+        std::runtime_error e(error_msg);
+        throw e;
+    }
+
+    return std::make_tuple(pid, pipe_fds[0], pipe_fds[1]);
+}
+
+pid_t fork_server_waitpid(pid_t pid, int *status, int options)
+{
+    char request[1 + sizeof(WaitRequest)];
+    request[0] = WAIT_REQUEST;
+    WaitRequest wait_request = {pid, options};
+    memcpy(request + 1, &wait_request, sizeof(wait_request));
+
+    send_message(s_socket_fd, request, sizeof(request));
+
+    WaitReply reply;
+    if (recv(s_socket_fd, &reply, sizeof(reply), 0) !=
+            static_cast<ssize_t>(sizeof(reply)))
+    {
+        std::runtime_error e("recv from fork server socket failed");
+        throw e;
+    }
+
+    *status = reply.status;
+    errno = reply.error;
+
+    return reply.retval;
+}
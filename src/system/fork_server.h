@@ -0,0 +1,67 @@
+#ifndef FORK_SERVER_H
+#define FORK_SERVER_H
+
+#include <tuple>
+
+#include <unistd.h>
+
+#include "core/Command.h"
+
+/** @file fork_server.h
+ *
+ * Functions for launching child processes through a fork server.
+ *
+ * Launching a child process directly from an MPI process can be slow when the
+ * MPI process has a large resident set, and some MPI transports do not
+ * tolerate it at all.  A fork server is a small helper process that is forked
+ * before MPI is initialized.  Once it is running, system_call() and its
+ * variants ask the fork server to launch child processes over a Unix socket.
+ * The fork server returns the process id and the pipes of the child process,
+ * the latter as file descriptors passed with `SCM_RIGHTS`.
+ *
+ * Since the child processes are children of the fork server, waiting on them
+ * is also delegated to the fork server (see fork_server_waitpid()).  Signals
+ * can be sent to them directly.
+ */
+
+/** Start fork server.
+ *
+ * This function must be called before MPI is initialized and before any
+ * threads are started.  The fork server exits when the calling process exits.
+ */
+void start_fork_server();
+
+/** Stop fork server.
+ *
+ * The socket to the fork server is closed, which makes the fork server exit,
+ * and the fork server is waited on.  Does nothing if the fork server is not
+ * running.
+ */
+void stop_fork_server();
+
+/** @return whether a fork server has been started by this process. */
+bool fork_server_running();
+
+/** Launch child process through fork server.
+ *
+ * @param cmd  command to launch.
+ *
+ * @return tuple of process id of child process, write end of pipe to its
+ * standard input and read end of pipe from its standard output.
+ */
+std::tuple<pid_t, int, int> fork_server_spawn(const Command& cmd);
+
+/** Wait on child process of fork server.
+ *
+ * The semantics are those of `waitpid()`, including setting `errno` if -1 is
+ * returned.
+ *
+ * @param pid  process id of child process.
+ * @param status  pointer to exit status of child process.
+ * @param options  options to `waitpid()`.
+ *
+ * @return return value of `waitpid()` in the fork server.
+ */
+pid_t fork_server_waitpid(pid_t pid, int *status, int options);
+
+#endif // FORK_SERVER_H
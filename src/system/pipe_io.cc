@@ -1,15 +1,54 @@
 #include <string>
 #include <stdexcept>
+#include <cstddef>
 #include <unistd.h>
 #include <poll.h>
+#include <fcntl.h>
 #include <errno.h>
+#include <limits.h>
 
 #include "pipe_io.h"
 
 const int READ_END = 0;
 const int WRITE_END = 1;
 
-const int BUFFER_SIZE = 256;
+// Size of buffer for reading from pipes.  Reads go through a single static
+// buffer, so that no memory is allocated per read and large outputs are read
+// in few system calls
+const std::size_t BUFFER_SIZE = 1 << 16;
+
+static char s_read_buffer[BUFFER_SIZE];
+
+// Read once from pipe and append to output, retrying if interrupted.  Return
+// number of bytes read, or -1 if a non-blocking pipe has been drained
+static ssize_t read_once(const int pipe_read_fd, std::string& output)
+{
+    ssize_t count;
+    do
+    {
+        count = read(pipe_read_fd, s_read_buffer, BUFFER_SIZE);
+    } while (count == -1 && errno == EINTR);
+
+    if (count > 0)
+        output.append(s_read_buffer, count);
+    else if (count == -1 && errno != EAGAIN && errno != EWOULDBLOCK)
+    {
+        std::runtime_error e("read from pipe failed");
+        throw e;
+    }
+
+    return count;
+}
+
+// Close pipe, throwing on failure
+static void close_pipe(const int fd)
+{
+    if (close(fd) == -1)
+    {
+        std::runtime_error e("close failed");
+        throw e;
+    }
+}
 
 void read_from_pipe(const int pipefd[], std::string& output)
 {
@@ -18,19 +57,22 @@ void read_from_pipe(const int pipefd[], std::string& output)
 
 void read_from_pipe(const int pipe_read_fd, std::string& output)
 {
-    ssize_t count;
-    char buffer[BUFFER_SIZE];
-
     output.clear();
-    while ( (count = read(pipe_read_fd, buffer, BUFFER_SIZE)) > 0 )
-        output.append(buffer, count);
 
-    if (count == -1)
+    // Read until end of file.  If the pipe is non-blocking, wait for more
+    // data whenever it has been drained
+    ssize_t count;
+    while ( (count = read_once(pipe_read_fd, output)) != 0 )
     {
-        perror("read failed");
-        throw;
+        if (count == -1)
+        {
+            struct pollfd fds;
+            fds.fd = pipe_read_fd;
+            fds.events = POLLIN;
+            fds.revents = 0;
+            check_poll(&fds, 1, -1);
+        }
     }
-
 }
 
 void check_poll(struct pollfd *fds, nfds_t nfds, int timeout)
@@ -58,10 +100,7 @@ bool poll_read_from_pipe(const int pipe_read_fd, std::string& output)
     struct pollfd fds;
     fds.fd = pipe_read_fd;
     fds.events = POLLIN;
-
-    // Initialize buffers and output
-    ssize_t count;
-    char buffer[BUFFER_SIZE];
+    fds.revents = 0;
 
     // Poll
     check_poll(&fds, 1, 0);
@@ -69,22 +108,19 @@ bool poll_read_from_pipe(const int pipe_read_fd, std::string& output)
     // Check if data is available or pipe was closed
     if ((fds.revents & POLLIN) || (fds.revents & POLLHUP))
     {
-
-        // Even if pipe was closed, there may still be data to read
-        while ((count = read(pipe_read_fd, buffer, BUFFER_SIZE)) > 0)
+        // A read that does not fill the buffer has drained the pipe, so
+        // another read would only return EAGAIN.  If the pipe was closed,
+        // keep reading until end of file, since there may still be data
+        ssize_t count;
+        while ((count = read_once(pipe_read_fd, output)) > 0)
         {
-
-            if (count == -1)
-            {
-                perror("read failed");
-                throw;
-            }
-
-            output.append(buffer, count);
+            if (    (static_cast<std::size_t>(count) < BUFFER_SIZE) &&
+                    !(fds.revents & POLLHUP) )
+                break;
         }
 
         // If pipe was closed, return true
-        if (fds.revents & POLLHUP) return true;
+        if (count == 0) return true;
     }
 
     // Pipe was not closed so return false
@@ -98,15 +134,139 @@ void write_to_pipe(const int pipefd[], const std::string& input)
 
 void write_to_pipe(const int pipe_write_fd, const std::string& input)
 {
-    ssize_t write_status = write(pipe_write_fd, input.data(), input.size());
+    // Write may be split into several partial writes.  If the pipe is
+    // non-blocking, wait until it can accept more data
+    std::size_t offset = 0;
+    while (!poll_write_to_pipe(pipe_write_fd, input, offset))
+    {
+        struct pollfd fds;
+        fds.fd = pipe_write_fd;
+        fds.events = POLLOUT;
+        fds.revents = 0;
+        check_poll(&fds, 1, -1);
+    }
+}
 
-    if (write_status == -1)
+/*
+ * Write input from offset onwards, advancing offset past the bytes that were
+ * written.  If the pipe is non-blocking, stop as soon as it is full.  If the
+ * whole input has been written, return true, else false
+ */
+bool poll_write_to_pipe(const int pipe_write_fd, const std::string& input,
+        std::size_t& offset)
+{
+    while (offset < input.size())
     {
-        std::runtime_error e("write to pipe failed");
-        throw e;
-    } else if ( write_status < input.size() )
+        ssize_t count = write(pipe_write_fd, input.data() + offset,
+                input.size() - offset);
+
+        if (count == -1)
+        {
+            if (errno == EINTR)
+                continue;
+
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                return false;
+
+            std::runtime_error e("write to pipe failed");
+            throw e;
+        }
+
+        offset += count;
+    }
+
+    return true;
+}
+
+/*
+ * Write input to write pipe and close it, while reading output from read pipe
+ * until end of file.  Writing and reading are interleaved, so that a child
+ * process that writes output before it has read all of its input cannot
+ * deadlock with the caller
+ */
+void write_read_pipes(const int pipe_write_fd, const std::string& input,
+        const int pipe_read_fd, std::string& output)
+{
+    output.clear();
+
+    // An input that fits into the pipe is written in a single atomic write
+    // that never blocks, so it need not be interleaved with reading
+    if (input.size() <= PIPE_BUF)
+    {
+        write_to_pipe(pipe_write_fd, input);
+        close_pipe(pipe_write_fd);
+        read_from_pipe(pipe_read_fd, output);
+        return;
+    }
+
+    enlarge_pipe(pipe_write_fd, input.size());
+    set_non_blocking(pipe_write_fd);
+    set_non_blocking(pipe_read_fd);
+
+    std::size_t offset = 0;
+    bool write_done = false;
+    while (true)
     {
-        std::runtime_error e("failed to finish write to pipe");
+        if (!write_done && poll_write_to_pipe(pipe_write_fd, input, offset))
+        {
+            close_pipe(pipe_write_fd);
+            write_done = true;
+        }
+
+        if (poll_read_from_pipe(pipe_read_fd, output))
+            break;
+
+        // Sleep until either pipe is ready.  poll() ignores negative file
+        // descriptors
+        struct pollfd fds[2];
+        fds[0].fd = pipe_read_fd;
+        fds[0].events = POLLIN;
+        fds[0].revents = 0;
+        fds[1].fd = write_done ? -1 : pipe_write_fd;
+        fds[1].events = POLLOUT;
+        fds[1].revents = 0;
+        check_poll(fds, 2, -1);
+    }
+
+    // If the child process exits without reading all of its input, the
+    // write pipe is still open
+    if (!write_done)
+        close_pipe(pipe_write_fd);
+}
+
+void set_non_blocking(const int fd)
+{
+    int flags = fcntl(fd, F_GETFL);
+
+    if ( (flags == -1) || (fcntl(fd, F_SETFL, flags | O_NONBLOCK) == -1) )
+    {
+        std::runtime_error e("fcntl on pipe failed");
         throw e;
     }
 }
+
+/*
+ * Try to enlarge pipe so that it can hold size bytes, up to one megabyte.
+ * This is a hint only: F_SETPIPE_SZ is specific to Linux, and the kernel
+ * refuses sizes beyond /proc/sys/fs/pipe-max-size for unprivileged users, in
+ * which case the pipe keeps its size
+ */
+void enlarge_pipe(const int fd, std::size_t size)
+{
+#ifdef F_SETPIPE_SZ
+    const std::size_t max_size = 1 << 20;
+    if (size > max_size)
+        size = max_size;
+
+    // Never shrink the pipe
+    int current_size = fcntl(fd, F_GETPIPE_SZ);
+    if ( (current_size == -1) ||
+            (size <= static_cast<std::size_t>(current_size)) )
+        return;
+
+    fcntl(fd, F_SETPIPE_SZ, static_cast<int>(size));
+#else
+    (void) fd;
+    (void) size;
+#endif
+}
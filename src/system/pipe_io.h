@@ -2,6 +2,7 @@
 #define PIPE_IO_H
 
 #include <string>
+#include <cstddef>
 #include <poll.h>
 
 void read_from_pipe(const int pipe_read_fd, std::string& output);
@@ -11,5 +12,13 @@ bool poll_read_from_pipe(const int pipe_read_fd, std::string& output);
 
 void write_to_pipe(const int pipe_write_fd, const std::string& input);
 void write_to_pipe(const int pipefd[], const std::string& input);
+bool poll_write_to_pipe(const int pipe_write_fd, const std::string& input,
+        std::size_t& offset);
+
+void write_read_pipes(const int pipe_write_fd, const std::string& input,
+        const int pipe_read_fd, std::string& output);
+
+void set_non_blocking(const int fd);
+void enlarge_pipe(const int fd, std::size_t size);
 
 #endif // PIPE_IO_H
@@ -0,0 +1,159 @@
+#include <string>
+#include <map>
+#include <vector>
+#include <utility>
+#include <future>
+#include <chrono>
+#include <algorithm>
+#include <stdexcept>
+
+#include <stdlib.h>
+#include <dlfcn.h>
+
+#include "spdlog/spdlog.h"
+
+#include "pakman_plugin.h"
+
+#include "plugin.h"
+
+// Loaded plugin functions by path.  Plugins are never unloaded
+static std::map<std::string, pakman_plugin_function_t> s_plugin_functions;
+
+// Abandoned plugin calls that may still be running.  Destroying a future
+// returned by std::async() joins its thread, so the program waits for them
+// when it exits
+static std::vector<std::future<std::pair<std::string, int>>>
+    s_abandoned_calls;
+
+// Load plugin function, loading plugin if necessary
+static pakman_plugin_function_t load_plugin_function(const std::string& path)
+{
+    // Return plugin function if already loaded
+    auto it = s_plugin_functions.find(path);
+    if (it != s_plugin_functions.end())
+        return it->second;
+
+    // Load plugin
+    void *handle = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (!handle)
+    {
+        std::string error_msg;
+        error_msg += "could not load plugin ";
+        error_msg += path;
+        error_msg += ": ";
+        error_msg += dlerror();
+        throw std::runtime_error(error_msg);
+    }
+
+    // Look up plugin function
+    dlerror();
+    void *symbol = dlsym(handle, PAKMAN_PLUGIN_FUNCTION);
+    if (!symbol)
+    {
+        std::string error_msg;
+        error_msg += "plugin ";
+        error_msg += path;
+        error_msg += " does not define " PAKMAN_PLUGIN_FUNCTION;
+        dlclose(handle);
+        throw std::runtime_error(error_msg);
+    }
+
+    spdlog::debug("loaded plugin {}", path);
+
+    auto plugin_function = reinterpret_cast<pakman_plugin_function_t>(symbol);
+    s_plugin_functions[path] = plugin_function;
+
+    return plugin_function;
+}
+
+bool is_plugin(const Command& cmd)
+{
+    const std::string suffix(".so");
+    char **argv = cmd.argv();
+
+    if (!argv || !argv[0])
+        return false;
+
+    const std::string path(argv[0]);
+
+    return (path.size() > suffix.size())
+        && (path.compare(path.size() - suffix.size(), suffix.size(), suffix)
+                == 0);
+}
+
+// Run loaded plugin function.  This function does not log, so that it can
+// run on any thread
+static std::pair<std::string, int> run_plugin_function(
+        pakman_plugin_function_t plugin_function, const Command& cmd,
+        const std::string& input)
+{
+    // Count arguments
+    char **argv = cmd.argv();
+    int argc = 0;
+    while (argv[argc]) argc++;
+
+    // Call plugin
+    char *output_cstr = nullptr;
+    int error_code = plugin_function(argc, argv, input.c_str(), &output_cstr);
+
+    // Copy and free output
+    std::string output;
+    if (output_cstr)
+    {
+        output = output_cstr;
+        free(output_cstr);
+    }
+
+    return std::make_pair(std::move(output), error_code);
+}
+
+std::pair<std::string, int> plugin_call(const Command& cmd,
+        const std::string& input)
+{
+    spdlog::debug("plugin: {}", cmd.str());
+    spdlog::debug("input: {}", input);
+
+    // Get plugin function and call it
+    pakman_plugin_function_t plugin_function =
+        load_plugin_function(cmd.argv()[0]);
+    std::pair<std::string, int> output_error =
+        run_plugin_function(plugin_function, cmd, input);
+
+    spdlog::debug("output: {}", output_error.first);
+
+    return output_error;
+}
+
+std::future<std::pair<std::string, int>> plugin_call_async(
+        const Command& cmd, const std::string& input)
+{
+    spdlog::debug("plugin: {}", cmd.str());
+    spdlog::debug("input: {}", input);
+
+    // Load plugin on this thread, since the table of plugins is not shared
+    // between threads
+    pakman_plugin_function_t plugin_function =
+        load_plugin_function(cmd.argv()[0]);
+
+    // Join abandoned calls that have finished
+    s_abandoned_calls.erase(std::remove_if(s_abandoned_calls.begin(),
+                s_abandoned_calls.end(),
+                [](const std::future<std::pair<std::string, int>>& call)
+                {
+                    return call.wait_for(std::chrono::seconds(0))
+                        == std::future_status::ready;
+                }), s_abandoned_calls.end());
+
+    // The thread keeps its own copies of the command and input string
+    return std::async(std::launch::async,
+            [plugin_function, cmd, input]()
+            {
+                return run_plugin_function(plugin_function, cmd, input);
+            });
+}
+
+void abandon_plugin_call(std::future<std::pair<std::string, int>> call)
+{
+    if (call.valid())
+        s_abandoned_calls.push_back(std::move(call));
+}
@@ -0,0 +1,62 @@
+#ifndef PLUGIN_H
+#define PLUGIN_H
+
+#include <string>
+#include <utility>
+#include <future>
+
+#include "core/Command.h"
+
+/** @file plugin.h
+ *
+ * Functions for calling user programs that are supplied as plugins (see
+ * pakman_plugin.h) instead of executables.
+ */
+
+/** Check whether command refers to a plugin.
+ *
+ * @param cmd  command to check.
+ *
+ * @return whether the first token of the command ends in `.so`.
+ */
+bool is_plugin(const Command& cmd);
+
+/** Call plugin with input string.
+ *
+ * The plugin is loaded with `dlopen()` the first time it is called and stays
+ * loaded until the program exits.
+ *
+ * @param cmd  plugin command.
+ * @param input  input string to plugin.
+ *
+ * @return pair of output string and error code of plugin.
+ */
+std::pair<std::string, int> plugin_call(const Command& cmd,
+        const std::string& input);
+
+/** Call plugin with input string on a separate thread.
+ *
+ * The plugin is loaded on the calling thread, and only the plugin function
+ * itself runs on the new thread, so that event loops can go on while the
+ * plugin runs.  Several calls may run at the same time, so the plugin must be
+ * thread-safe.
+ *
+ * @param cmd  plugin command.
+ * @param input  input string to plugin.
+ *
+ * @return future of pair of output string and error code of plugin.
+ */
+std::future<std::pair<std::string, int>> plugin_call_async(
+        const Command& cmd, const std::string& input);
+
+/** Abandon plugin call whose result is no longer needed.
+ *
+ * A running plugin cannot be interrupted, so the call is left to finish in
+ * the background, and its thread is joined once it has finished or when the
+ * program exits.
+ *
+ * @param call  future returned by plugin_call_async().
+ */
+void abandon_plugin_call(std::future<std::pair<std::string, int>> call);
+
+#endif // PLUGIN_H
@@ -0,0 +1,134 @@
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <memory>
+#include <algorithm>
+#include <stdexcept>
+
+#include <signal.h>
+#include <sys/wait.h>
+#include <sys/types.h>
+
+#include "core/common.h"
+#include "system_call.h"
+#include "ChildSupervisor.h"
+
+#include "reaper.h"
+
+namespace
+{
+
+// Stages of termination of a child process
+enum stage_t { grace, terminating, killed };
+
+struct Child
+{
+    pid_t pid;
+    Command cmd;
+    stage_t stage;
+    std::chrono::steady_clock::time_point deadline;
+    bool exit_watched;
+};
+
+// Child processes that have not yet been reaped
+std::vector<Child> s_children;
+
+// Supervisor watching the exit of child processes, keyed by process id.  It
+// is created when the first child process is handed over
+std::unique_ptr<ChildSupervisor> s_p_supervisor;
+
+// Process ids of child processes that have exited
+std::vector<int> s_exited;
+
+// Send signal to child process
+void send_signal(const Child& child, int signal)
+{
+    if ( kill(child.pid, signal) )
+    {
+        std::string error_msg("an error occurred while trying to ");
+        error_msg += signal == SIGKILL ? "kill" : "terminate";
+        error_msg += " child process ";
+        error_msg += child.cmd.str();
+        throw std::runtime_error(error_msg);
+    }
+}
+
+// Advance termination of child process, return whether it has been reaped
+bool advance(Child& child, std::chrono::steady_clock::time_point now)
+{
+    // If child process has exited, it is reaped.  Its results are being
+    // discarded, so the exit status is ignored.  If its exit is watched, it
+    // is only waited on once the supervisor has reported it
+    bool may_have_exited = !child.exit_watched ||
+        std::binary_search(s_exited.begin(), s_exited.end(), child.pid);
+
+    if (    may_have_exited &&
+            waitpid_success(child.pid, WNOHANG, child.cmd, ignore_error) )
+    {
+        if (child.exit_watched)
+            s_p_supervisor->unwatch(child.pid);
+        return true;
+    }
+
+    // Escalate if deadline has passed
+    if ((child.stage == killed) || (now < child.deadline))
+        return false;
+
+    if (child.stage == grace)
+    {
+        send_signal(child, SIGTERM);
+        child.stage = terminating;
+        child.deadline = now + g_kill_timeout;
+    }
+    else
+    {
+        send_signal(child, SIGKILL);
+        child.stage = killed;
+    }
+
+    return false;
+}
+
+}
+
+void terminate_child_async(pid_t pid, const Command& cmd, bool sigterm_sent)
+{
+    if (!s_p_supervisor)
+        s_p_supervisor.reset(new ChildSupervisor);
+
+    bool exit_watched = s_p_supervisor->watchExit(pid, pid);
+
+    s_children.push_back({pid, cmd, sigterm_sent ? terminating : grace,
+            std::chrono::steady_clock::now() + g_kill_timeout,
+            exit_watched});
+}
+
+int reap_children()
+{
+    if (s_children.empty())
+        return 0;
+
+    // Collect child processes that have exited, so that only these are
+    // waited on
+    s_exited.clear();
+    s_p_supervisor->wait(0, s_exited);
+
+    auto now = std::chrono::steady_clock::now();
+
+    for (auto it = s_children.begin(); it != s_children.end(); )
+    {
+        if (advance(*it, now))
+            it = s_children.erase(it);
+        else
+            it++;
+    }
+
+    return s_children.size();
+}
+
+void reap_children_blocking()
+{
+    while (reap_children() > 0)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+}
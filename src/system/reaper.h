@@ -0,0 +1,47 @@
+#ifndef REAPER_H
+#define REAPER_H
+
+#include <unistd.h>
+
+#include "core/Command.h"
+
+/** @file reaper.h
+ *
+ * Functions for terminating child processes without blocking the event loop.
+ *
+ * A child process that is handed over to the reaper is escalated in the
+ * background: if it does not exit within g_kill_timeout of being sent
+ * `SIGTERM`, it is sent `SIGKILL`.  The escalation is advanced by calling
+ * reap_children() from the event loop, so that Managers and Masters can
+ * accept new work while earlier Workers are still shutting down.
+ *
+ * The exit of child processes is watched with a ChildSupervisor, so that
+ * reap_children() only waits on child processes that have exited.
+ */
+
+/** Hand child process over to the reaper.
+ *
+ * If sigterm_sent is false, the child process is given g_kill_timeout to exit
+ * of its own accord before it is sent `SIGTERM`.  The exit status of the child
+ * process is discarded.
+ *
+ * @param pid  process id of child process.
+ * @param cmd  command that started the child process, used in error
+ * messages.
+ * @param sigterm_sent  whether `SIGTERM` has already been sent to the child
+ * process.
+ */
+void terminate_child_async(pid_t pid, const Command& cmd, bool sigterm_sent);
+
+/** Reap child processes that have exited and send signals to child processes
+ * whose deadline has passed.  This function never blocks.
+ *
+ * @return number of child processes that have not yet been reaped.
+ */
+int reap_children();
+
+/** Block until all child processes handed over to the reaper have been
+ * reaped. */
+void reap_children_blocking();
+
+#endif // REAPER_H
@@ -5,28 +5,42 @@
 #include <tuple>
 
 #include <unistd.h>
+#include <spawn.h>
 #include <sys/wait.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <stdio.h>
+#include <errno.h>
 
 #include "spdlog/spdlog.h"
 
 #include "core/common.h"
 #include "core/utils.h"
 #include "pipe_io.h"
+#include "plugin.h"
+#include "fork_server.h"
 #include "system_call.h"
 
 const int READ_END = 0;
 const int WRITE_END = 1;
 
+// Wait on child, delegating to fork server if it is running, since child
+// processes are then children of the fork server
+static pid_t wait_child(pid_t pid, int *status, int options)
+{
+    if (fork_server_running())
+        return fork_server_waitpid(pid, status, options);
+
+    return waitpid(pid, status, options);
+}
+
 bool waitpid_success(pid_t pid, int options, const Command& cmd,
                      child_err_opt_t child_err_opt)
 {
     // Wait on child
     int status;
-    pid_t retval = waitpid(pid, &status, options);
+    pid_t retval = wait_child(pid, &status, options);
 
     // Check exit status of retval
     if (retval == 0) // No state change with WNOHANG
@@ -70,7 +84,7 @@ bool waitpid_success(pid_t pid, int& error_code, int options,
 {
     // Wait on child
     int status;
-    pid_t retval = waitpid(pid, &status, options);
+    pid_t retval = wait_child(pid, &status, options);
 
     // Check exit status of retval
     if (retval == 0) // No state change with WNOHANG
@@ -125,9 +139,26 @@ void close_check(int fd)
     }
 }
 
-std::string system_call(const Command& cmd)
+// Call plugin and throw error if it returns a nonzero error code
+static std::string plugin_call_success(const Command& cmd,
+        const std::string& input)
+{
+    std::pair<std::string, int> output_error = plugin_call(cmd, input);
+
+    if (output_error.second != 0)
+    {
+        std::string error_msg(cmd.str());
+        error_msg += " threw an error";
+        std::runtime_error e(error_msg);
+        throw e;
+    }
+
+    return std::move(output_error.first);
+}
+
+// Check if cmd is executable
+static void check_executable(const Command& cmd)
 {
-    // Check if cmd is executable
     if (!cmd.isExecutable())
     {
         std::string error_msg;
@@ -137,74 +168,74 @@ std::string system_call(const Command& cmd)
         perror(error_msg.c_str());
         throw;
     }
+}
 
-    spdlog::debug("cmd: {}", cmd.str());
-
-    // Initialize output
-    std::string output;
-
-    // Create pipe
-    int pipefd[2];
-
-    if (pipe(pipefd) == -1)
+// Create pipe whose ends are closed on exec, so that child processes only
+// inherit the pipe ends that are explicitly redirected to their standard
+// input and output
+static void make_pipe(int pipefd[2])
+{
+    if (    (pipe(pipefd) == -1) ||
+            (fcntl(pipefd[READ_END], F_SETFD, FD_CLOEXEC) == -1) ||
+            (fcntl(pipefd[WRITE_END], F_SETFD, FD_CLOEXEC) == -1) )
     {
         std::runtime_error e("pipe failed");
         throw e;
     }
+}
 
-    // Fork
-    pid_t child_pid = fork();
+// Spawn child process running cmd with its standard input and output
+// redirected to stdin_fd and stdout_fd.  If stdin_fd is -1, the standard
+// input of the child process is redirected from /dev/null.  The child
+// process is started with posix_spawn() rather than fork(), so that the
+// address space of the parent, which may be large in an MPI process, is not
+// copied
+static pid_t spawn_child(const Command& cmd, int stdin_fd, int stdout_fd)
+{
+    // Set up redirections of child process
+    posix_spawn_file_actions_t file_actions;
+    posix_spawn_file_actions_init(&file_actions);
+
+    if (stdin_fd == -1)
+        posix_spawn_file_actions_addopen(&file_actions, STDIN_FILENO,
+                "/dev/null", O_RDONLY, 0);
+    else
+        posix_spawn_file_actions_adddup2(&file_actions, stdin_fd,
+                STDIN_FILENO);
+
+    posix_spawn_file_actions_adddup2(&file_actions, stdout_fd,
+            STDOUT_FILENO);
+
+    // Suppress stderr of child process
+    if (g_discard_child_stderr)
+        posix_spawn_file_actions_addopen(&file_actions, STDERR_FILENO,
+                "/dev/null", O_WRONLY, 0);
+
+    // Spawn child process, using the executable path cached by cmd
+    const std::string& path = cmd.executablePath();
+    pid_t child_pid;
+    int retval = posix_spawn(&child_pid, path.c_str(), &file_actions,
+            nullptr, cmd.argv(), environ);
 
-    if (child_pid == -1)
+    // Like execvp(), run executables that the kernel does not recognize,
+    // such as scripts without a shebang, with /bin/sh
+    if (retval == ENOEXEC)
     {
-        std::runtime_error e("fork failed");
-        throw e;
+        std::vector<char*> sh_argv;
+        sh_argv.push_back(const_cast<char*>("/bin/sh"));
+        sh_argv.push_back(const_cast<char*>(path.c_str()));
+        for (char **arg = cmd.argv() + 1; *arg != nullptr; arg++)
+            sh_argv.push_back(*arg);
+        sh_argv.push_back(nullptr);
+
+        retval = posix_spawn(&child_pid, "/bin/sh", &file_actions, nullptr,
+                sh_argv.data(), environ);
     }
 
-    if (child_pid > 0) // I am the parent
-    {
-
-        // Close write end of pipe
-        close_check(pipefd[WRITE_END]);
-
-        // Read from pipe and save in output
-        read_from_pipe(pipefd, output);
-
-        // Close read end of pipe
-        close_check(pipefd[READ_END]);
+    posix_spawn_file_actions_destroy(&file_actions);
 
-        // Wait on child
-        waitpid_success(child_pid, 0, cmd);
-
-    }
-    else // I am the child
+    if (retval != 0)
     {
-
-        // Supress stdin of child process
-        int devnull = open("/dev/null", O_RDONLY);
-        dup2_check(devnull, STDIN_FILENO);
-        close_check(devnull);
-
-        // Close read end of pipe and redirect stdout to write end
-        close_check(pipefd[READ_END]);
-        dup2_check(pipefd[WRITE_END], 1);
-        close_check(pipefd[WRITE_END]);
-
-        // Suppress stderr of child process
-        if (g_discard_child_stderr)
-        {
-            int devnull = open("/dev/null", O_WRONLY);
-            dup2_check(devnull, STDERR_FILENO);
-            close_check(devnull);
-        }
-
-        // Get argv from command
-        char **argv = cmd.argv();
-
-        // Execute command
-        execvp(argv[0], argv);
-
-        // If program reaches this, command execution has failed
         std::string error_msg("exec of ");
         error_msg += cmd.str();
         error_msg += " failed";
@@ -212,103 +243,111 @@ std::string system_call(const Command& cmd)
         throw e;
     }
 
-    spdlog::debug("output: {}", output);
+    return child_pid;
+}
 
-    return output;
+// Spawn child process running cmd with pipes for its standard input and
+// output, return child pid, write end of send pipe and read end of receive
+// pipe
+static std::tuple<pid_t, int, int> spawn_child_with_pipes(const Command& cmd)
+{
+    // Delegate to fork server if it is running
+    if (fork_server_running())
+        return fork_server_spawn(cmd);
+
+    // Create pipes for sending and receiving
+    int send_pipefd[2], recv_pipefd[2];
+    make_pipe(send_pipefd);
+    make_pipe(recv_pipefd);
+
+    // Spawn child process
+    pid_t child_pid = spawn_child(cmd, send_pipefd[READ_END],
+            recv_pipefd[WRITE_END]);
+
+    // Close read end of send pipe and write end of receive pipe
+    close_check(send_pipefd[READ_END]);
+    close_check(recv_pipefd[WRITE_END]);
+
+    return std::make_tuple(child_pid, send_pipefd[WRITE_END],
+            recv_pipefd[READ_END]);
 }
 
-std::string system_call(const Command& cmd, const std::string& input)
+std::string system_call(const Command& cmd)
 {
+    // Call plugin in-process if cmd refers to one
+    if (is_plugin(cmd))
+        return plugin_call_success(cmd, std::string());
+
     // Check if cmd is executable
-    if (!cmd.isExecutable())
-    {
-        std::string error_msg;
-        error_msg += "cannot access '";
-        error_msg += cmd.argv()[0];
-        error_msg += "'";
-        perror(error_msg.c_str());
-        throw;
-    }
+    check_executable(cmd);
 
     spdlog::debug("cmd: {}", cmd.str());
-    spdlog::debug("input: {}", input);
 
     // Initialize output
     std::string output;
 
-    // Create pipes for sending and receiving
-    int send_pipefd[2], recv_pipefd[2];
+    // Spawn child process with suppressed stdin.  The fork server always
+    // creates a pipe for stdin, which is closed immediately instead
+    pid_t child_pid;
+    int pipe_read_fd;
 
-    if ( (pipe(send_pipefd) == -1) || (pipe(recv_pipefd) == -1) )
+    if (fork_server_running())
     {
-        std::runtime_error e("pipe failed");
-        throw e;
+        int pipe_write_fd;
+        std::tie(child_pid, pipe_write_fd, pipe_read_fd) =
+            fork_server_spawn(cmd);
+        close_check(pipe_write_fd);
     }
-
-    // Fork
-    pid_t child_pid = fork();
-
-    if (child_pid == -1)
+    else
     {
-        std::runtime_error e("fork failed");
-        throw e;
+        int pipefd[2];
+        make_pipe(pipefd);
+        child_pid = spawn_child(cmd, -1, pipefd[WRITE_END]);
+        close_check(pipefd[WRITE_END]);
+        pipe_read_fd = pipefd[READ_END];
     }
 
-    if (child_pid > 0) // I am the parent
-    {
+    // Read from pipe and save in output
+    read_from_pipe(pipe_read_fd, output);
 
-        // Close read end of send pipe and write end of receive pipe
-        close_check(send_pipefd[READ_END]);
-        close_check(recv_pipefd[WRITE_END]);
+    // Close read end of pipe
+    close_check(pipe_read_fd);
 
-        // Send input to child
-        write_to_pipe(send_pipefd, input);
-        close_check(send_pipefd[WRITE_END]);
+    // Wait on child
+    waitpid_success(child_pid, 0, cmd);
 
-        // Read output from child
-        read_from_pipe(recv_pipefd, output);
-        close_check(recv_pipefd[READ_END]);
+    spdlog::debug("output: {}", output);
 
-        // Wait on child
-        waitpid_success(child_pid, 0, cmd);
+    return output;
+}
 
-    }
-    else // I am the child
-    {
+std::string system_call(const Command& cmd, const std::string& input)
+{
+    // Call plugin in-process if cmd refers to one
+    if (is_plugin(cmd))
+        return plugin_call_success(cmd, input);
 
-        // Close write end of send pipe and redirect stdin to read end
-        // of send pipe
-        close_check(send_pipefd[WRITE_END]);
-        dup2_check(send_pipefd[READ_END], 0);
-        close_check(send_pipefd[READ_END]);
+    // Check if cmd is executable
+    check_executable(cmd);
 
-        // Close read end of receive pipe and redirect stdout to write end
-        // of receive pipe
-        close_check(recv_pipefd[READ_END]);
-        dup2_check(recv_pipefd[WRITE_END], 1);
-        close_check(recv_pipefd[WRITE_END]);
+    spdlog::debug("cmd: {}", cmd.str());
+    spdlog::debug("input: {}", input);
 
-        // Suppress stderr of child process
-        if (g_discard_child_stderr)
-        {
-            int devnull = open("/dev/null", O_WRONLY);
-            dup2_check(devnull, STDERR_FILENO);
-            close_check(devnull);
-        }
+    // Initialize output
+    std::string output;
 
-        // Get argv from command
-        char **argv = cmd.argv();
+    // Spawn child process
+    pid_t child_pid;
+    int pipe_write_fd, pipe_read_fd;
+    std::tie(child_pid, pipe_write_fd, pipe_read_fd) =
+        spawn_child_with_pipes(cmd);
 
-        // Execute command
-        execvp(argv[0], argv);
+    // Send input to child while reading its output
+    write_read_pipes(pipe_write_fd, input, pipe_read_fd, output);
+    close_check(pipe_read_fd);
 
-        // If program reaches this, command execution has failed
-        std::string error_msg("exec of ");
-        error_msg += cmd.str();
-        error_msg += " failed";
-        std::runtime_error e(error_msg);
-        throw e;
-    }
+    // Wait on child
+    waitpid_success(child_pid, 0, cmd);
 
     spdlog::debug("output: {}", output);
 
@@ -318,16 +357,12 @@ std::string system_call(const Command& cmd, const std::string& input)
 std::pair<std::string, int> system_call_error_code(const Command& cmd,
                  const std::string& input)
 {
+    // Call plugin in-process if cmd refers to one
+    if (is_plugin(cmd))
+        return plugin_call(cmd, input);
+
     // Check if cmd is executable
-    if (!cmd.isExecutable())
-    {
-        std::string error_msg;
-        error_msg += "cannot access '";
-        error_msg += cmd.argv()[0];
-        error_msg += "'";
-        perror(error_msg.c_str());
-        throw;
-    }
+    check_executable(cmd);
 
     spdlog::debug("cmd: {}", cmd.str());
     spdlog::debug("input: {}", input);
@@ -336,79 +371,18 @@ std::pair<std::string, int> system_call_error_code(const Command& cmd,
     std::string output;
     int error_code;
 
-    // Create pipes for sending and receiving
-    int send_pipefd[2], recv_pipefd[2];
-
-    if ( (pipe(send_pipefd) == -1) || (pipe(recv_pipefd) == -1) )
-    {
-        std::runtime_error e("pipe failed");
-        throw e;
-    }
-
-    // Fork
-    pid_t child_pid = fork();
-
-    if (child_pid == -1)
-    {
-        std::runtime_error e("fork failed");
-        throw e;
-    }
-
-    if (child_pid > 0) // I am the parent
-    {
-
-        // Close read end of send pipe and write end of receive pipe
-        close_check(send_pipefd[READ_END]);
-        close_check(recv_pipefd[WRITE_END]);
-
-        // Send input to child
-        write_to_pipe(send_pipefd, input);
-        close_check(send_pipefd[WRITE_END]);
-
-        // Read output from child
-        read_from_pipe(recv_pipefd, output);
-        close_check(recv_pipefd[READ_END]);
-
-        // Wait on child
-        waitpid_success(child_pid, error_code, 0, cmd);
-
-    }
-    else // I am the child
-    {
-
-        // Close write end of send pipe and redirect stdin to read end
-        // of send pipe
-        close_check(send_pipefd[WRITE_END]);
-        dup2_check(send_pipefd[READ_END], 0);
-        close_check(send_pipefd[READ_END]);
-
-        // Close read end of receive pipe and redirect stdout to write end
-        // of receive pipe
-        close_check(recv_pipefd[READ_END]);
-        dup2_check(recv_pipefd[WRITE_END], 1);
-        close_check(recv_pipefd[WRITE_END]);
-
-        // Suppress stderr of child process
-        if (g_discard_child_stderr)
-        {
-            int devnull = open("/dev/null", O_WRONLY);
-            dup2_check(devnull, STDERR_FILENO);
-            close_check(devnull);
-        }
-
-        // Get argv from command
-        char **argv = cmd.argv();
+    // Spawn child process
+    pid_t child_pid;
+    int pipe_write_fd, pipe_read_fd;
+    std::tie(child_pid, pipe_write_fd, pipe_read_fd) =
+        spawn_child_with_pipes(cmd);
 
-        // Execute command
-        execvp(argv[0], argv);
+    // Send input to child while reading its output
+    write_read_pipes(pipe_write_fd, input, pipe_read_fd, output);
+    close_check(pipe_read_fd);
 
-        // If program reaches this, command execution has failed
-        std::string error_msg("exec of ");
-        error_msg += cmd.str();
-        error_msg += " failed";
-        std::runtime_error e(error_msg);
-        throw e;
-    }
+    // Wait on child
+    waitpid_success(child_pid, error_code, 0, cmd);
 
     spdlog::debug("output: {}", output);
 
@@ -419,90 +393,11 @@ std::tuple<pid_t, int, int> system_call_non_blocking_read_write(
         const Command& cmd)
 {
     // Check if cmd is executable
-    if (!cmd.isExecutable())
-    {
-        std::string error_msg;
-        error_msg += "cannot access '";
-        error_msg += cmd.argv()[0];
-        error_msg += "'";
-        perror(error_msg.c_str());
-        throw;
-    }
+    check_executable(cmd);
 
     spdlog::debug("cmd: {}", cmd.str());
 
-    // Initialize child_pid, pipe_read_fd, pipe_write_fd
-    pid_t child_pid;
-    int pipe_read_fd, pipe_write_fd;
-
-    // Create pipes for sending and receiving
-    int send_pipefd[2], recv_pipefd[2];
-
-    if ( (pipe(send_pipefd) == -1) || (pipe(recv_pipefd) == -1) )
-    {
-        std::runtime_error e("pipe failed");
-        throw e;
-    }
-
-    // Fork and record child pid
-    child_pid = fork();
-
-    if (child_pid == -1)
-    {
-        std::runtime_error e("fork failed");
-        throw e;
-    }
-
-    if (child_pid > 0) // I am the parent
-    {
-
-        // Close read end of send pipe and write end of receive pipe
-        close_check(send_pipefd[READ_END]);
-        close_check(recv_pipefd[WRITE_END]);
-
-        // Save write end of send pipe to pipe_write_fd
-        pipe_write_fd = send_pipefd[WRITE_END];
-
-        // Save read end of recv pipe to pipe_read_fd
-        pipe_read_fd = recv_pipefd[READ_END];
-
-    }
-    else // I am the child
-    {
-
-        // Close write end of send pipe and redirect stdin to read end
-        // of send pipe
-        close_check(send_pipefd[WRITE_END]);
-        dup2_check(send_pipefd[READ_END], 0);
-        close_check(send_pipefd[READ_END]);
-
-        // Close read end of receive pipe and redirect stdout to write end
-        // of receive pipe
-        close_check(recv_pipefd[READ_END]);
-        dup2_check(recv_pipefd[WRITE_END], 1);
-        close_check(recv_pipefd[WRITE_END]);
-
-        // Suppress stderr of child process
-        if (g_discard_child_stderr)
-        {
-            int devnull = open("/dev/null", O_WRONLY);
-            dup2_check(devnull, STDERR_FILENO);
-            close_check(devnull);
-        }
-
-        // Get argv from command
-        char **argv = cmd.argv();
-
-        // Execute command
-        execvp(argv[0], argv);
-
-        // If program reaches this, command execution has failed
-        std::string error_msg("exec of ");
-        error_msg += cmd.str();
-        error_msg += " failed";
-        std::runtime_error e(error_msg);
-        throw e;
-    }
-
-    return std::make_tuple(child_pid, pipe_write_fd, pipe_read_fd);
+    // Spawn child process and return child pid, write end of send pipe and
+    // read end of receive pipe
+    return spawn_child_with_pipes(cmd);
 }
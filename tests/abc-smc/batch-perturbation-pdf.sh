@@ -0,0 +1,89 @@
+#!/bin/bash
+set -euo pipefail
+
+# Process arguments
+if [ $# -ne 1 ]
+then
+    echo "Usage: $0 EPSILONS" 1>&2
+    echo "Checks parameters and prints 1 for every perturbed parameter if OK" 1>&2
+    echo "EPSILONS is comma-separated list of epsilon values" 1>&2
+    echo "Throws an error if (parameter + epsilon[t - 1]) is odd" 1>&2
+    exit 1
+fi
+
+epsilon_list="$1"
+
+# Read t
+read t
+
+# Sanity check: t cannot be 0
+if [ "$t" -eq "0" ]
+then
+    echo "t should not be 0" 1>&2
+    exit 1
+fi
+
+# Get previous epsilon (cut uses one-based indexing for fields)
+previous_epsilon=$(echo $epsilon_list | cut -d, -f$t)
+
+# Read perturbed parameters
+read number_perturbed
+perturbed_prmtrs=""
+for ((i = 0; i < number_perturbed; i++))
+do
+    read perturbed_prmtr
+    perturbed_prmtrs="$perturbed_prmtrs $perturbed_prmtr"
+done
+
+# Read and discard weights
+read population_size
+for ((i = 0; i < population_size; i++))
+do
+    read weight
+done
+
+# Check that parameters from previous population are even
+parameters=""
+for ((i = 0; i < population_size; i++))
+do
+    read parameter
+
+    # Add previous epsilon and parameter
+    sum=$((previous_epsilon + parameter))
+
+    # Take mod 2
+    mod=$((sum % 2))
+
+    # If mod is equal to 1, throw error
+    if [ "$mod" -eq "1" ]
+    then
+        echo "Sum of parameter and epsilon is odd" 1>&2
+        exit 1
+    fi
+
+    parameters="$parameters $parameter"
+done
+
+# Check that every perturbed parameter is one of the previous parameters
+# incremented
+for perturbed_prmtr in $perturbed_prmtrs
+do
+    is_valid="false"
+    for parameter in $parameters
+    do
+        if [ "$((parameter+1))" -eq "$perturbed_prmtr" ]
+        then
+            is_valid="true"
+        fi
+    done
+
+    # If invalid, throw error
+    if [ ! "$is_valid" == "true" ]
+    then
+        echo "Perturbed parameter is invalid" 1>&2
+        exit 1
+    fi
+
+    # Print 1
+    echo 1
+done
@@ -0,0 +1,51 @@
+#!/bin/bash
+set -euo pipefail
+
+# Process arguments
+if [ $# -ne 1 ]
+then
+    echo "Usage: $0 TYPE:W1,W2,..." 1>&2
+    echo "Evaluates the perturbation kernel given in the same form as" 1>&2
+    echo "--perturbation-kernel, where TYPE is gaussian or uniform" 1>&2
+    exit 1
+fi
+
+kernel="$1"
+
+# Read t
+read t
+
+# Sanity check: t cannot be 0
+if [ "$t" -eq "0" ]
+then
+    echo "t should not be 0" 1>&2
+    exit 1
+fi
+
+# Read perturbed parameter
+read perturbed_prmtr
+
+# For every parameter of the previous generation, print the product over
+# components of the one-dimensional kernel densities
+awk -v kernel="$kernel" -v perturbed="$perturbed_prmtr" '
+BEGIN {
+    split(kernel, type_widths, ":")
+    type = type_widths[1]
+    dim = split(type_widths[2], widths, ",")
+    split(perturbed, x, " ")
+    pi = atan2(0, -1)
+}
+{
+    density = 1
+    for (d = 1; d <= dim; d++)
+    {
+        diff = x[d] - $d
+        if (type == "gaussian")
+            density *= exp(-diff * diff / (2 * widths[d] * widths[d])) \
+                / (sqrt(2 * pi) * widths[d])
+        else
+            density *= ((diff <= widths[d] && -diff <= widths[d]) ? 1 : 0) \
+                / (2 * widths[d])
+    }
+    printf "%.17g\n", density
+}'
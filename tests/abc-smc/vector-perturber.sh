@@ -0,0 +1,26 @@
+#!/bin/bash
+set -euo pipefail
+
+# Read t
+read t
+
+# Sanity check: t cannot be 0
+if [ "$t" -eq "0" ]
+then
+    echo "t should not be 0" 1>&2
+    exit 1
+fi
+
+# Read parameter
+read parameter
+
+# If there is another line, throw error
+if read dummy
+then
+    echo "$0 accepts only two lines of input"
+    exit 1
+fi
+
+# Shift parameter by (0.1, -0.05), which is within the support of the kernels
+# used in the tests, so that perturbing is deterministic
+echo "$parameter" | awk '{ printf "%.17g %.17g\n", $1 + 0.1, $2 - 0.05 }'
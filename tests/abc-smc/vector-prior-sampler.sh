@@ -0,0 +1,36 @@
+#!/bin/bash
+set -euo pipefail
+
+# Process arguments
+if [ $# -ne 1 ]
+then
+    echo "Usage: $0 NUMBER_FILE" 1>&2
+    echo "Increments number n in NUMBER_FILE and prints two-component" 1>&2
+    echo "parameter (0.37 n mod 2, 0.61 n mod 1.5)" 1>&2
+    exit 1
+fi
+
+number_file="$1"
+
+# If there is any input, throw error
+if read dummy
+then
+    echo "$0 does not accept any input"
+    exit 1
+fi
+
+# Read current number, which is 0 if number_file does not exist
+current_number="0"
+if [ -f "$number_file" ]
+then
+    current_number=$(cat $number_file)
+fi
+
+# Increment current number and record it into number_file
+((current_number++)) || :
+echo $current_number > $number_file
+
+# Print parameter, whose components are spread out so that kernels of finite
+# support cover some but not all other parameters
+awk -v n=$current_number \
+    'BEGIN { printf "%.17g %.17g\n", (0.37 * n) % 2, (0.61 * n) % 1.5 }'
@@ -34,6 +34,28 @@ int my_simulator(int argc, char *argv[],
     output_string.assign("accept\n");
     int error_code = 0;
 
+    // Return early if simulation has been cancelled
+    if (PakmanMPIWorker::shouldCancel())
+        return 0;
+
+    // Check that all processes of the MPI Worker received the same input
+    unsigned long checksum = 0;
+    for (char c : input_string)
+        checksum = 31 * checksum + static_cast<unsigned char>(c);
+
+    unsigned long min_checksum, max_checksum;
+    MPI_Allreduce(&checksum, &min_checksum, 1, MPI_UNSIGNED_LONG, MPI_MIN,
+            PakmanMPIWorker::getWorkerComm());
+    MPI_Allreduce(&checksum, &max_checksum, 1, MPI_UNSIGNED_LONG, MPI_MAX,
+            PakmanMPIWorker::getWorkerComm());
+
+    if (min_checksum != max_checksum)
+    {
+        std::cerr << "Error: processes of MPI Worker received different "
+            "inputs\n";
+        return 3;
+    }
+
     // Print help
     if (argc == 2 &&
             ( std::string(argv[1]).compare("--help") == 0
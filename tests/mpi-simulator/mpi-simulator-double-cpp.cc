@@ -0,0 +1,62 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <mpi.h>
+
+#include "PakmanMPIWorker.hpp"
+
+/** @file mpi-simulator-double-cpp.cc
+ *
+ * This program is a dummy MPI simulator that outputs the array of doubles
+ * {1.5, 0, -2.25} as a binary payload and returns a user-specified error
+ * code, regardless of the input to the simulator.
+ */
+
+/** Run dummy simulation
+ *
+ * @param argc  number of command-line arguments.
+ * @param argv  array containing command-line arguments.
+ * @param input_string  input to simulator
+ * @param output  output from simulator
+ *
+ * @return error code given as second argument (default 0).
+ */
+int my_simulator(int argc, char *argv[],
+        const std::string& input_string, std::vector<double>& output)
+{
+    // Return early if simulation has been cancelled
+    if (PakmanMPIWorker::shouldCancel())
+        return 0;
+
+    // Throw error if more than two arguments are given
+    if (argc > 3)
+    {
+        std::cerr << "Error: too many arguments given. Usage: " << argv[0]
+            << " [IGNORED] [ERROR_CODE]\n";
+        return 2;
+    }
+
+    // The zero element checks that binary output containing null bytes is
+    // not truncated
+    output = {1.5, 0.0, -2.25};
+
+    // Return given error code
+    return (argc >= 3) ? std::stoi(argv[2]) : 0;
+}
+
+int main(int argc, char *argv[])
+{
+    // Initialize MPI
+    MPI_Init(nullptr, nullptr);
+
+    // Create MPI Worker
+    PakmanMPIWorker worker(&my_simulator);
+
+    // Run MPI Worker
+    worker.run(argc, argv);
+
+    // Finalize MPI
+    MPI_Finalize();
+
+    return 0;
+}
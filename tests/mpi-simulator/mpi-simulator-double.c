@@ -0,0 +1,57 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <mpi.h>
+
+#include "pakman_mpi_worker.h"
+
+/* Define my_simulator, which outputs the array {1.5, 0, -2.25, p}, where p is
+ * the number on the last line of the input, and returns the error code given
+ * as second argument (default 0).  The zero element checks that binary output
+ * containing null bytes is not truncated, and p lets callers check which
+ * output belongs to which input */
+int my_simulator(int argc, char *argv[],
+        const char* input_string, double **p_output, int *p_length)
+{
+    /* Return early if simulation has been cancelled */
+    if (pakman_should_cancel())
+        return 0;
+
+    /* Throw error if more than two arguments are given */
+    if (argc > 3)
+    {
+        fprintf(stderr, "Error: too many arguments given. Usage: %s "
+                "[IGNORED] [ERROR_CODE]\n", argv[0]);
+        return 2;
+    }
+
+    /* Find last line of input */
+    const char *last_line = input_string;
+    for (const char *c = input_string; *c != '\0'; c++)
+        if (c[0] == '\n' && c[1] != '\0')
+            last_line = c + 1;
+
+    /* Allocate memory for output array */
+    *p_length = 4;
+    *p_output = (double *) malloc(*p_length * sizeof(double));
+    (*p_output)[0] = 1.5;
+    (*p_output)[1] = 0.0;
+    (*p_output)[2] = -2.25;
+    (*p_output)[3] = atof(last_line);
+
+    /* Return given error code */
+    return (argc >= 3) ? atoi(argv[2]) : 0;
+}
+
+int main(int argc, char *argv[])
+{
+    /* Initialize MPI */
+    MPI_Init(NULL, NULL);
+
+    /* Run MPI Worker */
+    pakman_run_mpi_worker_double(argc, argv, &my_simulator);
+
+    /* Finalize MPI */
+    MPI_Finalize();
+
+    return 0;
+}
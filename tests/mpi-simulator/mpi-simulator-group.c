@@ -0,0 +1,50 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <mpi.h>
+
+#include "pakman_mpi_worker.h"
+
+/* Define my_simulator, which outputs "1" if the MPI Worker consists of the
+ * number of processes given as first argument, and throws an error
+ * otherwise */
+int my_simulator(int argc, char *argv[],
+        const char* input_string, char **p_output_string)
+{
+    /* Throw error if not exactly one argument is given */
+    if (argc != 2)
+    {
+        fprintf(stderr, "Error: wrong number of arguments given. Usage: %s "
+                "NUM_PROCS\n", argv[0]);
+        return 2;
+    }
+
+    *p_output_string = (char *) malloc(3 * sizeof(char));
+    strcpy(*p_output_string, "1\n");
+
+    /* Compare size of MPI Worker with expected size */
+    int size;
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+    if (size != atoi(argv[1]))
+    {
+        fprintf(stderr, "Error: MPI Worker has %d processes, expected %s\n",
+                size, argv[1]);
+        return 1;
+    }
+
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    /* Initialize MPI */
+    MPI_Init(NULL, NULL);
+
+    /* Run MPI Worker */
+    pakman_run_mpi_worker(argc, argv, &my_simulator);
+
+    /* Finalize MPI */
+    MPI_Finalize();
+
+    return 0;
+}
@@ -0,0 +1,81 @@
+#include <iostream>
+#include <string>
+#include <thread>
+#include <chrono>
+#include <mpi.h>
+
+#include "PakmanMPIWorker.hpp"
+
+/** @file mpi-simulator-slow-cpp.cc
+ *
+ * This program is a dummy MPI simulator that outputs "1".  The first
+ * simulation for every epsilon is fast, and any further simulation for the
+ * same epsilon runs for a long time unless it is cancelled.
+ */
+
+/** Run dummy simulation
+ *
+ * The first simulation for every epsilon (the first line of the input) takes
+ * 100 ms, and any further simulation for the same epsilon runs for the number
+ * of 10 ms steps given as first argument (default 6000).  With a population
+ * size of one, the further simulations are always discarded, and since
+ * cancellation is checked at every step, they only return promptly if
+ * cancellation works.
+ *
+ * @param argc  number of command-line arguments.
+ * @param argv  array containing command-line arguments.
+ * @param input_string  input to simulator
+ * @param output_string  output from simulator
+ *
+ * @return error code.
+ */
+int my_simulator(int argc, char *argv[],
+        const std::string& input_string, std::string& output_string)
+{
+    static std::string last_epsilon;
+
+    // Throw error if more than one argument is given
+    if (argc > 2)
+    {
+        std::cerr << "Error: too many arguments given. Usage: " << argv[0]
+            << " [STEPS]\n";
+        return 2;
+    }
+
+    output_string.assign("1\n");
+
+    // Fast simulation, which takes long enough for the next simulation to be
+    // queued
+    std::string epsilon = input_string.substr(0, input_string.find('\n'));
+    if (epsilon != last_epsilon)
+    {
+        last_epsilon = epsilon;
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        return 0;
+    }
+
+    // Slow simulation.  Every process of the MPI Worker runs the same number
+    // of steps, since shouldCancel() is collective
+    long num_steps = (argc >= 2) ? std::stol(argv[1]) : 6000;
+    for (long i = 0; i < num_steps && !PakmanMPIWorker::shouldCancel(); i++)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    // Initialize MPI
+    MPI_Init(nullptr, nullptr);
+
+    // Create MPI Worker
+    PakmanMPIWorker worker(&my_simulator);
+
+    // Run MPI Worker
+    worker.run(argc, argv);
+
+    // Finalize MPI
+    MPI_Finalize();
+
+    return 0;
+}
@@ -0,0 +1,72 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <mpi.h>
+
+#include "pakman_mpi_worker.h"
+
+/* Define my_simulator, which outputs "1".  The first simulation for every
+ * epsilon (the first line of the input) takes 100 ms, and any further
+ * simulation for the same epsilon runs for the number of 10 ms steps given as
+ * first argument (default 6000).  With a population size of one, the further
+ * simulations are always discarded, and since cancellation is checked at
+ * every step, they only return promptly if cancellation works.  Every process
+ * of the MPI Worker runs the same number of steps, since
+ * pakman_should_cancel() is collective */
+int my_simulator(int argc, char *argv[],
+        const char* input_string, char **p_output_string)
+{
+    static char last_epsilon[64] = "";
+
+    /* Throw error if more than one argument is given */
+    if (argc > 2)
+    {
+        fprintf(stderr, "Error: too many arguments given. Usage: %s "
+                "[STEPS]\n", argv[0]);
+        return 2;
+    }
+
+    *p_output_string = (char *) malloc(3 * sizeof(char));
+    strcpy(*p_output_string, "1\n");
+
+    /* Get epsilon */
+    char epsilon[64];
+    size_t len = strcspn(input_string, "\n");
+    if (len >= sizeof(epsilon))
+        len = sizeof(epsilon) - 1;
+    memcpy(epsilon, input_string, len);
+    epsilon[len] = '\0';
+
+    /* Fast simulation, which takes long enough for the next simulation to be
+     * queued */
+    struct timespec step = { 0, 10000000 };
+    if (strcmp(epsilon, last_epsilon) != 0)
+    {
+        strcpy(last_epsilon, epsilon);
+        for (int i = 0; i < 10; i++)
+            nanosleep(&step, NULL);
+        return 0;
+    }
+
+    /* Slow simulation */
+    long num_steps = (argc >= 2) ? atol(argv[1]) : 6000;
+    for (long i = 0; i < num_steps && !pakman_should_cancel(); i++)
+        nanosleep(&step, NULL);
+
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    /* Initialize MPI */
+    MPI_Init(NULL, NULL);
+
+    /* Run MPI Worker */
+    pakman_run_mpi_worker(argc, argv, &my_simulator);
+
+    /* Finalize MPI */
+    MPI_Finalize();
+
+    return 0;
+}
@@ -14,6 +14,32 @@ int my_simulator(int argc, char *argv[],
     char *output_string = "accept\n";
     int error_code = 0;
 
+    /* Return early if simulation has been cancelled */
+    if (pakman_should_cancel())
+    {
+        *p_output_string = calloc(1, sizeof(char));
+        return 0;
+    }
+
+    /* Check that all processes of the MPI Worker received the same input */
+    unsigned long checksum = 0;
+    for (size_t i = 0; input_string[i] != '\0'; i++)
+        checksum = 31 * checksum + (unsigned char) input_string[i];
+
+    unsigned long min_checksum, max_checksum;
+    MPI_Allreduce(&checksum, &min_checksum, 1, MPI_UNSIGNED_LONG, MPI_MIN,
+            pakman_get_worker_comm());
+    MPI_Allreduce(&checksum, &max_checksum, 1, MPI_UNSIGNED_LONG, MPI_MAX,
+            pakman_get_worker_comm());
+
+    if (min_checksum != max_checksum)
+    {
+        fputs("Error: processes of MPI Worker received different inputs\n",
+                stderr);
+        *p_output_string = calloc(1, sizeof(char));
+        return 3;
+    }
+
     /* Print help */
     if (argc == 2 &&
             ( strcmp(argv[1], "--help") == 0
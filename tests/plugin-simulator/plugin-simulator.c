@@ -0,0 +1,38 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "pakman_plugin.h"
+
+int pakman_plugin_run(int argc, char *argv[],
+        const char *input_string, char **p_output_string)
+{
+    /* Default output string and error code correspond to simulator that always
+     * accepts and exits without error */
+    const char *output_string = "1\n";
+    int error_code = 0;
+
+    /* Process given output string */
+    if (argc >= 2)
+        output_string = argv[1];
+
+    /* Process given error code */
+    if (argc >= 3)
+        error_code = atoi(argv[2]);
+
+    /* Throw error if more than two arguments are given */
+    if (argc > 3)
+    {
+        fprintf(stderr, "Error: too many arguments given.\n");
+        return 2;
+    }
+
+    /* Copy output string, adding a newline if it does not terminate on one */
+    size_t len = strlen(output_string);
+    *p_output_string = (char *) malloc((len + 2) * sizeof(char));
+    strcpy(*p_output_string, output_string);
+    if (len == 0 || output_string[len - 1] != '\n')
+        strcat(*p_output_string, "\n");
+
+    return error_code;
+}
@@ -0,0 +1,33 @@
+#!/bin/bash
+set -euo pipefail
+
+# Process arguments
+if [ $# -ne 1 ]
+then
+    echo "Usage: $0 NUM_SIMULATIONS" 1>&2
+    echo "Simulator that accepts once NUM_SIMULATIONS simulations run" 1>&2
+    echo "concurrently in the working directory, and throws an error if" 1>&2
+    echo "they do not within ten seconds" 1>&2
+    exit 1
+fi
+
+num_simulations="$1"
+
+# Register simulation under its parameter
+read parameter
+touch "barrier-$parameter"
+
+# Wait for the other simulations
+for i in $(seq 100)
+do
+    if [ $(ls barrier-* | wc -l) -ge $num_simulations ]
+    then
+        echo 1
+        exit 0
+    fi
+
+    sleep 0.1
+done
+
+echo "Error: simulations did not run concurrently" 1>&2
+exit 1
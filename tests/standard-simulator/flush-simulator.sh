@@ -0,0 +1,22 @@
+#!/bin/bash
+set -euo pipefail
+
+# Simulator that accepts right away if it is the first simulation for its
+# epsilon in the working directory, and runs for a minute otherwise.  With a
+# population size of one, the further simulations are always discarded, so
+# they only return promptly if Pakman terminates them when it flushes its
+# Workers
+
+# Read epsilon and discard rest of standard input
+read epsilon
+cat > /dev/null
+
+# Creating a directory is atomic, so exactly one simulation is the first
+if mkdir "epsilon-$epsilon" 2> /dev/null
+then
+    # Take long enough for the next simulation to be queued
+    sleep 0.1
+    echo 1
+else
+    exec sleep 60
+fi
@@ -0,0 +1,20 @@
+#!/bin/bash
+set -euo pipefail
+
+# Simulator that accepts if it was forked by the fork server, which is itself
+# forked by Pakman, and throws an error otherwise
+
+# Read and discard standard input
+cat > /dev/null
+
+# Get name of grandparent process
+grandparent=$(awk '{ print $4 }' /proc/$PPID/stat)
+grandparent_name=$(cat /proc/$grandparent/comm)
+
+if [ "$grandparent_name" != "pakman" ]
+then
+    echo "Error: grandparent process is $grandparent_name, not pakman" 1>&2
+    exit 1
+fi
+
+echo 1
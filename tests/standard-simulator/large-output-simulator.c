@@ -0,0 +1,48 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+/* Number of characters in output string, which exceeds the eager limit of
+ * common MPI implementations */
+#define OUTPUT_SIZE 300000
+
+int main(int argc, char *argv[])
+{
+    /* Default error code corresponds to simulator that exits without error */
+    int error_code = 0;
+
+    /* Print help */
+    if (argc == 2 &&
+            ( strcmp(argv[1], "--help") == 0
+              || strcmp(argv[1], "-h") == 0 ) )
+    {
+        printf("Usage: %s [IGNORED] [ERROR_CODE]\n", argv[0]);
+        printf("Prints a line of %d characters\n", OUTPUT_SIZE);
+        return 0;
+    }
+
+    /* Process given error code */
+    if (argc >= 3)
+        error_code = atoi(argv[2]);
+
+    /* Throw error if more than two arguments are given */
+    if (argc > 3)
+    {
+        fprintf(stderr, "Error: too many arguments given. Try %s --help.",
+                argv[0]);
+        return 2;
+    }
+
+    /* Read and discard standard input */
+    while (getchar() != EOF);
+
+    /* Print output string to stdout and exit with error code */
+    char *output_string = (char *) malloc((OUTPUT_SIZE + 2) * sizeof(char));
+    memset(output_string, '1', OUTPUT_SIZE);
+    output_string[OUTPUT_SIZE] = '\n';
+    output_string[OUTPUT_SIZE + 1] = '\0';
+
+    fputs(output_string, stdout);
+    free(output_string);
+    return error_code;
+}
@@ -0,0 +1,21 @@
+#!/bin/bash
+set -euo pipefail
+
+# Process arguments
+if [ $# -lt 1 ]
+then
+    echo "Usage: $0 COMMAND [ARGUMENTS...]" 1>&2
+    echo "Runs command in a new temporary directory, which is removed" 1>&2
+    echo "afterwards, so that simulators can share files with each other" 1>&2
+    exit 1
+fi
+
+# Create temporary directory
+temp_dir=$(mktemp -d)
+
+# Ensure temporary directory is cleaned up
+trap "rm -rf $temp_dir" EXIT
+
+# Run command
+cd $temp_dir
+"$@"